@@ -0,0 +1,34 @@
+#version 330 core
+#include "#ASSET_DIR/Shaders/Include/PBR.inc"
+#include "#ASSET_DIR/Shaders/Include/GBuffer.inc"
+
+out vec4 FragColour;
+
+flat in int LightIndex;
+
+uniform sampler2D inputDepth;
+uniform sampler2D inputNormal;
+uniform sampler2D inputAlbedoMetalness;
+uniform sampler2D inputRoughnessFlags;
+
+void main()
+{
+	vec2 texCoords = gl_FragCoord.xy / resolution;
+
+	vec2 roughnessFlags = texture(inputRoughnessFlags, texCoords).rg;
+	if((DecodeFlags(roughnessFlags.g) & GBUFFER_FLAG_GEOMETRY) == 0)
+		discard;
+
+	vec4 albedoMetalness = texture(inputAlbedoMetalness, texCoords);
+
+	PBRInput input;
+
+	input.Albedo = albedoMetalness.rgb;
+	input.Normals = DecodeNormal(texture(inputNormal, texCoords).rg);
+	input.Metalness = albedoMetalness.a;
+	input.WorldPos = ReconstructWorldPos(texCoords, texture(inputDepth, texCoords).r);
+	input.Roughness = roughnessFlags.r;
+
+	vec3 viewDir = normalize(camera.Position - input.WorldPos);
+	FragColour = vec4(PBRLight(GetLight(LightIndex), input, viewDir, PBRBaseReflectivity(input)), 1.0);
+}
\ No newline at end of file
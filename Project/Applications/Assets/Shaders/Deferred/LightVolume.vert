@@ -0,0 +1,33 @@
+#version 330 core
+#include "#ASSET_DIR/Shaders/Include/Light.inc"
+
+layout(location = 0) in vec3 position;
+
+// Index of the first light drawn by this call, one instance per light
+uniform int lightOffset;
+
+flat out int LightIndex;
+
+void main()
+{
+	LightIndex = lightOffset + gl_InstanceID;
+	Light light = GetLight(LightIndex);
+
+	vec3 worldPos;
+	if(light.Type == LIGHT_SPOT)
+	{
+		// Unit cone with apex at origin, facing +Z
+		vec3 forward = normalize(light.Direction);
+		vec3 up = abs(forward.y) < 0.99 ? vec3(0, 1, 0) : vec3(1, 0, 0);
+		vec3 right = normalize(cross(up, forward));
+		up = cross(forward, right);
+
+		float baseRadius = light.Distance * tan(radians(min(light.Radius, 89.0)));
+		vec3 scaled = vec3(position.xy * baseRadius, position.z * light.Distance);
+		worldPos = light.Position + right * scaled.x + up * scaled.y + forward * scaled.z;
+	}
+	else // Point light, unit sphere
+		worldPos = light.Position + position * light.Radius;
+
+	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * vec4(worldPos, 1.0);
+}
\ No newline at end of file
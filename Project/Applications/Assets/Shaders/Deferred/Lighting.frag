@@ -1,6 +1,7 @@
 #version 330 core
 #include "#ASSET_DIR/Shaders/Include/PBR.inc"
 #include "#ASSET_DIR/Shaders/Include/Denoise.inc"
+#include "#ASSET_DIR/Shaders/Include/GBuffer.inc"
 #include "#ASSET_DIR/Shaders/Include/Material.inc"
 
 out vec4 FragColour;
@@ -8,23 +9,26 @@ out vec4 FragColour;
 in vec2 TexCoords;
 
 uniform sampler2D inputDepth;
-uniform sampler2D inputAlbedo;
-uniform sampler2D inputNormalMetalness;
-uniform sampler2D inputPositionRoughness;
+uniform sampler2D inputNormal;
+uniform sampler2D inputAlbedoMetalness;
+uniform sampler2D inputRoughnessFlags;
 
 void main()
 {
-	vec3 albedo = texture(inputAlbedo, TexCoords).rgb;
-	vec4 normalMetalness = texture(inputNormalMetalness, TexCoords);
-	vec4 positionRoughness = texture(inputPositionRoughness, TexCoords);
+	vec2 roughnessFlags = texture(inputRoughnessFlags, TexCoords).rg;
+	if((DecodeFlags(roughnessFlags.g) & GBUFFER_FLAG_GEOMETRY) == 0)
+		discard; // Skybox is drawn in the forward pass
+
+	vec4 albedoMetalness = texture(inputAlbedoMetalness, TexCoords);
 
 	PBRInput input;
 
-	input.Albedo = albedo;
-	input.Normals = normalMetalness.rgb;
-	input.Metalness = normalMetalness.a;
-	input.WorldPos = positionRoughness.rgb;
-	input.Roughness = positionRoughness.a;
+	input.Albedo = albedoMetalness.rgb;
+	input.Normals = DecodeNormal(texture(inputNormal, TexCoords).rg);
+	input.Metalness = albedoMetalness.a;
+	input.WorldPos = ReconstructWorldPos(TexCoords, texture(inputDepth, TexCoords).r);
+	input.Roughness = roughnessFlags.r;
 
-	FragColour = vec4(PBRLighting(input), 1.0);
+	// Point & spot lights are added by light volumes
+	FragColour = vec4(PBRDirectionalLighting(input), 1.0);
 }
\ No newline at end of file
@@ -5,17 +5,20 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normals;
 layout(location = 2) in vec2 texCoords;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
+layout(location = 3) in vec4 tangent; // w is bitangent sign in compact vertex formats
+layout(location = 4) in vec3 bitangent; // Zero in compact vertex formats
 
 // x = Albedo Map
 // y = Normal Map
 // z = Roughness Map
 // w = Metalness Map
 layout(location = 5) in vec4 TextureIndices;
-// layout(location = 6) in mat4 ModelMatrix;
+
+// Per-instance model matrix, read instead of modelMatrix when drawing indirectly
+layout(location = 6) in mat4 instanceModelMatrix;
 
 uniform mat4 modelMatrix;
+uniform bool instanced = false;
 
 #if #SUPPORTS_TESSELLATION
 #define TBN_NAME TBN_Tess
@@ -36,9 +39,10 @@ out vec4 TEXINDICES_NAME;
 
 void main()
 {
-	mat4 ModelMatrix = modelMatrix;
-	vec3 T = normalize(vec3(ModelMatrix * vec4(tangent,   0.0)));
-	vec3 B = normalize(vec3(ModelMatrix * vec4(bitangent, 0.0)));
+	mat4 ModelMatrix = instanced ? instanceModelMatrix : modelMatrix;
+	vec3 T = normalize(vec3(ModelMatrix * vec4(tangent.xyz, 0.0)));
+	vec3 bitangentDir = dot(bitangent, bitangent) > 0.0 ? bitangent : cross(normals, tangent.xyz) * (tangent.w < 0.0 ? -1.0 : 1.0);
+	vec3 B = normalize(vec3(ModelMatrix * vec4(bitangentDir, 0.0)));
 	vec3 N = normalize(vec3(ModelMatrix * vec4(normals,   0.0)));
 	TBN_NAME = mat3(T, B, N);
 
@@ -47,6 +51,6 @@ void main()
 	TEXCOORDS_NAME = (texCoords * material.TextureCoordScale) + material.TextureCoordOffset;
 
 #if !#SUPPORTS_TESSELLATION
-	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * modelMatrix * vec4(position, 1.0);
+	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * ModelMatrix * vec4(position, 1.0);
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330 core
+#include "#ASSET_DIR/Shaders/Include/Material.inc"
+
+in vec2 TexCoords;
+
+void main()
+{
+	// Depth only, clipped pixels must not occlude the colour pass
+	if(material.AlphaClipping &&
+		(material.AlbedoColour.a * texture(materialMaps.AlbedoMap, TexCoords).a) <= material.AlphaClipThreshold)
+		discard;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#version 330 core
+#include "#ASSET_DIR/Shaders/Include/Camera.inc"
+#include "#ASSET_DIR/Shaders/Include/Material.inc"
+
+layout(location = 0) in vec3 position;
+layout(location = 2) in vec2 texCoords;
+
+// Per-instance model matrix, read instead of modelMatrix when drawing indirectly
+layout(location = 6) in mat4 instanceModelMatrix;
+
+uniform mat4 modelMatrix;
+uniform bool instanced = false;
+
+out vec2 TexCoords;
+
+// Must exactly match depth written by Forward/Mesh.vert, which is drawn with GL_EQUAL afterwards
+invariant gl_Position;
+
+void main()
+{
+	mat4 ModelMatrix = instanced ? instanceModelMatrix : modelMatrix;
+
+	// Only read by alpha clipped materials
+	TexCoords = (texCoords * material.TextureCoordScale) + material.TextureCoordOffset;
+
+	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * ModelMatrix * vec4(position, 1.0);
+}
\ No newline at end of file
@@ -16,8 +16,7 @@ void main()
 	input.Normals = TBN[2];
 	if(material.HasNormalMap)
 	{
-		input.Normals = texture(material.NormalMap, TexCoords).rgb;
-		input.Normals = input.Normals * 2.0 - 1.0; // Remap to range [-1, 1]
+		input.Normals = SampleNormalMap(TexCoords);
 		input.Normals = normalize(TBN * input.Normals); // Tangent-to-World space
 	}
 
@@ -25,14 +24,14 @@ void main()
 	input.WorldPos = WorldPos;
 
 	// Albedo
-	vec4 albedo = material.AlbedoColour * texture(material.AlbedoMap, TexCoords);
+	vec4 albedo = material.AlbedoColour * texture(materialMaps.AlbedoMap, TexCoords);
 	input.Albedo = albedo.rgb;
 
 	// Metalness
-	input.Metalness = material.Metalness * texture(material.MetalnessMap, TexCoords).r;
+	input.Metalness = material.Metalness * texture(materialMaps.MetalnessMap, TexCoords).r;
 
 	// Roughness
-	input.Roughness = material.Roughness * texture(material.RoughnessMap, TexCoords).r;
+	input.Roughness = material.Roughness * texture(materialMaps.RoughnessMap, TexCoords).r;
 
 	// Calculate lighting
 	FragColour.rgb = PBRLighting(input);
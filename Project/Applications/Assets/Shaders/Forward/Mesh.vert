@@ -5,8 +5,8 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normals;
 layout(location = 2) in vec2 texCoords;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
+layout(location = 3) in vec4 tangent; // w is bitangent sign in compact vertex formats
+layout(location = 4) in vec3 bitangent; // Zero in compact vertex formats
 
 // x = Albedo Map
 // y = Normal Map
@@ -31,20 +31,29 @@ out vec3 WORLDPOS_NAME;
 out vec2 TEXCOORDS_NAME;
 out vec4 TEXTUREINDEX_NAME;
 
+// Per-instance model matrix, read instead of modelMatrix when drawing indirectly
+layout(location = 6) in mat4 instanceModelMatrix;
+
 uniform mat4 modelMatrix;
+uniform bool instanced = false;
+
+// Depth must exactly match the depth pre-pass, see Forward/DepthPrepass.vert
+invariant gl_Position;
 
 void main()
 {
-	vec3 T = normalize(vec3(modelMatrix * vec4(tangent,   0.0)));
-	vec3 B = normalize(vec3(modelMatrix * vec4(bitangent, 0.0)));
-	vec3 N = normalize(vec3(modelMatrix * vec4(normals,   0.0)));
+	mat4 ModelMatrix = instanced ? instanceModelMatrix : modelMatrix;
+	vec3 T = normalize(vec3(ModelMatrix * vec4(tangent.xyz, 0.0)));
+	vec3 bitangentDir = dot(bitangent, bitangent) > 0.0 ? bitangent : cross(normals, tangent.xyz) * (tangent.w < 0.0 ? -1.0 : 1.0);
+	vec3 B = normalize(vec3(ModelMatrix * vec4(bitangentDir, 0.0)));
+	vec3 N = normalize(vec3(ModelMatrix * vec4(normals,   0.0)));
 	TBN_NAME = mat3(T, B, N);
 
 	TEXTUREINDEX_NAME = TextureIndices;
-	WORLDPOS_NAME = vec3(modelMatrix * vec4(position, 1.0));
+	WORLDPOS_NAME = vec3(ModelMatrix * vec4(position, 1.0));
 	TEXCOORDS_NAME = (texCoords * material.TextureCoordScale) + material.TextureCoordOffset;
 
 #if !#SUPPORTS_TESSELLATION
-	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * modelMatrix * vec4(position, 1.0);
+	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * ModelMatrix * vec4(position, 1.0);
 #endif
 }
\ No newline at end of file
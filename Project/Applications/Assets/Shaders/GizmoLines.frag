@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColour;
+
+in vec4 Colour;
+
+void main()
+{
+	FragColour = Colour;
+}
\ No newline at end of file
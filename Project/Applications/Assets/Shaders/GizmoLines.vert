@@ -0,0 +1,13 @@
+#version 330 core
+#include "#ASSET_DIR/Shaders/Include/Camera.inc"
+
+layout(location = 0) in vec3 position; // World space
+layout(location = 1) in vec4 colour;
+
+out vec4 Colour;
+
+void main()
+{
+	gl_Position = camera.ProjectionMatrix * camera.ViewMatrix * vec4(position, 1.0);
+	Colour = colour;
+}
\ No newline at end of file
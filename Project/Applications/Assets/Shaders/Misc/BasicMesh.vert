@@ -5,8 +5,8 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normals;
 layout(location = 2) in vec2 texCoords;
-layout(location = 3) in vec3 tangent;
-layout(location = 4) in vec3 bitangent;
+layout(location = 3) in vec4 tangent; // w is bitangent sign in compact vertex formats
+layout(location = 4) in vec3 bitangent; // Zero in compact vertex formats
 
 out mat3 TBN; // Tangent, Bitangent, Normal
 out vec3 WorldPos;
@@ -16,8 +16,9 @@ uniform mat4 modelMatrix;
 
 void main()
 {
-	vec3 T = normalize(vec3(modelMatrix * vec4(tangent,   0.0)));
-	vec3 B = normalize(vec3(modelMatrix * vec4(bitangent, 0.0)));
+	vec3 T = normalize(vec3(modelMatrix * vec4(tangent.xyz, 0.0)));
+	vec3 bitangentDir = dot(bitangent, bitangent) > 0.0 ? bitangent : cross(normals, tangent.xyz) * (tangent.w < 0.0 ? -1.0 : 1.0);
+	vec3 B = normalize(vec3(modelMatrix * vec4(bitangentDir, 0.0)));
 	vec3 N = normalize(vec3(modelMatrix * vec4(normals,   0.0)));
 	TBN = mat3(T, B, N);
 
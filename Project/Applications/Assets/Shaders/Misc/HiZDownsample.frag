@@ -0,0 +1,26 @@
+#version 330 core
+out float Depth;
+
+in vec2 TexCoords;
+
+uniform sampler2D inputDepth; // Scene depth, or the previous pyramid level
+uniform vec2 inputSize;
+uniform vec2 outputSize;
+
+// Keeps the farthest depth of all input texels overlapped by this output texel,
+// up to several per axis when the input isn't exactly twice the size of the output
+void main()
+{
+	ivec2 coord = ivec2(gl_FragCoord.xy);
+	ivec2 sourceSize = ivec2(inputSize);
+	ivec2 targetSize = ivec2(outputSize);
+
+	ivec2 first = (coord * sourceSize) / targetSize;
+	ivec2 last = min(((coord + 1) * sourceSize + targetSize - 1) / targetSize - 1, sourceSize - 1);
+
+	float depth = 0.0;
+	for (int y = first.y; y <= last.y; y++)
+		for (int x = first.x; x <= last.x; x++)
+			depth = max(depth, texelFetch(inputDepth, ivec2(x, y), 0).r);
+	Depth = depth;
+}
\ No newline at end of file
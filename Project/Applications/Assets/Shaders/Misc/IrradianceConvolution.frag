@@ -1,39 +0,0 @@
-#version 400 core
-
-out vec4 FragColour;
-
-in vec3 WorldPos;
-
-uniform samplerCube environmentMap;
-
-const float PI = 3.14159265359;
-
-void main()
-{
-	vec3 normal = normalize(WorldPos);
-
-	vec3 irradiance = vec3(0);
-
-	vec3 up 	= vec3(0, 1, 0);
-	vec3 right 	= normalize(cross(up, normal));
-	up 			= normalize(cross(normal, right));
-
-	float sampleDelta = 0.02;
-	float sampleCount = 0.0;
-	for(float phi = 0.0; phi < 2.0 * PI; phi += sampleDelta)
-	{
-		for(float theta = 0.0; theta < 0.5 * PI; theta += sampleDelta)
-		{
-			vec3 tangentSample = vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
-			vec3 sampleVec = tangentSample.x * right + 
-								tangentSample.y * up +
-								tangentSample.z * normal;
-
-			irradiance += texture(environmentMap, sampleVec).rgb * cos(theta) * sin(theta);
-			sampleCount++;
-		}
-	}
-	irradiance = PI * irradiance * (1.0 / float(sampleCount));
-
-	FragColour = vec4(irradiance, 1.0);
-}
\ No newline at end of file
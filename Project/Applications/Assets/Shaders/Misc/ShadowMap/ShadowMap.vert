@@ -3,8 +3,9 @@
 layout(location = 0) in vec3 position;
 
 uniform mat4 modelMatrix;
+uniform mat4 lightSpaceMatrix;
 
 void main()
 {
-	gl_Position = modelMatrix * vec4(position, 1.0);
+	gl_Position = lightSpaceMatrix * modelMatrix * vec4(position, 1.0);
 }
\ No newline at end of file
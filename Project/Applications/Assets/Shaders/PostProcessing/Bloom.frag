@@ -1,15 +1,15 @@
 #version 330 core
-#include "#ASSET_DIR/Shaders/Include/Tonemap.inc"
-
 out vec4 FragColour;
 
 in vec2 TexCoords;
 
-uniform sampler2D input;
+uniform sampler2D inputTexture;
+uniform sampler2D bloomTexture; // First level of the bloom chain, half resolution
+uniform float intensity = 0.3;
 
 void main()
 {
-	vec3 colour = texture(input, TexCoords).rgb;
-	// TODO: Bloom
-	FragColour = vec4(colour, 1.0);
+	vec3 colour = texture(inputTexture, TexCoords).rgb;
+	vec3 bloom = texture(bloomTexture, TexCoords).rgb;
+	FragColour = vec4(colour + bloom * intensity, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#version 330 core
+out vec4 FragColour;
+
+in vec2 TexCoords;
+
+uniform sampler2D inputTexture;
+uniform vec2 texelSize; // Of inputTexture
+uniform bool firstLevel = false;
+uniform float threshold = 1.0;
+
+float Luminance(vec3 colour) { return dot(colour, vec3(0.2126, 0.7152, 0.0722)); }
+
+// Weighted average of a 2x2 box, bright texels are weighted down to avoid flickering fireflies (Karis 2013)
+vec3 KarisAverage(vec3 a, vec3 b, vec3 c, vec3 d, out float weight)
+{
+	vec3 average = (a + b + c + d) * 0.25;
+	weight = 1.0 / (1.0 + Luminance(average));
+	return average * weight;
+}
+
+// 13 tap downsample of five overlapping boxes (Jimenez 2014, "Next Generation Post Processing in Call of Duty: Advanced Warfare")
+void main()
+{
+	vec3 a = texture(inputTexture, TexCoords + texelSize * vec2(-2.0,  2.0)).rgb;
+	vec3 b = texture(inputTexture, TexCoords + texelSize * vec2( 0.0,  2.0)).rgb;
+	vec3 c = texture(inputTexture, TexCoords + texelSize * vec2( 2.0,  2.0)).rgb;
+	vec3 d = texture(inputTexture, TexCoords + texelSize * vec2(-2.0,  0.0)).rgb;
+	vec3 e = texture(inputTexture, TexCoords).rgb;
+	vec3 f = texture(inputTexture, TexCoords + texelSize * vec2( 2.0,  0.0)).rgb;
+	vec3 g = texture(inputTexture, TexCoords + texelSize * vec2(-2.0, -2.0)).rgb;
+	vec3 h = texture(inputTexture, TexCoords + texelSize * vec2( 0.0, -2.0)).rgb;
+	vec3 i = texture(inputTexture, TexCoords + texelSize * vec2( 2.0, -2.0)).rgb;
+	vec3 j = texture(inputTexture, TexCoords + texelSize * vec2(-1.0,  1.0)).rgb;
+	vec3 k = texture(inputTexture, TexCoords + texelSize * vec2( 1.0,  1.0)).rgb;
+	vec3 l = texture(inputTexture, TexCoords + texelSize * vec2(-1.0, -1.0)).rgb;
+	vec3 m = texture(inputTexture, TexCoords + texelSize * vec2( 1.0, -1.0)).rgb;
+
+	vec3 colour;
+	if(!firstLevel)
+		colour = e * 0.125 +
+				 (a + c + g + i) * 0.03125 +
+				 (b + d + f + h) * 0.0625 +
+				 (j + k + l + m) * 0.125;
+	else
+	{
+		float centreWeight, weight0, weight1, weight2, weight3;
+		colour = KarisAverage(j, k, l, m, centreWeight) * 0.5 +
+				 KarisAverage(a, b, d, e, weight0) * 0.125 +
+				 KarisAverage(b, c, e, f, weight1) * 0.125 +
+				 KarisAverage(d, e, g, h, weight2) * 0.125 +
+				 KarisAverage(e, f, h, i, weight3) * 0.125;
+		colour /= centreWeight * 0.5 + (weight0 + weight1 + weight2 + weight3) * 0.125;
+
+		// Only light brighter than threshold contributes, hue is kept
+		float brightness = max(colour.r, max(colour.g, colour.b));
+		colour *= max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+	}
+
+	FragColour = vec4(colour, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 330 core
+out vec4 FragColour;
+
+in vec2 TexCoords;
+
+uniform sampler2D inputTexture;
+uniform vec2 texelSize; // Of inputTexture
+uniform float radius = 1.0; // In texels of inputTexture
+
+// 3x3 tent filter, added to the larger level being drawn to
+void main()
+{
+	vec2 offset = texelSize * radius;
+
+	vec3 colour = texture(inputTexture, TexCoords).rgb * 4.0;
+
+	colour += texture(inputTexture, TexCoords + vec2(-offset.x, 0.0)).rgb * 2.0;
+	colour += texture(inputTexture, TexCoords + vec2( offset.x, 0.0)).rgb * 2.0;
+	colour += texture(inputTexture, TexCoords + vec2(0.0, -offset.y)).rgb * 2.0;
+	colour += texture(inputTexture, TexCoords + vec2(0.0,  offset.y)).rgb * 2.0;
+
+	colour += texture(inputTexture, TexCoords + vec2(-offset.x, -offset.y)).rgb;
+	colour += texture(inputTexture, TexCoords + vec2( offset.x, -offset.y)).rgb;
+	colour += texture(inputTexture, TexCoords + vec2(-offset.x,  offset.y)).rgb;
+	colour += texture(inputTexture, TexCoords + vec2( offset.x,  offset.y)).rgb;
+
+	FragColour = vec4(colour / 16.0, 1.0);
+}
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <Engine/Graphics/Passes/Skybox.hpp>
 #include <Engine/Services/ExternalService.hpp>
 #include <Engine/Graphics/Passes/ShadowMap.hpp>
+#include <Engine/Graphics/OcclusionCulling.hpp>
 #include <Engine/Graphics/Pipelines/Forward.hpp>
 #include <Engine/Graphics/Pipelines/Deferred.hpp>
 #include <Engine/Components/Physics/Rigidbody.hpp>
@@ -102,6 +103,7 @@ const string FloorMetalnessMapPath = "Textures/Rusted Iron/rustediron2_metallic.
 Material* FloorMaterial;
 
 // Post Processing
+BloomPass* PP_Bloom;
 TonemappingPass* PP_Tonemapping;
 
 #if _WIN32
@@ -141,7 +143,9 @@ void Demo::OnStart()
 
 #if CERBERUS
 	CerberusModel = ResourceManager::Load<Model>(appDir + CerberusModelPath);
-	CerberusNormalMap = ResourceManager::Load<Texture>(appDir + CerberusNormalMapPath);
+	TextureArgs normalMapArgs;
+	normalMapArgs.NormalMap = true;
+	CerberusNormalMap = ResourceManager::Load<Texture>(appDir + CerberusNormalMapPath, normalMapArgs);
 	CerberusMetalnessMap = ResourceManager::Load<Texture>(appDir + CerberusMetalnessMapPath);
 	CerberusRoughnessMap = ResourceManager::Load<Texture>(appDir + CerberusRoughnessMapPath);
 
@@ -154,7 +158,8 @@ void Demo::OnStart()
 #endif
 
 #if SPONZA
-	SponzaModel = ResourceManager::Load<Model>(appDir + SponzaModelPath);
+	// Shown as a placeholder until loaded
+	SponzaModel = Model::LoadAsync(appDir + SponzaModelPath);
 #endif
 
 	EnvMapData.resize(EnvironmentMaps.size());
@@ -172,6 +177,7 @@ void Demo::OnStart()
 
 void Demo::OnShutdown()
 {
+	delete PP_Bloom;
 	delete PP_Tonemapping;
 
 #if DRAW_GRID
@@ -195,6 +201,12 @@ void Demo::OnShutdown()
 
 void Demo::OnPipelineChanged(RenderPipeline* pipeline)
 {
+	// Bloom, applied to HDR colour before tonemapping
+	if (!PP_Bloom)
+		PP_Bloom = new BloomPass();
+
+	pipeline->AddPass(PP_Bloom->GetPipelinePass());
+
 	// Tonemapping
 	if (!PP_Tonemapping)
 		PP_Tonemapping = new TonemappingPass();
@@ -583,6 +595,24 @@ void Demo::OnDraw()
 		ImGui::DragFloat("Gamma", &PP_Tonemapping->Gamma, 0.05f, 1.0f, 3.0f);
 		ImGui::DragFloat("Exposure", &PP_Tonemapping->Exposure, 0.05f, 0.1f, 2.5f);
 
+		ImGui::DragFloat("Bloom Threshold", &PP_Bloom->Threshold, 0.05f, 0.0f, 10.0f);
+		ImGui::DragFloat("Bloom Intensity", &PP_Bloom->Intensity, 0.01f, 0.0f, 2.0f);
+		ImGui::DragFloat("Bloom Radius", &PP_Bloom->Radius, 0.05f, 0.5f, 3.0f);
+
+		if (!DeferredRenderer)
+			ImGui::Checkbox("Depth Pre-pass", &((ForwardRenderPipeline*)Renderer::GetPipeline())->EnableDepthPrepass);
+		else
+		{
+			OcclusionCulling* occlusion = Renderer::GetPipeline()->GetOcclusionCulling();
+			bool occlusionCulling = occlusion->GetEnabled();
+			if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling))
+				occlusion->SetEnabled(occlusionCulling);
+
+			bool computeCulling = occlusion->GetComputeCulling();
+			if (occlusionCulling && Renderer::SupportsCompute() && ImGui::Checkbox("GPU Occlusion Culling", &computeCulling))
+				occlusion->SetComputeCulling(computeCulling);
+		}
+
 		static int ShadowMapResIndex = 1; // Hardcoded default value in RenderPipeline.cpp is 1024x1024
 		static const char* ShadowMapResNames[] = { "512x512", "1024x1024", "2048x2048", "4096x4096", "8192x8192" };
 		static glm::vec2 ShadowMapResolutions[] = { { 512, 512 }, { 1024, 1024 }, { 2048, 2048 }, { 4096, 4096 }, { 8192, 8192 } };
@@ -0,0 +1,35 @@
+#include <string>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/EnvironmentBaker.hpp>
+
+using namespace std;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+/// <summary>
+/// Bakes the image based lighting cache of an environment map, without creating a window or graphics context.
+/// Usage: EnvironmentBaker <background> [reflection]
+/// </summary>
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		Log::Error("Usage: EnvironmentBaker <background> [reflection]");
+		return 1;
+	}
+
+	EnvironmentMapArgs args;
+	args.Background = argv[1];
+	if (argc > 2)
+		args.Reflection = argv[2];
+
+	Log::Info("Baking '" + args.Background + "'");
+	if (!EnvironmentBaker::BakeToCache(args))
+	{
+		Log::Error("Failed to bake '" + args.Background + "'");
+		return 1;
+	}
+
+	Log::Info("Wrote '" + IBLCache::GetPath(args.Background) + "'");
+	return 0;
+}
\ No newline at end of file
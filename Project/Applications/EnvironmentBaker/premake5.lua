@@ -0,0 +1,6 @@
+CreateEngineApp "Environment Baker"
+
+-- Run from build scripts without a window, including release builds
+filter { "system:windows", "configurations:Release" }
+	kind "ConsoleApp"
+filter {}
\ No newline at end of file
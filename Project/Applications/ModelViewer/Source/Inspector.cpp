@@ -123,7 +123,11 @@ void MV::DrawHierarchy(GameObject* go)
 					valueChanged = ImGui::InputText("Normal Map", &normalMapPath, ImGuiInputTextFlags_EnterReturnsTrue);
 					ImGui::SameLine();
 					if (ImGui::Button("->") || valueChanged)
-						meshInfo.Material.NormalMap = ResourceManager::LoadNamed<Texture>(normalMapPath, Application::AssetDir + normalMapPath);
+					{
+						TextureArgs normalMapArgs;
+						normalMapArgs.NormalMap = true;
+						meshInfo.Material.NormalMap = ResourceManager::LoadNamed<Texture>(normalMapPath, Application::AssetDir + normalMapPath, normalMapArgs);
+					}
 
 					// Roughness Map
 					string roughnessMapPath = GetMapPath(meshInfo.Material.RoughnessMap);
@@ -11,6 +11,7 @@
 #include <Engine/Scene.hpp> // Holds game objects & state
 
 #include <Engine/ResourceManager.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
 #include <Engine/Services/Service.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 
@@ -72,6 +73,7 @@ namespace Engine
 		Graphics::Renderer* m_Renderer;
 		ImGuiContext* m_ImGuiContext = nullptr;
 		ResourceManager* m_ResourceManager = nullptr;
+		Jobs::JobSystem* m_JobSystem = nullptr;
 
 		bool m_MouseShowing = true;
 		ENGINE_API static Application* s_Instance;
@@ -7,6 +7,26 @@
 
 namespace Engine::Components
 {
+	/// <summary>
+	/// Camera data laid out to match the std140 'CameraData' uniform block in Camera.inc
+	/// </summary>
+	struct CameraUniformBlock
+	{
+		glm::mat4 ViewMatrix;
+		glm::mat4 ProjectionMatrix;
+
+		/// <summary>
+		/// Transforms clip space to world space, e.g. to reconstruct positions from depth
+		/// </summary>
+		glm::mat4 InverseViewProjectionMatrix;
+
+		glm::vec3 Position;
+		float NearPlane;
+		float FarPlane;
+
+		float Padding[3];
+	};
+
 	struct Camera : public Component
 	{
 		/// <summary>
@@ -25,7 +45,7 @@ namespace Engine::Components
 		ENGINE_API glm::mat4 GetViewMatrix();
 		ENGINE_API glm::mat4 GetProjectionMatrix();
 		
-		ENGINE_API void FillShader(Graphics::Shader* shader);
+		ENGINE_API void FillUniformBlock(CameraUniformBlock& block);
 
 		ENGINE_API void SetMainCamera();
 		ENGINE_API static Camera* GetMainCamera();
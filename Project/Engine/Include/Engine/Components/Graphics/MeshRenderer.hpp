@@ -13,10 +13,18 @@ namespace Engine::Components
 		{
 			ResourceID Mesh = InvalidResourceID;
 			Graphics::Material Material = {};
+
+			/// <summary>
+			/// Level of detail selected when last drawn, see Mesh::SelectLOD
+			/// </summary>
+			unsigned int LOD = 0;
 		};
 
 		std::vector<MeshInfo> Meshes;
 
+		/// <returns>Mesh for the currently selected level of detail of meshInfo</returns>
+		ENGINE_API static ResourceID GetLODMesh(MeshInfo& meshInfo);
+
 	protected:
 		ENGINE_API void Draw() override;
 	};
@@ -0,0 +1,29 @@
+#pragma once
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/Model.hpp>
+#include <Engine/Graphics/Material.hpp>
+#include <Engine/Components/Component.hpp>
+
+namespace Engine::Components
+{
+	/// <summary>
+	/// Draws a wireframe cube in place of a model that is still loading.
+	/// Added by Model::CreateEntity, replaced by the model's hierarchy once loaded.
+	/// </summary>
+	class ModelPlaceholder : public Component
+	{
+		Graphics::Model* m_Model = nullptr;
+		Graphics::Material m_Material;
+
+		friend class Engine::Graphics::Model;
+
+	protected:
+		ENGINE_API void Added() override;
+		ENGINE_API void Removed() override;
+		ENGINE_API void Draw() override;
+
+	public:
+		/// <returns>Model being loaded, or nullptr if it was unloaded</returns>
+		ENGINE_API Graphics::Model* GetModel();
+	};
+}
\ No newline at end of file
@@ -4,8 +4,6 @@
 #include <Engine/Components/Component.hpp>
 #include <Engine/Graphics/RenderTexture.hpp>
 
-namespace Engine::Graphics { class Shader; } // Forward declaration
-
 namespace Engine::Components
 {
 	enum class ENGINE_API LightType
@@ -15,6 +13,28 @@ namespace Engine::Components
 		Directional
 	};
 
+	/// <summary>
+	/// Light data laid out to match the std140 'Light' struct in Light.inc
+	/// </summary>
+	struct LightUniformData
+	{
+		glm::vec3 Position;
+		float Radius;
+
+		glm::vec3 Colour;
+		float Intensity;
+
+		glm::vec3 Direction;
+		float Distance;
+
+		int Type;
+		int CastShadows;
+		float FadeCutoffInner;
+		int ShadowMapIndex;
+
+		glm::mat4 LightSpaceMatrix;
+	};
+
 	struct Light : public Component
 	{
 		LightType Type = LightType::Point;
@@ -34,7 +54,7 @@ namespace Engine::Components
 		/// <summary>
 		/// Point lights		- No effect							<para/>
 		/// Spot lights			- Reach, from light origin			<para/>
-		/// Directional lights	- Size of orthographic projection	<para />
+		/// Directional lights	- Distance from camera shadows are drawn to, split between cascades	<para />
 		/// </summary>
 		float Distance = 10.0f;
 
@@ -47,7 +67,7 @@ namespace Engine::Components
 
 		ENGINE_API bool GetCastShadows();
 		ENGINE_API void SetCastShadows(bool canCast);
-		ENGINE_API void FillShader(unsigned int lightIndex, Engine::Graphics::Shader* shader);
+		ENGINE_API void FillUniformData(LightUniformData& data);
 
 	private:
 		bool m_CastShadows = false;
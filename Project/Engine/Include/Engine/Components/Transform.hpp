@@ -37,6 +37,11 @@ namespace Engine::Components
 
 		ENGINE_API void FillShader(Engine::Graphics::Shader* shader);
 
+		/// <summary>
+		/// Incremented each time the model matrix is recalculated, used to detect movement
+		/// </summary>
+		ENGINE_API unsigned int GetVersion();
+
 		/// <summary>
 		/// Recalculates global & direction values when required
 		/// </summary>
@@ -51,6 +56,7 @@ namespace Engine::Components
 		std::vector<Transform*> m_Children;
 
 		bool m_Dirty;
+		unsigned int m_Version = 0;
 		glm::mat4 m_ModelMatrix;
 		glm::vec3 m_LastPos, m_LastRot, m_LastScale;
 
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/IBLCache.hpp>
+#include <Engine/Graphics/EnvironmentMap.hpp>
+
+namespace Engine::Graphics
+{
+	struct EnvironmentBakeSettings
+	{
+		/// <summary>
+		/// Face resolution of the background & reflection cubemaps
+		/// </summary>
+		unsigned int CubemapResolution = 512;
+
+		/// <summary>
+		/// Face resolution of the first pre-filtered level, each level up to PreFilterMipCount halves resolution & raises roughness
+		/// </summary>
+		unsigned int PreFilterResolution = 256;
+		unsigned int PreFilterMipCount = 5;
+		unsigned int PreFilterSamples = 512;
+
+		unsigned int BRDFResolution = 256;
+		unsigned int BRDFSamples = 1024;
+	};
+
+	/// <summary>
+	/// Produces the image based lighting textures of an environment map on the CPU, without a graphics context.
+	/// Texels are split across worker threads, creating a job system when run outside of an application.
+	/// </summary>
+	class EnvironmentBaker
+	{
+	public:
+		/// <summary>
+		/// Bakes the cubemap, reflection cubemap, irradiance, pre-filtered cubemap & BRDF lookup of args
+		/// </summary>
+		/// <returns>False if an image could not be read</returns>
+		ENGINE_API static bool Bake(EnvironmentMapArgs args, std::vector<IBLCache::Image>& images, EnvironmentBakeSettings settings = {});
+
+		/// <summary>
+		/// Bakes args & writes the cache read by EnvironmentMap, see IBLCache::GetPath
+		/// </summary>
+		ENGINE_API static bool BakeToCache(EnvironmentMapArgs args, EnvironmentBakeSettings settings = {});
+
+		/// <summary>
+		/// Projects the radiance of a cubemap onto L2 spherical harmonics & convolves it with the cosine lobe
+		/// </summary>
+		/// <param name="texels">RGB floats of six square faces, one after another in OpenGL face order</param>
+		/// <param name="resolution">Width & height of a single face</param>
+		ENGINE_API static IrradianceSH ProjectIrradiance(const float* texels, unsigned int resolution);
+	};
+}
\ No newline at end of file
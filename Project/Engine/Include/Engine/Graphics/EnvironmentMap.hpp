@@ -3,6 +3,7 @@
 #include <Engine/Api.hpp>
 #include <Engine/ResourceID.hpp>
 #include <Engine/Graphics/Shader.hpp>
+#include <Engine/Graphics/IBLCache.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
 
 namespace Engine::Graphics
@@ -22,32 +23,57 @@ namespace Engine::Graphics
 		std::string Reflection;
 	};
 
+	/// <summary>
+	/// Diffuse irradiance of an environment as L2 spherical harmonics.
+	/// Coefficients are pre-multiplied by the basis constants, the cosine lobe & 1 / PI, see EvaluateIrradianceSH in PBR.inc.
+	/// </summary>
+	struct IrradianceSH
+	{
+		glm::vec3 Coefficients[9];
+	};
+
+	/// <summary>
+	/// Skybox & image based lighting textures of an equirectangular image.
+	/// Textures are read from an IBLCache when one is found, otherwise they are rendered once & written to the cache.
+	/// </summary>
 	class EnvironmentMap
 	{
+		bool m_Generated;
+		IBLCache m_Cache;
 		glm::ivec2 m_Resolution;
 		EnvironmentMapArgs m_Args;
 		Framebuffer* m_Framebuffer;
 		RenderTexture* m_BRDFTexture;
 		RenderTexture* m_CubemapTexture;
 		RenderTexture* m_PreFilterTexture;
-		RenderTexture* m_IrradianceTexture;
+		IrradianceSH m_IrradianceSH;
 		RenderTexture* m_ReflectionCubemapTexture;
 		ResourceID m_Texture, m_ReflectionTexture;
 		ResourceID m_BRDFShader,
 					m_PreFilterShader,
-					m_EquiToCubeShader,
-					m_IrradianceShader;
+					m_EquiToCubeShader;
 
 		void Generate();
 
+		/// <summary>
+		/// Creates all textures from the opened cache
+		/// </summary>
+		void LoadCache();
+
+		/// <summary>
+		/// Reads back rendered textures & projects irradiance, then writes them to the cache on a worker thread
+		/// </summary>
+		void SaveCache();
+
 	public:
 		ENGINE_API EnvironmentMap(EnvironmentMapArgs maps, glm::ivec2 resolution = { 1024, 1024 });
 		ENGINE_API ~EnvironmentMap();
 
+		/// <returns>Equirectangular background image, InvalidResourceID when textures are read from cache</returns>
 		ENGINE_API ResourceID GetTexture();
 		ENGINE_API RenderTexture* GetBRDF();
 		ENGINE_API RenderTexture* GetCubemap();
-		ENGINE_API RenderTexture* GetIrradianceMap();
+		ENGINE_API IrradianceSH& GetIrradianceSH();
 		ENGINE_API RenderTexture* GetReflectionCubemap();
 		ENGINE_API RenderTexture* GetPrefilteredCubemap();
 	};
@@ -54,6 +54,7 @@ namespace Engine::Graphics
 	{
 		unsigned int m_ID;
 		int m_DesiredSamples;
+		bool m_OwnsAttachments;
 		FramebufferSpec m_Specs;
 
 		RenderTexture* m_DepthAttachment;
@@ -62,9 +63,16 @@ namespace Engine::Graphics
 		void Destroy();
 		void Create();
 		void Recreate(); // Usually called when resized or samples change, attachment count & formats remain constant
+		void AttachExisting();
 
 	public:
 		ENGINE_API Framebuffer(FramebufferSpec& specs);
+
+		/// <summary>
+		/// Draws to existing textures instead of creating attachments, these are not resized or deleted by the framebuffer.
+		/// Resolution is taken from the first attachment.
+		/// </summary>
+		ENGINE_API Framebuffer(std::vector<RenderTexture*> colourAttachments, RenderTexture* depthAttachment = nullptr);
 		ENGINE_API ~Framebuffer();
 
 		ENGINE_API void Bind();
@@ -76,6 +84,12 @@ namespace Engine::Graphics
 		ENGINE_API void CopyAttachmentTo(RenderTexture* destination, unsigned int colourAttachment = 0);
 		ENGINE_API void BlitTo(Framebuffer* other = nullptr, GLbitfield bufferFlags = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST);
 
+		/// <summary>
+		/// Copies a region to the same position in other
+		/// </summary>
+		/// <param name="region">Offset (xy) & size (zw) in pixels</param>
+		ENGINE_API void BlitTo(Framebuffer* other, glm::ivec4 region, GLbitfield bufferFlags = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST);
+
 		ENGINE_API unsigned int GetSamples();
 		ENGINE_API glm::ivec2 GetResolution();
 		ENGINE_API RenderTexture* GetDepthAttachment();
@@ -1,27 +1,80 @@
 #pragma once
+#include <vector>
 #include <glm/glm.hpp>
 #include <Engine/Api.hpp>
 #include <Engine/ResourceID.hpp>
+#include <glad/glad.h>
 #include <Engine/Graphics/Mesh.hpp>
 #include <Engine/Physics/Shapes.hpp>
 #include <Engine/Graphics/Shader.hpp>
 #include <Engine/Graphics/Material.hpp>
 
 namespace Engine { class Application; }
+namespace Engine::Services { struct GizmoService; }
 
 namespace Engine::Graphics
 {
 	class Gizmos
 	{
-		Material m_Material;
+		struct LineVertex
+		{
+			glm::vec3 Position;
+			glm::vec4 Colour;
+		};
+
+		/// <summary>
+		/// Lines of the same width submitted this frame, drawn together by a single call
+		/// </summary>
+		struct LineBatch
+		{
+			float Width;
+			std::vector<LineVertex> Vertices;
+		};
+
 		float m_LineWidth = 1.0f;
+		glm::vec4 m_Colour = { 1, 1, 1, 1 };
+
+		/// <summary>
+		/// Lines, wireframe shapes & grids are accumulated each frame instead of submitted as meshes.
+		/// Batches are kept between frames so their storage is reused.
+		/// </summary>
+		std::vector<LineBatch> m_LineBatches;
+		unsigned int m_LineVAO = GL_INVALID_VALUE, m_LineVBO = GL_INVALID_VALUE;
+		unsigned int m_LineCapacity = 0; // In vertices
+		ResourceID m_LineShader = InvalidResourceID;
+
+		/// <summary>
+		/// Materials used by gizmos this frame, one per colour & wireframe combination.
+		/// Kept between frames so their instances are reused.
+		/// </summary>
+		std::vector<Material> m_Materials;
+		unsigned int m_MaterialsUsed = 0;
 
 		static Gizmos* s_Instance;
 
 		Gizmos();
 		~Gizmos();
 
+		/// <returns>Material instance matching the current colour</returns>
+		static ResourceID GetMaterial();
+
+		/// <summary>
+		/// Marks all materials as available for reuse, called at the start of each gizmo pass
+		/// </summary>
+		static void ResetMaterials();
+
+		/// <summary>
+		/// Appends a line in world space with the current colour & width
+		/// </summary>
+		static void AddLine(glm::vec3 start, glm::vec3 end);
+
+		/// <summary>
+		/// Draws all lines added this frame then clears them, called at the end of each gizmo pass
+		/// </summary>
+		static void DrawLines();
+
 		friend class Application;
+		friend struct Services::GizmoService;
 
 	public:
 		ENGINE_API static void SetLineWidth(float width);
@@ -0,0 +1,133 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <Engine/Api.hpp>
+#include <Engine/MappedFile.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Every face & mip level of the image based lighting textures of an environment map, stored as half floats.
+	/// Cached files are memory mapped & uploaded without being copied.
+	/// 
+	/// Layout is a Header, the ImageEntry table, then the 16 byte aligned levels of each image.
+	/// Each level holds all faces of that level, one after another.
+	/// </summary>
+	class IBLCache
+	{
+	public:
+		enum class Product : uint32_t
+		{
+			Cubemap,
+			ReflectionCubemap,
+			PreFilter,
+
+			/// <summary>
+			/// Nine coefficients of IrradianceSH, a single 9x1 face
+			/// </summary>
+			IrradianceSH,
+
+			/// <summary>
+			/// Split sum BRDF lookup, a two channel 2D texture
+			/// </summary>
+			BRDF
+		};
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+
+			// Source files when baked. Content hashes are only compared when size or write time have changed.
+			uint64_t BackgroundSize;
+			int64_t BackgroundWriteTime;
+			uint64_t BackgroundHash;
+			uint64_t ReflectionSize;
+			int64_t ReflectionWriteTime;
+			uint64_t ReflectionHash;
+
+			uint32_t ImageCount;
+			uint32_t Padding;
+		};
+
+		struct ImageEntry
+		{
+			uint32_t Product;
+			uint32_t FaceCount;
+			uint32_t MipCount;
+			uint32_t ChannelCount;
+			uint32_t Width;
+			uint32_t Height;
+
+			/// <summary>
+			/// Offset of the first level from the start of the file, levels are 16 byte aligned
+			/// </summary>
+			uint64_t Offset;
+		};
+
+		/// <summary>
+		/// Baked image in full precision, converted to half floats when saved
+		/// </summary>
+		struct Image
+		{
+			Product Type = Product::Cubemap;
+			unsigned int FaceCount = 6;
+			unsigned int ChannelCount = 3;
+			unsigned int Width = 0;
+			unsigned int Height = 0;
+
+			/// <summary>
+			/// Faces of each mip level, each level halves resolution
+			/// </summary>
+			std::vector<std::vector<float>> Levels;
+		};
+
+		/// <summary>
+		/// Increment when the layout or any bake changes, older caches are baked again
+		/// </summary>
+		static const uint32_t Version = 2;
+
+	private:
+		MappedFile m_File;
+		const Header* m_Header;
+		const ImageEntry* m_Entries;
+
+		bool Validate(std::string& backgroundPath, std::string& reflectionPath);
+
+	public:
+		ENGINE_API IBLCache();
+
+		IBLCache(const IBLCache&) = delete;
+		IBLCache& operator =(const IBLCache&) = delete;
+
+		/// <summary>
+		/// Maps a cache file, safe to call from any thread
+		/// </summary>
+		/// <param name="reflectionPath">Empty if the environment map has no separate reflection image</param>
+		/// <returns>False if the cache is missing, corrupt, from another version or a source file has changed</returns>
+		ENGINE_API bool Open(std::string cachePath, std::string backgroundPath, std::string reflectionPath);
+		ENGINE_API void Close();
+
+		/// <returns>Entry of product, or nullptr if not stored</returns>
+		ENGINE_API const ImageEntry* GetImage(Product product) const;
+
+		/// <returns>Half float texels of all faces of mip level, pointing into the mapped file</returns>
+		ENGINE_API const uint16_t* GetLevelData(const ImageEntry& image, unsigned int level) const;
+
+		/// <summary>
+		/// Writes images to a new cache, safe to call from any thread
+		/// </summary>
+		ENGINE_API static bool Save(
+			std::string cachePath,
+			std::string backgroundPath,
+			std::string reflectionPath,
+			std::vector<Image>& images);
+
+		/// <returns>Cache of the environment map with backgroundPath, stored beside it</returns>
+		ENGINE_API static std::string GetPath(std::string backgroundPath);
+
+		/// <returns>Size in bytes of a level of image</returns>
+		ENGINE_API static size_t GetLevelSize(const ImageEntry& image, unsigned int level);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include <Engine/Api.hpp>
+#include <Engine/ResourceID.hpp>
+#include <Engine/Components/Light.hpp>
+#include <Engine/Components/Camera.hpp>
+
+// Must match ClusterCount in Light.inc
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define CLUSTER_COUNT (CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z)
+
+// Lights past this amount in a single cluster are ignored, the first time this happens a warning is logged.
+// See LightClusters::GetOverflowCount, raising it grows the index buffer by CLUSTER_COUNT ints per light.
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+namespace Engine::Graphics
+{
+	class Shader; // Forward declaration
+
+	/// <summary>
+	/// Splits the view frustum into a 3D grid of clusters and assigns each light to the clusters it overlaps,
+	/// so fragments only evaluate lights which can affect them.
+	/// </summary>
+	class LightClusters
+	{
+		/// <summary>
+		/// Buffer object read through a buffer texture
+		/// </summary>
+		struct TextureBuffer
+		{
+			GLenum Format;
+			unsigned int Buffer = GL_INVALID_VALUE;
+			unsigned int Texture = GL_INVALID_VALUE;
+			unsigned int Capacity = 0; // In bytes
+		};
+
+		/// <summary>
+		/// View space axis aligned bounds
+		/// </summary>
+		struct ClusterBounds
+		{
+			glm::vec3 Min;
+			glm::vec3 Max;
+		};
+
+		bool m_ComputeCulling;
+		ResourceID m_CullingShader;
+
+		TextureBuffer m_LightBuffer;	// All lights, 8 RGBA32F texels each
+		TextureBuffer m_GridBuffer;		// (offset, count) per cluster into m_IndexBuffer
+		TextureBuffer m_IndexBuffer;	// Light indices for all clusters
+
+		/// <summary>
+		/// Light data for this frame, ordered directional, point then spot lights
+		/// </summary>
+		std::vector<Components::LightUniformData> m_Lights;
+		unsigned int m_DirectionalCount, m_PointCount;
+
+		// CPU culling state
+		glm::mat4 m_BoundsProjection;
+		std::vector<glm::vec2> m_SliceDepths;
+		std::vector<ClusterBounds> m_ClusterBounds;
+		std::vector<glm::vec4> m_LightSpheres; // View space centre & radius of non-directional lights
+		std::vector<glm::ivec2> m_Grid;
+		std::vector<int> m_Indices;
+		std::vector<std::vector<int>> m_SliceIndices;
+		std::vector<std::vector<int>> m_SliceCandidates;
+		std::vector<unsigned int> m_SliceOverflow;
+
+		// Lights dropped from full clusters, the compute shader's count is read back once its fence has signalled
+		unsigned int m_OverflowCount;
+		bool m_OverflowLogged;
+		unsigned int m_OverflowBuffer;
+		GLsync m_OverflowFence;
+
+		void CullCPU(Components::Camera& camera);
+		void CullCompute(Components::Camera& camera);
+		void CullSlice(unsigned int slice);
+		void BuildClusterBounds(glm::mat4 projection, float near, float far);
+		void RecordOverflow(unsigned int count);
+
+		static void Reserve(TextureBuffer& buffer, unsigned int size);
+		static void Upload(TextureBuffer& buffer, const void* data, unsigned int size);
+		static void Destroy(TextureBuffer& buffer);
+
+	public:
+		ENGINE_API LightClusters();
+		ENGINE_API ~LightClusters();
+
+		/// <summary>
+		/// Gathers & uploads data of all lights, call once per frame
+		/// </summary>
+		ENGINE_API void SetLights(std::vector<Components::Light*>& lights);
+
+		/// <summary>
+		/// Assigns lights to the clusters of camera's view frustum
+		/// </summary>
+		ENGINE_API void Cull(Components::Camera& camera);
+
+		/// <summary>
+		/// Binds light & cluster buffers to their reserved texture slots
+		/// </summary>
+		ENGINE_API void Bind();
+		ENGINE_API void Unbind();
+
+		ENGINE_API unsigned int GetLightCount();
+		ENGINE_API unsigned int GetDirectionalLightCount();
+		ENGINE_API unsigned int GetPointLightCount();
+		ENGINE_API unsigned int GetSpotLightCount();
+
+		/// <returns>
+		/// Lights left out of clusters already holding MAX_LIGHTS_PER_CLUSTER lights when last culled.
+		/// With compute culling this is read back without stalling, so lags a frame or more behind.
+		/// </returns>
+		ENGINE_API unsigned int GetOverflowCount();
+
+		ENGINE_API bool GetComputeCulling();
+
+		/// <summary>
+		/// Assign lights to clusters using a compute shader instead of worker threads.
+		/// Ignored when compute shaders are not supported.
+		/// </summary>
+		ENGINE_API void SetComputeCulling(bool enable);
+
+		/// <summary>
+		/// Assigns the light & cluster buffer samplers of shader to their texture slots
+		/// </summary>
+		ENGINE_API static void FillSamplers(Shader* shader);
+	};
+}
\ No newline at end of file
@@ -1,13 +1,33 @@
 #pragma once
+#include <cstring>
 #include <glm/glm.hpp>
 #include <unordered_map>
 #include <Engine/Api.hpp>
+#include <Engine/ResourceID.hpp>
 #include <Engine/DataStream.hpp>
 #include <Engine/Graphics/Shader.hpp>
 #include <Engine/Graphics/Texture.hpp>
+#include <Engine/Graphics/UniformBuffer.hpp>
 
 namespace Engine::Graphics
 {
+	/// <summary>
+	/// Owning handle to a MaterialInstance stored in the ResourceManager.
+	/// Copying a handle does not share the instance, a copied material creates its own when first submitted.
+	/// </summary>
+	struct ENGINE_API MaterialHandle
+	{
+		ResourceID ID = InvalidResourceID;
+
+		MaterialHandle() = default;
+		MaterialHandle(const MaterialHandle& other) { }
+		MaterialHandle(MaterialHandle&& other) noexcept;
+		~MaterialHandle();
+
+		MaterialHandle& operator =(const MaterialHandle& other) { return *this; }
+		MaterialHandle& operator =(MaterialHandle&& other) noexcept;
+	};
+
 	struct ENGINE_API Material
 	{
 		/// <summary>
@@ -97,10 +117,97 @@ namespace Engine::Graphics
 		/// </summary>
 		bool CanCastShadows = true;
 
-		void FillShader(Shader* shader);
+		/// <summary>
+		/// Instance of this material used for rendering, created on first call to GetInstance
+		/// </summary>
+		MaterialHandle Instance;
+
+		/// <summary>
+		/// Creates the instance if required and updates it with any values changed since the last call.
+		/// Fields can be edited freely, changes are detected by comparing against the instance.
+		/// </summary>
+		/// <returns>ID of a MaterialInstance in the ResourceManager</returns>
+		ResourceID GetInstance();
+
 		void Serialize(DataStream& stream);
 
 	private:
 		void SerializeTexture(DataStream& stream, ResourceID& texture);
 	};
-}
+
+	/// <summary>
+	/// Material values packed to match the std140 layout of the 'MaterialData' uniform block (Assets/Shaders/Include/Material.inc)
+	/// </summary>
+	struct ENGINE_API MaterialUniformBlock
+	{
+		glm::vec4 AlbedoColour;
+		glm::vec2 TextureCoordScale;
+		glm::vec2 TextureCoordOffset;
+
+		float Roughness;
+		float Metalness;
+		float AlphaClipThreshold;
+		int AlphaClipping;
+
+		int HasAlbedoMap;
+		int HasNormalMap;
+		int HasRoughnessMap;
+		int HasMetalnessMap;
+
+		int HasAmbientOcclusionMap;
+		int Padding[3];
+
+		bool operator ==(const MaterialUniformBlock& other) const { return memcmp(this, &other, sizeof(MaterialUniformBlock)) == 0; }
+		bool operator !=(const MaterialUniformBlock& other) const { return !(*this == other); }
+	};
+
+	/// <summary>
+	/// Render-side copy of a Material, stored in the ResourceManager.
+	/// Uniform values are packed into a uniform buffer which is only re-uploaded when changed.
+	/// </summary>
+	class MaterialInstance
+	{
+		bool m_Dirty;
+		UniformBuffer m_Buffer;
+		MaterialUniformBlock m_Uniforms;
+
+		/// <summary>
+		/// Albedo, normal, roughness, metalness & ambient occlusion maps, in texture slot order
+		/// </summary>
+		ResourceID m_Textures[5];
+		bool m_Wireframe;
+
+		void BindTexture(unsigned int index, ResourceID textureID);
+
+	public:
+		ENGINE_API MaterialInstance();
+		ENGINE_API ~MaterialInstance();
+
+		/// <summary>
+		/// Packs values of material & compares them against this instance, marking it dirty if any uniform values have changed.
+		/// Texture IDs & render state are stored directly, the material itself is not copied.
+		/// </summary>
+		ENGINE_API void Update(Material& material);
+
+		/// <summary>
+		/// Uploads uniforms if dirty, then binds the uniform buffer and textures
+		/// </summary>
+		ENGINE_API void Bind();
+
+		ENGINE_API bool IsDirty();
+		ENGINE_API bool IsWireframe();
+
+		/// <returns>True when albedo alpha is below 1</returns>
+		ENGINE_API bool IsTransparent();
+
+		/// <summary>
+		/// Checks if binding other would result in the same uniform values & textures as this instance
+		/// </summary>
+		ENGINE_API bool IsEquivalent(MaterialInstance& other);
+
+		/// <summary>
+		/// Assigns the material texture samplers of shader to their texture slots
+		/// </summary>
+		ENGINE_API static void FillSamplers(Shader* shader);
+	};
+}
\ No newline at end of file
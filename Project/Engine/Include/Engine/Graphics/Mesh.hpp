@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 #include <Engine/Api.hpp>
@@ -36,31 +37,221 @@ namespace Engine::Graphics
 			glm::vec3 Bitangent;
 		};
 
+		/// <summary>
+		/// Layout of vertices once uploaded to the GPU, the CPU copy is always stored as Vertex
+		/// </summary>
+		enum class VertexFormat : unsigned char
+		{
+			/// <summary>
+			/// Vertex as-is, 56 bytes
+			/// </summary>
+			Full,
+
+			/// <summary>
+			/// Float position, 10:10:10:2 normal & tangent with bitangent sign in tangent's w, half float texture coordinates. 24 bytes.
+			/// </summary>
+			Compact,
+
+			/// <summary>
+			/// Compact with half float positions, only suitable for meshes with small local space bounds. 20 bytes.
+			/// </summary>
+			CompactHalfPosition
+		};
+
+		struct CompactVertex
+		{
+			glm::vec3 Position;
+			uint32_t Normal;
+			uint32_t Tangent;
+			uint32_t TexCoords;
+		};
+
+		struct CompactHalfPositionVertex
+		{
+			// xyz, w is padding
+			uint16_t Position[4];
+			uint32_t Normal;
+			uint32_t Tangent;
+			uint32_t TexCoords;
+		};
+
+		/// <summary>
+		/// Location of a mesh's data inside the renderer's shared MeshBuffer
+		/// </summary>
+		struct SharedAllocation
+		{
+			int BaseVertex = 0;
+			unsigned int FirstIndex = 0;
+			unsigned int IndexCount = 0;
+		};
+
+		/// <summary>
+		/// Vertices already in the GPU layout of Format, uploaded without keeping a CPU copy.
+		/// Only needs to stay valid until the mesh is constructed.
+		/// </summary>
+		struct PackedData
+		{
+			const unsigned char* Vertices = nullptr;
+			unsigned int VertexCount = 0;
+			const unsigned int* Indices = nullptr;
+			unsigned int IndexCount = 0;
+			VertexFormat Format = VertexFormat::Full;
+
+			glm::vec3 BoundsMin = glm::vec3(0.0f);
+			glm::vec3 BoundsMax = glm::vec3(0.0f);
+		};
+
+		/// <summary>
+		/// Lower detail version of a mesh
+		/// </summary>
+		struct LODLevel
+		{
+			ResourceID Mesh = InvalidResourceID;
+
+			/// <summary>
+			/// Used once the projected diameter of the mesh's bounding sphere is less than this fraction of the screen height
+			/// </summary>
+			float ScreenSize = 0.0f;
+		};
+
+		/// <summary>
+		/// Fraction of a LOD's screen size that must be crossed before switching, prevents flickering at the boundary
+		/// </summary>
+		static constexpr float LODHysteresis = 0.1f;
+
 	private:
 		unsigned int m_VBO, m_VAO, m_EBO;
 
 		bool m_Setup;
+		bool m_Shared;
+		VertexFormat m_VertexFormat;
+		SharedAllocation m_Allocation;
 		DrawMode m_DrawMode;
 		std::vector<Vertex> m_Vertices;
 		std::vector<unsigned int> m_Indices;
 
+		// Counts of data on the GPU, CPU copies are empty for meshes created from PackedData
+		unsigned int m_VertexCount, m_IndexCount;
+
+		// Local space bounds of all vertices
+		glm::vec3 m_BoundsMin, m_BoundsMax;
+
+		std::vector<LODLevel> m_LODs;
+
+		static VertexFormat s_DefaultVertexFormat;
+
 		void Setup();
+		void CalculateBounds();
+		void CreateBuffers(const unsigned char* vertexData, size_t vertexDataSize, const unsigned int* indices, unsigned int indexCount);
 
 	public:
 		ENGINE_API Mesh();
 		ENGINE_API Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices = {}, DrawMode drawMode = DrawMode::Triangles);
+
+		/// <summary>
+		/// Uploads an indexed triangle mesh straight from packed data, e.g. memory mapped from a cache.
+		/// GetVertices & GetIndices are empty for these meshes.
+		/// </summary>
+		/// <param name="shared">Store in the renderer's shared MeshBuffer, see SetShared</param>
+		ENGINE_API Mesh(PackedData data, bool shared = false);
 		ENGINE_API ~Mesh();
 
-		ENGINE_API void Draw();
+		/// <summary>
+		/// Draws the mesh, when instances is greater than one an instanced draw is used
+		/// </summary>
+		ENGINE_API void Draw(unsigned int instances = 1);
 		ENGINE_API void SetData(std::vector<Vertex>& vertices, std::vector<unsigned int> indices = {});
 
+		/// <summary>
+		/// Uploads vertices & indices to the GPU now, instead of when first drawn
+		/// </summary>
+		ENGINE_API void Upload();
+
+		/// <summary>
+		/// Stores this mesh in the renderer's shared MeshBuffer instead of its own buffers,
+		/// allowing it to be drawn with other shared meshes in a single indirect draw call.
+		/// Must be set before the mesh is first drawn, only indexed triangle meshes can be shared.
+		/// </summary>
+		ENGINE_API void SetShared(bool shared = true);
+		ENGINE_API bool IsShared() { return m_Shared; }
+
+		/// <summary>
+		/// Location inside the shared MeshBuffer, uploading the mesh if not done yet
+		/// </summary>
+		ENGINE_API SharedAllocation& GetSharedAllocation();
+
+		ENGINE_API DrawMode GetDrawMode() { return m_DrawMode; }
+
+		/// <summary>
+		/// Sets the layout used when uploading vertices, must be set before the mesh is first drawn.
+		/// Shared meshes always use the layout of the shared MeshBuffer.
+		/// </summary>
+		ENGINE_API void SetVertexFormat(VertexFormat format);
+		ENGINE_API VertexFormat GetVertexFormat() { return m_VertexFormat; }
+
 		ENGINE_API std::vector<Vertex>& GetVertices() { return m_Vertices; }
 		ENGINE_API std::vector<unsigned int>& GetIndices() { return m_Indices; }
 
+		ENGINE_API glm::vec3& GetBoundsMin() { return m_BoundsMin; }
+		ENGINE_API glm::vec3& GetBoundsMax() { return m_BoundsMax; }
+
+		/// <summary>
+		/// Adds a lower detail mesh, from highest to lowest detail. LOD meshes are not owned by this mesh.
+		/// </summary>
+		ENGINE_API void AddLOD(ResourceID mesh, float screenSize);
+		ENGINE_API void ClearLODs();
+
+		/// <summary>
+		/// Lower detail levels, not including this mesh (LOD 0)
+		/// </summary>
+		ENGINE_API std::vector<LODLevel>& GetLODs() { return m_LODs; }
+
+		/// <summary>
+		/// Chooses a level of detail for the given screen size, with hysteresis around the current level
+		/// </summary>
+		/// <param name="screenSize">Projected diameter of the mesh's bounding sphere as a fraction of the screen height</param>
+		/// <returns>0 for this mesh, otherwise index + 1 into GetLODs</returns>
+		ENGINE_API unsigned int SelectLOD(float screenSize, unsigned int currentLOD);
+
+		/// <summary>
+		/// Describes the layout of format to the currently bound vertex array & array buffer
+		/// </summary>
+		ENGINE_API static void SetupVertexAttributes(VertexFormat format);
+
+		/// <summary>
+		/// Vertex format given to newly created meshes, and to the shared MeshBuffer when first used. Default is Compact.
+		/// </summary>
+		ENGINE_API static void SetDefaultVertexFormat(VertexFormat format);
+		ENGINE_API static VertexFormat GetDefaultVertexFormat();
+
+		/// <returns>Size in bytes of a single vertex in format</returns>
+		ENGINE_API static unsigned int GetVertexSize(VertexFormat format);
+
+		/// <summary>
+		/// Converts vertices to the GPU layout of format
+		/// </summary>
+		ENGINE_API static std::vector<unsigned char> PackVertices(std::vector<Vertex>& vertices, VertexFormat format);
+
+		/// <summary>
+		/// Converts vertices packed in format back to Vertex, bitangents are rebuilt from the normal, tangent & sign
+		/// </summary>
+		ENGINE_API static std::vector<Vertex> UnpackVertices(const unsigned char* data, unsigned int vertexCount, VertexFormat format);
+
 		ENGINE_API static ResourceID& Quad();
 		ENGINE_API static ResourceID& Cube();
 		ENGINE_API static ResourceID& Line();
 		ENGINE_API static ResourceID& Sphere();
+
+		/// <summary>
+		/// Low poly sphere which fully contains a unit sphere, used as point light volume
+		/// </summary>
+		ENGINE_API static ResourceID& LightSphere();
+
+		/// <summary>
+		/// Low poly cone with apex at origin & base at +Z of 1.0.
+		/// Fully contains a cone of unit radius, used as spot light volume.
+		/// </summary>
+		ENGINE_API static ResourceID& LightCone();
 		ENGINE_API static ResourceID Grid(unsigned int size);
 	};
 }
\ No newline at end of file
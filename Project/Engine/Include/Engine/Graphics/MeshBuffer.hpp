@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/Mesh.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Matches the layout of a command read by glMultiDrawElementsIndirect
+	/// </summary>
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int Count;
+		unsigned int InstanceCount;
+		unsigned int FirstIndex;
+		int BaseVertex;
+		unsigned int BaseInstance;
+	};
+
+	/// <summary>
+	/// Vertex & index storage shared by many meshes behind a single vertex array,
+	/// allowing multiple meshes to be drawn by a single indirect draw call.
+	/// Space is only appended to, allocations are never freed.
+	/// </summary>
+	class MeshBuffer
+	{
+		unsigned int m_VAO, m_VBO, m_EBO;
+		unsigned int m_InstanceBuffer, m_CommandBuffer;
+		Mesh::VertexFormat m_VertexFormat;
+
+		unsigned int m_VertexCount, m_VertexCapacity;
+		unsigned int m_IndexCount, m_IndexCapacity;
+		unsigned int m_InstanceCapacity, m_CommandCapacity;
+
+		void Create();
+		void SetupAttributes();
+
+		/// <summary>
+		/// Replaces buffer with a larger one, keeping the first usedSize bytes
+		/// </summary>
+		void Grow(unsigned int& buffer, GLenum target, size_t usedSize, size_t newSize, GLenum usage);
+
+	public:
+		/// <summary>
+		/// Vertex attribute location of the first column of the per-instance model matrix
+		/// </summary>
+		static const unsigned int InstanceMatrixLocation = 6;
+
+		ENGINE_API MeshBuffer();
+		ENGINE_API ~MeshBuffer();
+
+		MeshBuffer(const MeshBuffer&) = delete;
+		MeshBuffer& operator =(const MeshBuffer&) = delete;
+
+		/// <summary>
+		/// Appends vertices & indices to the shared buffers, growing them when full
+		/// </summary>
+		ENGINE_API Mesh::SharedAllocation Allocate(std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+		/// <summary>
+		/// Appends vertices already packed in this buffer's vertex format, see GetVertexFormat
+		/// </summary>
+		ENGINE_API Mesh::SharedAllocation Allocate(const unsigned char* vertexData, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+
+		/// <summary>
+		/// Overwrites the data of an allocation, vertex & index counts must be unchanged
+		/// </summary>
+		ENGINE_API void Update(Mesh::SharedAllocation& allocation, std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+		/// <summary>
+		/// Uploads per-instance model matrices, indexed by a command's base instance
+		/// </summary>
+		ENGINE_API void SetInstances(std::vector<glm::mat4>& modelMatrices);
+
+		/// <summary>
+		/// Uploads indirect draw commands, read when drawing with an offset into this list
+		/// </summary>
+		ENGINE_API void SetCommands(std::vector<DrawElementsIndirectCommand>& commands);
+
+		/// <summary>
+		/// Issues a single multi draw for commands [first, first + count)
+		/// </summary>
+		ENGINE_API void DrawIndirect(GLenum drawMode, unsigned int first, unsigned int count);
+
+		/// <returns>Buffer object holding commands, for compute shaders to modify after SetCommands</returns>
+		ENGINE_API unsigned int GetCommandBuffer();
+
+		ENGINE_API void Bind();
+		ENGINE_API void Unbind();
+
+		/// <summary>
+		/// Layout of all vertices in this buffer, taken from Mesh::GetDefaultVertexFormat when first used
+		/// </summary>
+		ENGINE_API Mesh::VertexFormat GetVertexFormat();
+	};
+}
\ No newline at end of file
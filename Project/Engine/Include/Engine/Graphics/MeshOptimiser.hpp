@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/Mesh.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Reorders indexed triangle lists for GPU efficiency, intended to run once at import time
+	/// </summary>
+	class MeshOptimiser
+	{
+	public:
+		struct Stats
+		{
+			/// <summary>
+			/// Average cache miss ratio, vertex shader invocations per triangle. Best case is ~0.5, worst is 3.0.
+			/// </summary>
+			float ACMRBefore = 0.0f;
+			float ACMRAfter = 0.0f;
+
+			unsigned int ClusterCount = 0;
+		};
+
+		/// <summary>
+		/// Runs all optimisations in order: vertex cache, overdraw then vertex fetch
+		/// </summary>
+		ENGINE_API static Stats Optimise(std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+		/// <summary>
+		/// Reorders triangles to maximise post-transform vertex cache hits (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+		/// </summary>
+		ENGINE_API static void OptimiseVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+
+		/// <summary>
+		/// Splits cache optimised triangles into clusters where the vertex cache restarts,
+		/// then draws outward facing clusters first so they occlude the rest
+		/// </summary>
+		/// <returns>Number of clusters sorted</returns>
+		ENGINE_API static unsigned int OptimiseOverdraw(std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+		/// <summary>
+		/// Reorders vertices to match the order they are first referenced, removing unreferenced vertices
+		/// </summary>
+		ENGINE_API static void OptimiseVertexFetch(std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+		/// <summary>
+		/// Reduces triangle count by collapsing edges in order of quadric error (Garland & Heckbert).
+		/// Vertices on open edges, including UV & normal seams, are never moved.
+		/// </summary>
+		/// <param name="targetIndexCount">Stops once at or below this many indices</param>
+		/// <param name="maxError">Largest sum of squared distances to the original planes allowed per collapse</param>
+		/// <returns>Simplified indices into the unchanged vertices</returns>
+		ENGINE_API static std::vector<unsigned int> Simplify(
+			std::vector<Mesh::Vertex>& vertices,
+			std::vector<unsigned int>& indices,
+			unsigned int targetIndexCount,
+			float maxError);
+
+		/// <summary>
+		/// Simulates a FIFO post-transform cache of cacheSize vertices
+		/// </summary>
+		ENGINE_API static float CalculateACMR(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = 16);
+	};
+}
\ No newline at end of file
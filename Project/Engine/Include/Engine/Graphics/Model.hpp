@@ -1,4 +1,6 @@
 #pragma once
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <assimp/scene.h>
@@ -6,13 +8,53 @@
 #include <Engine/GameObject.hpp>
 #include <Engine/ResourceID.hpp>
 #include <Engine/DataStream.hpp>
+#include <Engine/Graphics/Mesh.hpp>
 #include <Engine/Graphics/Material.hpp>
 
+namespace Engine::Components { class ModelPlaceholder; }
+
 namespace Engine::Graphics
 {
 	class Model
 	{
 	public:
+		enum class LoadState
+		{
+			/// <summary>
+			/// Parsing & processing on a worker thread
+			/// </summary>
+			Loading,
+
+			/// <summary>
+			/// Meshes are being uploaded to the GPU over several frames
+			/// </summary>
+			Uploading,
+
+			Loaded,
+			Failed
+		};
+
+		/// <summary>
+		/// Processed mesh data not yet uploaded to the GPU
+		/// </summary>
+		struct ImportedMesh
+		{
+			std::vector<Mesh::Vertex> Vertices;
+			std::vector<unsigned int> Indices;
+			Mesh::VertexFormat Format = Mesh::GetDefaultVertexFormat();
+
+			/// <summary>
+			/// Screen size this mesh is used below, when a level of detail
+			/// </summary>
+			float ScreenSize = 0.0f;
+			std::vector<ImportedMesh> LODs;
+		};
+
+		/// <summary>
+		/// Time spent uploading meshes of asynchronously loaded models each frame, in milliseconds
+		/// </summary>
+		static constexpr float UploadBudget = 2.0f;
+
 		struct ENGINE_API MeshData
 		{
 			std::string Name = "";
@@ -27,22 +69,85 @@ namespace Engine::Graphics
 		std::string m_Path;
 		std::vector<ResourceID> m_Meshes;
 
+		/// <summary>
+		/// State shared with the worker thread, defined in Model.cpp
+		/// </summary>
+		struct AsyncLoad;
+		std::shared_ptr<AsyncLoad> m_AsyncLoad;
+		LoadState m_State;
+
+		/// <summary>
+		/// Entities created before loading finished, filled in once loaded
+		/// </summary>
+		std::vector<Components::ModelPlaceholder*> m_Placeholders;
+
+		static std::vector<Model*> s_AsyncLoads;
+
+		friend class Components::ModelPlaceholder;
+
 		Model();
 
 		void Load();
+		void BeginLoad();
+
+		/// <summary>
+		/// Uploads processed meshes until deadline, then builds the mesh hierarchy
+		/// </summary>
+		/// <returns>True once loading has finished or failed</returns>
+		bool ContinueLoad(std::chrono::steady_clock::time_point deadline);
+
+		/// <summary>
+		/// Releases loading state & replaces placeholders with the loaded hierarchy
+		/// </summary>
+		void FinishLoad(LoadState state);
+
+		/// <summary>
+		/// Maps the model cache or reads the model file, called on a worker thread
+		/// </summary>
+		static void ImportModel(AsyncLoad& load);
+		static ImportedMesh ProcessMesh(aiMesh* mesh);
+		static ResourceID CreateMesh(ImportedMesh& mesh);
+
 		Material CreateMaterial(aiMaterial* material);
 		void CreateEntity(MeshData& mesh, Engine::GameObject* parent);
-		ResourceID ProcessMesh(aiMesh* mesh, const aiScene* scene);
 		void ProcessNode(aiNode* node, MeshData* parent, const aiScene* scene);
 
-		void SaveCache();
-		void LoadFromCache();
-		void Serialize(DataStream& stream);
+		/// <summary>
+		/// Unloads all meshes & their levels of detail
+		/// </summary>
+		void UnloadMeshes();
+
+		/// <summary>
+		/// Mesh hierarchy & materials, stored in the ModelCache.
+		/// Materials load textures so this must be called on the main thread.
+		/// </summary>
+		void SerializeHierarchy(DataStream& stream);
 
 	public:
-		ENGINE_API Model(std::string path);
+		/// <param name="async">When true, returns immediately & loads on worker threads. See LoadAsync.</param>
+		ENGINE_API Model(std::string path, bool async = false);
 		ENGINE_API ~Model();
 
+		/// <summary>
+		/// Starts loading a model on worker threads, meshes are uploaded over the following frames.
+		/// Entities created before loading finishes show a placeholder until the model is loaded.
+		/// </summary>
+		ENGINE_API static ResourceID LoadAsync(std::string path);
+
+		/// <summary>
+		/// Continues uploading asynchronously loaded models for up to timeBudget milliseconds.
+		/// Called once per frame by the application.
+		/// </summary>
+		ENGINE_API static void UpdateAsyncLoads(float timeBudget = UploadBudget);
+
+		ENGINE_API LoadState GetLoadState();
+		ENGINE_API bool IsLoaded();
+
+		/// <summary>
+		/// Blocks until this model has finished loading, uploading all remaining meshes
+		/// </summary>
+		ENGINE_API void Wait();
+
 		ENGINE_API MeshData& GetRootMeshData();
 		ENGINE_API std::vector<ResourceID>& GetMeshes();
 		ENGINE_API Engine::GameObject* CreateEntity(Engine::GameObject* parent = nullptr, glm::vec3 position = { 0, 0, 0 });
@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <Engine/Api.hpp>
+#include <Engine/MappedFile.hpp>
+#include <Engine/DataStream.hpp>
+#include <Engine/Graphics/Mesh.hpp>
+#include <Engine/Graphics/Model.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Binary cache of a model's processed meshes. The file is memory mapped so vertex & index data
+	/// is handed to the GPU straight from the mapping, without being read or copied first.
+	/// 
+	/// Layout is a Header, the MeshEntry table, 16 byte aligned vertex & index data of each entry,
+	/// then the mesh hierarchy written by a DataStream.
+	/// </summary>
+	class ModelCache
+	{
+	public:
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+
+			// Source file when cached. Content hash is only compared when size or write time have changed.
+			uint64_t SourceSize;
+			int64_t SourceWriteTime;
+			uint64_t SourceHash;
+
+			/// <summary>
+			/// Meshes of the model, the first entries of the table. Levels of detail follow.
+			/// </summary>
+			uint32_t MeshCount;
+			uint32_t EntryCount;
+
+			uint64_t HierarchyOffset;
+			uint64_t HierarchySize;
+		};
+
+		struct MeshEntry
+		{
+			// Offsets from the start of the file
+			uint64_t VertexOffset;
+			uint64_t IndexOffset;
+
+			uint32_t VertexCount;
+			uint32_t IndexCount;
+			uint32_t Format;
+			float ScreenSize;
+
+			/// <summary>
+			/// Levels of detail are the entries [FirstLOD, FirstLOD + LODCount)
+			/// </summary>
+			uint32_t FirstLOD;
+			uint32_t LODCount;
+
+			float BoundsMin[3];
+			float BoundsMax[3];
+		};
+
+		/// <summary>
+		/// Increment when the layout changes, older caches are re-imported
+		/// </summary>
+		static const uint32_t Version = 1;
+
+	private:
+		MappedFile m_File;
+		const Header* m_Header;
+		const MeshEntry* m_Entries;
+
+		bool Validate(std::string& sourcePath);
+
+	public:
+		ENGINE_API ModelCache();
+
+		/// <summary>
+		/// Maps a cache file, safe to call from any thread
+		/// </summary>
+		/// <returns>False if the cache is missing, corrupt, from another version or the source file has changed</returns>
+		ENGINE_API bool Open(std::string cachePath, std::string sourcePath);
+		ENGINE_API void Close();
+
+		ENGINE_API unsigned int GetMeshCount() const;
+		ENGINE_API const MeshEntry& GetEntry(unsigned int index) const;
+
+		/// <returns>Vertex & index data of entry, pointing into the mapped file</returns>
+		ENGINE_API Mesh::PackedData GetPackedData(const MeshEntry& entry) const;
+
+		/// <returns>Mesh hierarchy as written to Save, in reading mode</returns>
+		ENGINE_API DataStream GetHierarchy() const;
+
+		/// <summary>
+		/// Writes meshes, their levels of detail & the hierarchy. Safe to call from any thread.
+		/// </summary>
+		/// <param name="sourceHash">Result of MappedFile::HashFile for sourcePath</param>
+		ENGINE_API static bool Save(
+			std::string cachePath,
+			std::string sourcePath,
+			uint64_t sourceHash,
+			std::vector<Model::ImportedMesh>& meshes,
+			DataStream& hierarchy);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include <Engine/Api.hpp>
+#include <Engine/ResourceID.hpp>
+#include <Engine/Components/Camera.hpp>
+
+namespace Engine::Graphics
+{
+	class RenderTexture; // Forward declaration
+
+	/// <summary>
+	/// Hierarchical depth (Hi-Z) pyramid built from a frame's depth, used to skip drawing objects
+	/// hidden behind geometry drawn the frame before. Each mip stores the farthest depth of the texels below it.
+	/// Objects are tested with the view projection the pyramid was built with, so results lag a frame behind the camera.
+	/// </summary>
+	class OcclusionCulling
+	{
+		/// <summary>
+		/// Copy of a low resolution pyramid level, read without stalling once its fence has signalled
+		/// </summary>
+		struct Readback
+		{
+			unsigned int Buffer = GL_INVALID_VALUE;
+			GLsync Fence = nullptr;
+			glm::ivec2 Size = { 0, 0 };
+			glm::mat4 ViewProjection = glm::mat4(1.0f);
+			Components::Camera* Camera = nullptr;
+		};
+
+		bool m_Enabled;
+		bool m_ComputeCulling;
+		ResourceID m_DownsampleShader;
+		ResourceID m_CullingShader;
+
+		unsigned int m_Pyramid;		// R32F, farthest depth per texel with a full mip chain
+		unsigned int m_Framebuffer;	// Draws to a single pyramid level at a time
+		unsigned int m_BoundsBuffer;	// World space bounds of each command, read when culling on the GPU
+		unsigned int m_BoundsCapacity; // In bytes
+		glm::ivec2 m_Size;			// Power of two resolution of the first pyramid level, at most half of the depth it was built from
+		unsigned int m_LevelCount;
+
+		Components::Camera* m_Camera;
+		glm::mat4 m_ViewProjection;
+
+		// CPU culling state, readbacks alternate each frame
+		Readback m_Readbacks[2];
+		unsigned int m_ReadbackIndex;
+		unsigned int m_ReadbackLevel;
+		std::vector<float> m_Depths;
+		glm::ivec2 m_DepthsSize;
+		glm::mat4 m_DepthsViewProjection;
+		Components::Camera* m_DepthsCamera;
+
+		void Create(glm::ivec2 size);
+		void Destroy();
+		void QueueReadback();
+		void ResolveReadback(Readback& readback);
+		glm::ivec2 GetLevelSize(unsigned int level);
+
+	public:
+		ENGINE_API OcclusionCulling();
+		ENGINE_API ~OcclusionCulling();
+
+		OcclusionCulling(const OcclusionCulling&) = delete;
+		OcclusionCulling& operator =(const OcclusionCulling&) = delete;
+
+		/// <summary>
+		/// Builds the pyramid from depth as seen by camera, tested against by objects drawn in the following frame
+		/// </summary>
+		ENGINE_API void Build(RenderTexture* depth, Components::Camera& camera);
+
+		/// <returns>True when objects drawn for camera can be tested against the pyramid</returns>
+		ENGINE_API bool IsReady(Components::Camera* camera);
+
+		/// <returns>False if the world space bounds were hidden behind the depth read back to the CPU</returns>
+		ENGINE_API bool IsVisible(glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+		/// <summary>
+		/// Sets the instance count of occluded commands to zero in an uploaded command buffer, see GetComputeCulling
+		/// </summary>
+		/// <param name="bounds">World space (min, max) pairs, two per command</param>
+		ENGINE_API void Cull(std::vector<glm::vec4>& bounds, unsigned int commandBuffer, unsigned int commandCount);
+
+		ENGINE_API bool GetEnabled();
+
+		/// <summary>
+		/// Disabled by default, objects coming into view from behind an occluder can appear a frame late
+		/// </summary>
+		ENGINE_API void SetEnabled(bool enable);
+
+		/// <returns>True when commands are culled on the GPU using Cull, otherwise IsVisible is used</returns>
+		ENGINE_API bool GetComputeCulling();
+
+		/// <summary>
+		/// Test objects against the full pyramid using a compute shader instead of a low resolution copy read back to the CPU.
+		/// Only applies to indirect draws, and is ignored when compute shaders are not supported.
+		/// </summary>
+		ENGINE_API void SetComputeCulling(bool enable);
+	};
+}
\ No newline at end of file
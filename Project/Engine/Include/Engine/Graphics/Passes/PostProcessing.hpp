@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include <Engine/Api.hpp>
 #include <Engine/Graphics/RenderPipeline.hpp>
 
@@ -24,6 +25,50 @@ namespace Engine::Graphics
 		ENGINE_API RenderPipelinePass& GetPipelinePass();
 	};
 
+	/// <summary>
+	/// Adds light bleeding around bright areas. The input is progressively downsampled into a chain of half resolution
+	/// & smaller textures, then upsampled back through the chain before being added to the input.
+	/// No blur is ever done at full resolution, cost is bounded by the half resolution level.
+	/// </summary>
+	class BloomPass : public FullscreenEffectPass
+	{
+		glm::ivec2 m_Resolution = { 0, 0 };
+		std::vector<Framebuffer*> m_Levels;
+		ResourceID m_DownsampleShader, m_UpsampleShader;
+
+		/// <summary>
+		/// Recreates the chain when input resolution has changed
+		/// </summary>
+		void CreateLevels(glm::ivec2 inputResolution);
+
+	public:
+		/// <summary>
+		/// Largest amount of levels in the chain, the first level is half resolution
+		/// </summary>
+		static const unsigned int MaxLevels = 6;
+
+		/// <summary>
+		/// Brightness above which light contributes to bloom
+		/// </summary>
+		float Threshold = 1.0f;
+
+		/// <summary>
+		/// Multiplier of the bloom added to the input
+		/// </summary>
+		float Intensity = 0.3f;
+
+		/// <summary>
+		/// Upsample filter radius in texels, larger values spread further
+		/// </summary>
+		float Radius = 1.0f;
+
+		ENGINE_API BloomPass();
+		ENGINE_API ~BloomPass();
+
+	protected:
+		ENGINE_API virtual void OnDraw(Shader* shader) override;
+	};
+
 	enum class Tonemapper { None = 0, Aces, Reinhard };
 
 	class TonemappingPass : public FullscreenEffectPass
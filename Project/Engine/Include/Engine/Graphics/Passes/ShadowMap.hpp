@@ -1,8 +1,9 @@
 #pragma once
 #include <Engine/Graphics/Shader.hpp>
+#include <Engine/Graphics/ShadowAtlas.hpp>
 #include <Engine/Graphics/RenderPipeline.hpp>
 
-namespace Engine::Components { struct Light; }
+namespace Engine::Components { struct Light; struct MeshRenderer; }
 
 namespace Engine::Graphics
 {
@@ -13,39 +14,170 @@ namespace Engine::Graphics
 		/// </summary>
 		struct LightShadowData
 		{
-			// Camera view * projection matrices. Stored here instead of recalculating multiple times per frame
-			glm::mat4 LightSpaceMatrix;
+			/// <summary>
+			/// Camera view * projection matrices, one per shadow map layer used by the light.
+			/// Stored here instead of recalculating multiple times per frame
+			/// </summary>
+			glm::mat4 LightSpaceMatrices[SHADOW_CASCADE_COUNT];
+
+			/// <summary>
+			/// Region of the shadow atlas for each layer, offset (xy) & size (zw) in texels
+			/// </summary>
+			glm::ivec4 Tiles[SHADOW_CASCADE_COUNT];
+
+			/// <summary>
+			/// Directional lights use one layer per cascade, spot lights use a single layer
+			/// </summary>
+			unsigned int LayerCount = 0;
 
 			/// <summary>
+			/// First layer in the shadow matrix & tile arrays.
 			/// Less than 0 implies that light has not been calculated nor put into the shadow map
 			/// </summary>
-			int ShadowMapArrayIndex;
+			int ShadowMapArrayIndex = -1;
+		};
+
+		/// <summary>
+		/// Mesh which can cast shadows, gathered once per frame
+		/// </summary>
+		struct ShadowCaster
+		{
+			glm::mat4 ModelMatrix;
+			ResourceID Mesh;
+			Components::MeshRenderer* Renderer;
+
+			/// <summary>
+			/// World space centre (xyz) & radius (w)
+			/// </summary>
+			glm::vec4 BoundingSphere;
+
+			/// <summary>
+			/// Has not moved for StaticCasterFrames, drawn into the cached static layer
+			/// </summary>
+			bool Static;
+		};
+
+		/// <summary>
+		/// Movement tracking of a mesh renderer, used to classify casters as static
+		/// </summary>
+		struct CasterState
+		{
+			unsigned int TransformVersion = 0;
+			unsigned int UnchangedFrames = 0;
+		};
+
+		/// <summary>
+		/// A single tile of the shadow atlas and the casters visible to it
+		/// </summary>
+		struct ShadowLayer
+		{
+			glm::mat4 LightSpaceMatrix;
+			glm::ivec4 Tile;
+
+			/// <summary>
+			/// Orthographic projections do not cull against the near plane,
+			/// casters in front of it are clamped onto it while drawing
+			/// </summary>
+			bool Orthographic;
+
+			/// <summary>
+			/// Indices into m_Casters
+			/// </summary>
+			std::vector<unsigned int> StaticDrawList, DynamicDrawList;
+
+			/// <summary>
+			/// Identifies the static casters drawn into the cached layer
+			/// </summary>
+			size_t StaticHash = 0;
+
+			/// <summary>
+			/// Cached static layer needs to be redrawn
+			/// </summary>
+			bool StaticDirty = true;
+
+			/// <summary>
+			/// Layer needs to be recomposited from the static layer & dynamic casters
+			/// </summary>
+			bool Dirty = true;
 		};
 
 		glm::ivec2 m_Resolution;
 		RenderPipelinePass m_Pass;
+		ShadowAtlas m_Atlas;
+		unsigned int m_MemoryBudget;
 		Shader* m_Shader = nullptr;
 
+		/// <summary>
+		/// Same layout as m_Pass, holds only static casters
+		/// </summary>
+		Framebuffer* m_StaticPass = nullptr;
+
 		EngineUnorderedMap<Components::Light*, LightShadowData> m_ShadowCasters;
 
-		void SetBorder();
+		std::vector<ShadowCaster> m_Casters;
+		std::vector<ShadowLayer> m_Layers;
+
+		/// <summary>
+		/// True when a caster moved, was added or was removed this frame
+		/// </summary>
+		bool m_CastersChanged = true;
+		EngineUnorderedMap<Components::MeshRenderer*, CasterState> m_CasterStates;
+
+		void UpdateShadowData();
 		void DrawCallback(Framebuffer* previous);
 		void FillShadowData(Components::Light* light, LightShadowData& shadowData);
+		void FillCascades(Components::Light* light, LightShadowData& shadowData);
+
+		void GatherCasters();
+		void CullLayer(ShadowLayer& layer);
+		void AllocateTiles();
+		float GetImportance(Components::Light* light);
+		void DrawCasters(ShadowLayer& layer, std::vector<unsigned int>& drawList);
 
 		void AddShadowCaster(Components::Light* light);
 		void RemoveShadowCaster(Components::Light* light);
 
+		friend class RenderPipeline;
 		friend struct Components::Light;
 
 	public:
-		ENGINE_API ShadowMapPass(glm::ivec2 resolution = { 1024, 1024 });
+		/// <param name="resolution">Largest tile size given to a single light</param>
+		/// <param name="memoryBudget">Video memory used by the shadow atlas, in megabytes</param>
+		ENGINE_API ShadowMapPass(glm::ivec2 resolution = { 1024, 1024 }, unsigned int memoryBudget = 64);
 		ENGINE_API ~ShadowMapPass();
 
+		/// <summary>
+		/// Largest tile size given to a single light, less important lights receive smaller tiles
+		/// </summary>
 		ENGINE_API glm::ivec2& GetResolution();
 		ENGINE_API void SetResolution(glm::ivec2 resolution);
 
+		/// <summary>
+		/// Video memory used by the shadow atlas, in megabytes.
+		/// The atlas is the largest power of two texture fitting inside of this budget.
+		/// </summary>
+		ENGINE_API unsigned int GetMemoryBudget();
+		ENGINE_API void SetMemoryBudget(unsigned int megabytes);
+
+		ENGINE_API unsigned int GetAtlasSize();
+
 		ENGINE_API RenderPipelinePass& GetPipelinePass();
 
 		ENGINE_API RenderTexture* GetTexture();
+
+		/// <summary>
+		/// Fraction of logarithmic (as opposed to uniform) distribution of cascade splits, in range 0.0-1.0
+		/// </summary>
+		float CascadeSplitLambda = 0.75f;
+
+		/// <summary>
+		/// Frames a mesh has to remain still for before it is cached as a static caster
+		/// </summary>
+		unsigned int StaticCasterFrames = 30;
+
+		/// <summary>
+		/// Forces all shadow map tiles to be redrawn next frame
+		/// </summary>
+		ENGINE_API void Invalidate();
 	};
 }
\ No newline at end of file
@@ -1,15 +1,28 @@
 #pragma once
 #include <Engine/Graphics/Shader.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
+#include <Engine/Graphics/UniformBuffer.hpp>
 #include <Engine/Graphics/RenderPipeline.hpp>
 #include <Engine/Graphics/EnvironmentMap.hpp>
 
 namespace Engine::Graphics
 {
+	/// <summary>
+	/// Environment lighting laid out to match the std140 'EnvironmentData' uniform block in Light.inc
+	/// </summary>
+	struct EnvironmentUniformBlock
+	{
+		/// <summary>
+		/// Coefficients of IrradianceSH, padded to vec4
+		/// </summary>
+		glm::vec4 IrradianceSH[9];
+	};
+
 	class Skybox
 	{ 
 		Shader* m_Shader;
 		ResourceID m_ShaderID;
+		UniformBuffer m_EnvironmentBuffer;
 
 	public:
 		/// <summary>
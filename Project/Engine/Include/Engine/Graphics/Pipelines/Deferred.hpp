@@ -6,13 +6,20 @@ namespace Engine::Graphics::Pipelines
 {
 	class DeferredRenderPipeline : public RenderPipeline
 	{
-		Framebuffer *m_MeshPass, *m_LightingPass, *m_ForwardPass;
 		ResourceID m_MeshShader, m_LightingShader, m_ForwardShader;
 
+		/// <summary>
+		/// Renders point & spot lights additively as proxy geometry, one instanced draw per light type
+		/// </summary>
+		ResourceID m_LightVolumeShader;
+
 		void MeshPass(Framebuffer* previous);
 		void ForwardPass(Framebuffer* previous);
 		void LightingPass(Framebuffer* previous);
 
+		void DrawLightVolumes();
+		void FillGBufferSamplers(Shader* shader);
+
 	public:
 		ENGINE_API DeferredRenderPipeline();
 		ENGINE_API ~DeferredRenderPipeline();
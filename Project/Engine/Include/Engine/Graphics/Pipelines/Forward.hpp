@@ -7,11 +7,23 @@ namespace Engine::Graphics::Pipelines
 	class ForwardRenderPipeline : public RenderPipeline
 	{
 		ResourceID m_ForwardShader = InvalidResourceID;
-		Framebuffer* m_ForwardPass = nullptr;
+		ResourceID m_DepthPrepassShader = InvalidResourceID;
 
 		void ForwardPass(Framebuffer* previous);
+
+		/// <summary>
+		/// Writes depth of opaque meshes without colour
+		/// </summary>
+		/// <returns>False if the pre-pass shader is unavailable & depth was not written</returns>
+		bool DrawDepthPrepass();
 		
 	public:
+		/// <summary>
+		/// Draws opaque depth first, so the lighting shader only runs on the nearest surface of each pixel.
+		/// Reduces the cost of overdraw in dense scenes, at the cost of drawing opaque meshes twice.
+		/// </summary>
+		bool EnableDepthPrepass = false;
+
 		ENGINE_API ForwardRenderPipeline();
 		ENGINE_API ~ForwardRenderPipeline();
 
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/RenderTexture.hpp>
+
+namespace Engine::Graphics
+{
+	// Forward declarations
+	class Framebuffer;
+	struct RenderPipelinePass;
+
+	/// <summary>
+	/// Screen sized texture created by the render graph for passes that draw to it
+	/// </summary>
+	struct ENGINE_API RenderGraphTexture
+	{
+		/// <summary>
+		/// Passes writing or reading the same name share the texture
+		/// </summary>
+		std::string Name;
+
+		TextureFormat Format = TextureFormat::RGBA16F;
+		TexturePixelType PixelType = TexturePixelType::Float;
+	};
+
+	/// <summary>
+	/// Creates framebuffers for render pipeline passes from the textures they declare as written & read.
+	/// Passes whose output is never read are culled, and textures with lifetimes that don't overlap share memory.
+	/// Passes that don't declare any writes keep their own framebuffer and are always drawn.
+	/// </summary>
+	class RenderGraph
+	{
+		struct AllocatedTexture
+		{
+			RenderTexture* Texture;
+
+			/// <summary>
+			/// Index of the last pass using the texture, it can be aliased by any texture first used after this
+			/// </summary>
+			unsigned int LastUse;
+		};
+
+		bool m_Dirty = true;
+		std::vector<Framebuffer*> m_Framebuffers;
+		std::vector<AllocatedTexture> m_Allocated;
+		std::unordered_map<std::string, RenderTexture*> m_Textures;
+
+		void Release();
+
+	public:
+		RenderGraph() = default;
+		ENGINE_API ~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator =(const RenderGraph&) = delete;
+
+		/// <summary>
+		/// Culls passes, allocates textures & sets the framebuffer of each pass declaring writes.
+		/// Culled passes have their framebuffer set to nullptr.
+		/// </summary>
+		ENGINE_API void Compile(std::vector<RenderPipelinePass>& passes, glm::ivec2 resolution);
+
+		/// <summary>
+		/// Flags the graph to be compiled again, e.g. when passes are added or the screen is resized
+		/// </summary>
+		ENGINE_API void SetDirty();
+		ENGINE_API bool IsDirty();
+
+		/// <returns>Texture allocated for name, or nullptr if no drawn pass writes it</returns>
+		ENGINE_API RenderTexture* GetTexture(const std::string& name);
+
+		/// <returns>Amount of textures created, lower than the amount used by passes when any share memory</returns>
+		ENGINE_API unsigned int GetAllocatedTextureCount();
+	};
+}
\ No newline at end of file
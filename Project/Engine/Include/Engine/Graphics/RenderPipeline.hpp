@@ -4,8 +4,11 @@
 #include <Engine/Api.hpp>
 #include <Engine/ResourceID.hpp>
 #include <Engine/Components/Camera.hpp>
+#include <Engine/Graphics/RenderGraph.hpp>
 
-#define MAX_LIGHTS 32
+// Must match MaxShadowMaps & ShadowCascadeCount in Light.inc
+#define MAX_SHADOW_MAPS 32
+#define SHADOW_CASCADE_COUNT 4
 
 namespace Engine::Graphics
 {
@@ -14,6 +17,37 @@ namespace Engine::Graphics
 	class Skybox;
 	class Framebuffer;
 	class ShadowMapPass;
+	class LightClusters;
+	class OcclusionCulling;
+	class UniformBuffer;
+
+	/// <summary>
+	/// Per-frame data laid out to match the std140 'FrameData' uniform block in Camera.inc
+	/// </summary>
+	struct FrameUniformBlock
+	{
+		glm::vec2 Resolution;
+		float Time;
+		float DeltaTime;
+	};
+
+	/// <summary>
+	/// Light counts & shadow map projections laid out to match the std140 'LightData' uniform block in Light.inc.
+	/// Light data itself is stored in LightClusters.
+	/// </summary>
+	struct LightUniformBlock
+	{
+		int LightCount;
+		int DirectionalLightCount;
+		int ShadowMapCount;
+		int Padding;
+
+		/// <summary>
+		/// Region of the shadow atlas for each shadow map, offset (xy) & size (zw) in texture coordinates
+		/// </summary>
+		glm::vec4 ShadowTiles[MAX_SHADOW_MAPS];
+		glm::mat4 ShadowMatrices[MAX_SHADOW_MAPS];
+	};
 
 	struct ENGINE_API RenderPipelinePass
 	{
@@ -23,22 +57,48 @@ namespace Engine::Graphics
 		Framebuffer* Pass = nullptr;
 		std::function<void(Framebuffer* previous)> DrawCallback = nullptr;
 		bool ResizeWithScreen = true;
+
+		/// <summary>
+		/// Render graph textures drawn to, colour attachments in order then depth.
+		/// When not empty the render graph creates Pass, and culls it if nothing reads these.
+		/// </summary>
+		std::vector<RenderGraphTexture> Writes;
+
+		/// <summary>
+		/// Names of render graph textures sampled or drawn over. A pass loading existing contents of a texture
+		/// it writes must also list it here. When empty, everything written by the previous pass is read.
+		/// </summary>
+		std::vector<std::string> Reads;
 	};
 
 	class ENGINE_API RenderPipeline
 	{
 		Skybox* m_Skybox = nullptr;
 		ShadowMapPass* m_ShadowPass = nullptr;
+		LightClusters* m_LightClusters = nullptr;
+		OcclusionCulling* m_OcclusionCulling = nullptr;
+
+		UniformBuffer* m_FrameBuffer = nullptr;
+		UniformBuffer* m_CameraBuffer = nullptr;
+		UniformBuffer* m_LightBuffer = nullptr;
 
 	protected:
 		Shader* m_CurrentShader = nullptr;
+		Engine::Components::Camera* m_CurrentCamera = nullptr;
+		Framebuffer* m_CurrentPass = nullptr;
 		Framebuffer* m_PreviousPass = nullptr;
 		std::vector<RenderPipelinePass> m_RenderPasses;
+		RenderGraph m_Graph;
 
 	public:
 		RenderPipeline();
 		virtual ~RenderPipeline();
 
+		/// <summary>
+		/// Uploads per-frame and light data shared by all cameras, call once per frame before drawing
+		/// </summary>
+		void BeginFrame();
+
 		void Draw(Engine::Components::Camera& camera);
 
 		/// <returns>The texture of the last render pass' output</returns>
@@ -49,15 +109,25 @@ namespace Engine::Graphics
 		std::vector<RenderPipelinePass>& GetAllRenderPasses();
 
 		virtual void RemovePass(Framebuffer* pass);
+		virtual void RemovePass(const std::string& name);
 		virtual void AddPass(RenderPipelinePass& passInfo);
 		
 		virtual void OnResized(glm::ivec2 resolution);
 
 		Shader* CurrentShader();
+
+		/// <returns>Camera being drawn, or nullptr outside of Draw</returns>
+		Engine::Components::Camera* CurrentCamera();
+
+		/// <returns>Framebuffer of the pass being drawn, or nullptr outside of Draw</returns>
+		Framebuffer* GetCurrentPass();
 		Framebuffer* GetPreviousPass();
 		virtual Framebuffer* GetMainMeshPass() { return GetPassAt(0); }
 
 		Skybox* GetSkybox();
 		ShadowMapPass* GetShadowMapPass();
+		LightClusters* GetLightClusters();
+		OcclusionCulling* GetOcclusionCulling();
+		RenderGraph& GetRenderGraph();
 	};
 }
\ No newline at end of file
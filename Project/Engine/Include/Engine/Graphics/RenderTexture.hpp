@@ -13,6 +13,8 @@ namespace Engine::Graphics
 		// Colour
 		RGB8,
 		RGBA8,
+		RG8,
+		RG16,
 		RG16F,
 		RGBA16,
 		RGBA16F,
@@ -7,6 +7,7 @@
 #include <Engine/ResourceID.hpp>
 #include <Engine/Graphics/Mesh.hpp>
 #include <Engine/Graphics/Gizmos.hpp>
+#include <Engine/Graphics/MeshBuffer.hpp>
 #include <Engine/Services/Service.hpp>
 #include <Engine/Graphics/Material.hpp>
 #include <Engine/Graphics/RenderPipeline.hpp>
@@ -18,7 +19,11 @@ namespace Engine::Graphics
 	struct ENGINE_API DrawCall
 	{
 		ResourceID Mesh;
-		Material Material;
+
+		/// <summary>
+		/// MaterialInstance to draw with, see Material::GetInstance
+		/// </summary>
+		ResourceID Material;
 
 		glm::vec3 Position = { 0, 0, 0 };
 		glm::vec3 Scale = { 1, 1, 1 };
@@ -37,6 +42,7 @@ namespace Engine::Graphics
 			Rotation = other.Rotation;
 			Material = other.Material;
 			Position = other.Position;
+			LineWidth = other.LineWidth;
 			DeleteMeshAfterRender = other.DeleteMeshAfterRender;
 			return *this;
 		}
@@ -44,7 +50,7 @@ namespace Engine::Graphics
 		bool operator ==(const DrawCall& b)
 		{
 			return Mesh == b.Mesh &&
-				// Material == b.Material &&
+				Material == b.Material &&
 				Position == b.Position &&
 				Scale == b.Scale &&
 				Rotation == b.Rotation &&
@@ -60,6 +66,12 @@ namespace Engine::Graphics
 		bool RenderOpaque = true;
 		bool RenderTransparent = true;
 		DrawSortType DrawSorting = DrawSortType::None;
+
+		/// <summary>
+		/// Skip draw calls hidden behind the depth of the previous frame, see OcclusionCulling.
+		/// Only valid for passes drawing from the current camera's view.
+		/// </summary>
+		bool OcclusionCull = false;
 	};
 
 	class Renderer
@@ -69,11 +81,57 @@ namespace Engine::Graphics
 		/// </summary>
 		const unsigned int MaxInstances = 10000;
 
+		/// <summary>
+		/// Shared mesh & material pair, in draw queue order, used to detect when indirect commands need rebuilding
+		/// </summary>
+		struct IndirectDrawKey
+		{
+			ResourceID Mesh;
+			ResourceID Material;
+
+			bool operator ==(const IndirectDrawKey& other) const { return Mesh == other.Mesh && Material == other.Material; }
+		};
+
+		/// <summary>
+		/// Consecutive indirect commands drawn with equivalent materials
+		/// </summary>
+		struct IndirectGroup
+		{
+			ResourceID Material;
+			unsigned int FirstCommand;
+			unsigned int CommandCount;
+		};
+
+		/// <summary>
+		/// Indirect commands persist between draws, only rebuilt when the set of shared meshes submitted changes
+		/// </summary>
+		struct IndirectState
+		{
+			std::vector<IndirectDrawKey> Keys;
+			std::vector<IndirectGroup> Groups;
+			std::vector<DrawElementsIndirectCommand> Commands;
+
+			// Indexed by command
+			std::vector<ResourceID> CommandMaterials;
+			std::vector<glm::mat4> Matrices;
+			std::vector<glm::vec4> BoundingSpheres;
+			std::vector<glm::vec4> BoundingBoxes; // World space (min, max), two per command
+
+			/// <summary>
+			/// Command index of each key
+			/// </summary>
+			std::vector<unsigned int> KeyCommands;
+		};
+
 		glm::ivec2 m_Resolution;
 		RenderTexture* m_EmptyTexture;
 		bool m_Wireframe, m_VSync;
 		RenderPipeline* m_Pipeline;
+		bool m_SupportsCompute;
 		bool m_SupportsTessellation;
+		bool m_SupportsMultiDrawIndirect;
+		MeshBuffer* m_MeshBuffer;
+		IndirectState m_Indirect;
 		Components::Camera* m_MainCamera;
 		float m_Time, m_FPS, m_DeltaTime;
 		std::vector<DrawCall> m_DrawQueue;
@@ -87,6 +145,12 @@ namespace Engine::Graphics
 		static void Resized(glm::ivec2 newResolution);
 		static void SortDrawQueue(DrawSortType sortType);
 
+		/// <summary>
+		/// Draws shared meshes in the queue with one multi draw indirect call per material
+		/// </summary>
+		static void DrawIndirect(DrawArgs& args, Shader* shader);
+		static void RebuildIndirectCommands(std::vector<IndirectDrawKey>& keys);
+
 		Renderer();
 		~Renderer();
 
@@ -97,6 +161,7 @@ namespace Engine::Graphics
 
 		ENGINE_API static void ClearDrawQueue();
 		ENGINE_API static void Submit(DrawCall drawCall);
+		ENGINE_API static void Submit(ResourceID& mesh, ResourceID material, Components::Transform* transform);
 		ENGINE_API static void Submit(ResourceID& mesh, Material& material, Components::Transform* transform);
 		ENGINE_API static void Submit(ResourceID& mesh, Material& material, glm::vec3 position, glm::vec3 scale, glm::mat4 rotation);
 		ENGINE_API static void Submit(ResourceID& mesh, Material& material, glm::vec3 position, glm::vec3 scale, glm::vec3 rotation);
@@ -141,11 +206,26 @@ namespace Engine::Graphics
 		/// </summary>
 		ENGINE_API static RenderTexture* GetEmptyTexture();
 
+		/// <summary>
+		/// Vertex & index storage for all shared meshes, see Mesh::SetShared
+		/// </summary>
+		ENGINE_API static MeshBuffer* GetMeshBuffer();
+
 		/// <summary>
 		/// If the current hardware supports the tessellation feature (OpenGL 4.0+
 		/// </summary>
 		/// <returns></returns>
 		ENGINE_API static bool SupportsTessellation();
+
+		/// <summary>
+		/// If the current hardware supports compute shaders & image load/store (OpenGL 4.3+)
+		/// </summary>
+		ENGINE_API static bool SupportsCompute();
+
+		/// <summary>
+		/// If the current hardware supports glMultiDrawElementsIndirect with base instances (OpenGL 4.3+)
+		/// </summary>
+		ENGINE_API static bool SupportsMultiDrawIndirect();
 #pragma endregion
 	};
 }
@@ -1,6 +1,8 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <filesystem>
 #include <glm/glm.hpp>
 #include <Engine/Api.hpp>
@@ -29,6 +31,41 @@ namespace Engine::Graphics
 		}
 	};
 
+	/// <summary>
+	/// Binding points of uniform blocks shared between all shader programs
+	/// </summary>
+	enum class UniformBlockBinding : unsigned int
+	{
+		Material = 0,
+		Frame,
+		Camera,
+		Lights,
+		Environment
+	};
+
+	/// <summary>
+	/// FNV-1a hash of a uniform name, usable at compile time
+	/// </summary>
+	constexpr uint64_t HashUniformName(const char* name)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (; *name; name++)
+			hash = (hash ^ (uint64_t)(unsigned char)*name) * 1099511628211ull;
+		return hash;
+	}
+
+	/// <summary>
+	/// Uniform name hashed at compile time. Locations are resolved per shader program,
+	/// so a handle remains valid after the program is recreated.
+	/// </summary>
+	struct UniformHandle
+	{
+		const char* Name;
+		uint64_t Hash;
+
+		explicit constexpr UniformHandle(const char* name) : Name(name), Hash(HashUniformName(name)) { }
+	};
+
 	struct ENGINE_API ShaderUniform
 	{		
 		int Location = -1;
@@ -44,14 +81,27 @@ namespace Engine::Graphics
 		std::vector<ShaderUniform> m_Uniforms = { {} };
 		EngineUnorderedMap<std::string, FileWatcher*> m_Watchers;
 
-#if USE_STRING_ID
-		EngineUnorderedMap<StringId::Storage, ShaderUniform*> m_NamedUniforms;
-#else
-		EngineUnorderedMap<std::string, ShaderUniform*> m_NamedUniforms;
-#endif
+		/// <summary>
+		/// Active uniforms keyed by the hash of their name, rebuilt whenever the program is (re)created
+		/// </summary>
+		EngineUnorderedMap<uint64_t, ShaderUniform*> m_NamedUniforms;
+
+		/// <summary>
+		/// Locations resolved through UniformHandles, indexed by the low bits of their hash.
+		/// Repeated sets of the same handle skip m_NamedUniforms, inactive uniforms are cached as location -1.
+		/// </summary>
+		struct CachedLocation
+		{
+			uint64_t Hash = 0;
+			int Location = -1;
+		};
+		std::array<CachedLocation, 64> m_HandleLocations;
+
+		int& GetLocation(const UniformHandle& handle);
 
 		void Destroy();
 		void CreateShaders();
+		void BindUniformBlocks();
 		void CacheUniformLocations();
 		void WatchShader(std::string path, bool watch = true);
 		unsigned int CreateShader(const std::string & source, const unsigned int type);
@@ -81,20 +131,33 @@ namespace Engine::Graphics
 		ENGINE_API void Set(int& location, glm::mat3 value) const;
 		ENGINE_API void Set(int& location, glm::mat4 value) const;
 
-		ENGINE_API void Set(std::string locationName, int value);
-		ENGINE_API void Set(std::string locationName, bool value);
-		ENGINE_API void Set(std::string locationName, float value);
-		ENGINE_API void Set(std::string locationName, double value);
-		ENGINE_API void Set(std::string locationName, glm::vec2 value);
-		ENGINE_API void Set(std::string locationName, glm::vec3 value);
-		ENGINE_API void Set(std::string locationName, glm::vec4 value);
-		ENGINE_API void Set(std::string locationName, glm::mat3 value);
-		ENGINE_API void Set(std::string locationName, glm::mat4 value);
+		ENGINE_API void Set(const std::string& locationName, int value);
+		ENGINE_API void Set(const std::string& locationName, bool value);
+		ENGINE_API void Set(const std::string& locationName, float value);
+		ENGINE_API void Set(const std::string& locationName, double value);
+		ENGINE_API void Set(const std::string& locationName, glm::vec2 value);
+		ENGINE_API void Set(const std::string& locationName, glm::vec3 value);
+		ENGINE_API void Set(const std::string& locationName, glm::vec4 value);
+		ENGINE_API void Set(const std::string& locationName, glm::mat3 value);
+		ENGINE_API void Set(const std::string& locationName, glm::mat4 value);
+
+		ENGINE_API void Set(const UniformHandle& handle, int value);
+		ENGINE_API void Set(const UniformHandle& handle, bool value);
+		ENGINE_API void Set(const UniformHandle& handle, float value);
+		ENGINE_API void Set(const UniformHandle& handle, double value);
+		ENGINE_API void Set(const UniformHandle& handle, glm::vec2 value);
+		ENGINE_API void Set(const UniformHandle& handle, glm::vec3 value);
+		ENGINE_API void Set(const UniformHandle& handle, glm::vec4 value);
+		ENGINE_API void Set(const UniformHandle& handle, glm::mat3 value);
+		ENGINE_API void Set(const UniformHandle& handle, glm::mat4 value);
 
 		/// <returns>Information about the uniform at location, or an invalid struct if outside of bounds</returns>
 		ENGINE_API ShaderUniform* GetUniformInfo(int location);
 
 		/// <returns>Information about the uniform at locationName, or an invalid struct if not found</returns>
-		ENGINE_API ShaderUniform* GetUniformInfo(std::string& locationName);
+		ENGINE_API ShaderUniform* GetUniformInfo(const std::string& locationName);
+
+		/// <returns>Information about the uniform referenced by handle, or nullptr if not active in this program</returns>
+		ENGINE_API ShaderUniform* GetUniformInfo(const UniformHandle& handle);
 	};
 }
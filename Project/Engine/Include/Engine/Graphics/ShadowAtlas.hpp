@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include <Engine/Api.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Quadtree allocator of square, power of two, tiles inside a single square texture
+	/// </summary>
+	class ShadowAtlas
+	{
+		struct Node
+		{
+			glm::ivec2 Offset;
+			unsigned int Size;
+
+			/// <summary>
+			/// Index of first of four consecutive child nodes, or -1 if not split
+			/// </summary>
+			int Children = -1;
+
+			bool Used = false;
+		};
+
+		unsigned int m_Size;
+		unsigned int m_MinTileSize;
+		std::vector<Node> m_Nodes;
+
+		bool Allocate(unsigned int nodeIndex, unsigned int size, glm::ivec4& outTile);
+		bool Free(unsigned int nodeIndex, const glm::ivec4& tile);
+
+	public:
+		ENGINE_API ShadowAtlas(unsigned int size = 4096, unsigned int minTileSize = 128);
+
+		/// <summary>
+		/// Frees all tiles and changes the size of the atlas
+		/// </summary>
+		ENGINE_API void Reset(unsigned int size);
+
+		/// <summary>
+		/// Frees all tiles
+		/// </summary>
+		ENGINE_API void Clear();
+
+		/// <summary>
+		/// Finds a free tile, size is rounded up to a power of two
+		/// </summary>
+		/// <param name="outTile">Offset (xy) & size (zw) in texels</param>
+		/// <returns>False if there is no free space for a tile of this size</returns>
+		ENGINE_API bool Allocate(unsigned int size, glm::ivec4& outTile);
+
+		/// <summary>
+		/// Returns a tile given by Allocate to the atlas, merging quadrants that are entirely free again
+		/// </summary>
+		ENGINE_API void Free(const glm::ivec4& tile);
+
+		ENGINE_API unsigned int GetSize();
+		ENGINE_API unsigned int GetMinTileSize();
+
+		/// <summary>
+		/// Closest power of two tile size to represent size, clamped to the valid tile range
+		/// </summary>
+		ENGINE_API unsigned int GetTileSize(unsigned int size);
+	};
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <memory>
 #include <glad/glad.h>
 #include <Engine/Api.hpp>
 
@@ -9,27 +11,167 @@ namespace Engine::Graphics
 	{
 		bool HDR = false;
 		bool FlipVertically = false;
+
+		/// <summary>
+		/// Cooks a block compressed copy with precomputed mips beside the source, used on later loads.
+		/// Ignored for HDR textures.
+		/// </summary>
+		bool Compress = true;
+
+		/// <summary>
+		/// Tangent space normals, cooked to two channels (BC5) with renormalised mips.
+		/// Shaders rebuild Z from X & Y, see SampleNormalMap in Material.inc.
+		/// </summary>
+		bool NormalMap = false;
+
 		GLenum Wrap		 = GL_REPEAT;
 		GLenum MinFilter = GL_LINEAR;
 		GLenum MagFilter = GL_LINEAR;
 	};
 
+	class TextureResidency;
+
+	/// <summary>
+	/// Image file decoded, or read from its cooked cache, on a worker thread as soon as it is created,
+	/// then streamed to the GPU through a pixel buffer over the following frames.
+	/// Binding a texture that is not resident binds Renderer::GetEmptyTexture instead.
+	/// Which mip levels stay resident is decided by TextureResidency.
+	/// </summary>
 	class Texture
 	{
 		unsigned int m_ID;
 		std::string m_Path;
 		TextureArgs m_Args;
 
-		void GenerateImage();
+		/// <summary>
+		/// Decoded image shared with the worker thread, defined in Texture.cpp.
+		/// Decoded pixels are released once uploaded, a cooked texture stays mapped to stream mip levels in & out.
+		/// </summary>
+		struct DecodeState;
+		std::shared_ptr<DecodeState> m_Decode;
+		bool m_Failed;
+
+		/// <summary>
+		/// True while decoding or uploading, see s_Streaming
+		/// </summary>
+		bool m_Streaming;
+
+		/// <summary>
+		/// Texture being uploaded, replaces m_ID once complete
+		/// </summary>
+		unsigned int m_UploadID;
+		unsigned int m_PixelBuffer;
+
+		/// <summary>
+		/// Rows uploaded from decoded pixels, or mip levels uploaded from a cooked texture
+		/// </summary>
+		unsigned int m_UploadProgress;
+		GLsync m_UploadFence;
+
+		/// <summary>
+		/// First mip level of the cooked texture stored in m_ID, higher levels are lower resolution
+		/// </summary>
+		unsigned int m_ResidentLevel;
+
+		/// <summary>
+		/// First mip level stored by the next upload
+		/// </summary>
+		unsigned int m_TargetLevel;
+		size_t m_ResidentSize;
+
+		/// <summary>
+		/// Frame last bound & count of binds made before resident, used to order uploads
+		/// </summary>
+		unsigned int m_LastUsedFrame;
+		unsigned int m_RequestCount;
+
+		/// <summary>
+		/// Finest mip level requested during m_RequestedFrame, see TextureResidency::Request
+		/// </summary>
+		unsigned int m_RequestedFrame;
+		unsigned int m_RequestedLevel;
+
+		static unsigned int s_Frame;
+
+		/// <summary>
+		/// All textures loaded from a file
+		/// </summary>
+		static std::vector<Texture*> s_Textures;
+		static std::vector<Texture*> s_Streaming;
+
+		friend class TextureResidency;
+
+		void BeginDecode();
+
+		/// <summary>
+		/// Streams in a cooked texture starting at mip level, replacing the resident texture once complete
+		/// </summary>
+		void BeginUpload(unsigned int level);
+
+		/// <summary>
+		/// Copies data into the pixel buffer & transfers it to the texture, up to byteBudget bytes
+		/// </summary>
+		/// <returns>True once uploading has finished or failed</returns>
+		bool ContinueUpload(size_t& byteBudget);
+
+		/// <summary>
+		/// Copies size bytes of data into the pixel buffer at offset
+		/// </summary>
+		/// <returns>Pointer to pass to glTexSubImage2D & glCompressedTexImage2D</returns>
+		const void* StagePixels(const unsigned char* data, size_t offset, size_t size);
+
+		/// <returns>True once all rows or levels have been transferred</returns>
+		bool UploadRows(size_t& byteBudget);
+		bool UploadLevels(size_t& byteBudget);
+		void FinishUpload();
+
+		/// <summary>
+		/// Releases the resident texture & decoded data, the texture is streamed in again when next bound
+		/// </summary>
+		void Evict();
+
+		/// <returns>True if decoded & backed by a cooked cache, required to change resident mip levels</returns>
+		bool IsCooked();
+
+		/// <returns>Mip levels in the cooked cache, or 1</returns>
+		unsigned int GetMipCount();
+
+		/// <returns>Largest dimension of a cooked mip level, in pixels</returns>
+		unsigned int GetLevelResolution(unsigned int level);
+
+		/// <returns>Approximate video memory used when level is the first resident mip level</returns>
+		size_t GetSize(unsigned int level);
 
 	public:
+		/// <summary>
+		/// Bytes of decoded pixels copied to the GPU each frame
+		/// </summary>
+		static constexpr size_t UploadBudget = 8 * 1024 * 1024;
+
 		ENGINE_API Texture();
 		ENGINE_API Texture(std::string path, TextureArgs args = {});
 		ENGINE_API ~Texture();
 
+		/// <returns>GL_INVALID_VALUE until uploaded</returns>
 		ENGINE_API unsigned int GetID();
 		ENGINE_API std::string GetPath();
+
+		/// <summary>
+		/// True once decoded, uploaded and mipmapped
+		/// </summary>
+		ENGINE_API bool IsReady();
+
+		/// <summary>
+		/// Blocks until decoded then uploads all remaining data, for textures needed immediately
+		/// </summary>
+		ENGINE_API void Wait();
 		
 		ENGINE_API void Bind(unsigned int index = 0);
+
+		/// <summary>
+		/// Uploads decoded textures, starting with those most recently & most often bound while not ready.
+		/// Called once per frame by the application.
+		/// </summary>
+		ENGINE_API static void UpdateStreaming(size_t byteBudget = UploadBudget);
 	};
 }
\ No newline at end of file
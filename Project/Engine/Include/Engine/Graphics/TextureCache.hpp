@@ -0,0 +1,148 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+#include <Engine/Api.hpp>
+#include <Engine/MappedFile.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Block compressed texture with a precomputed mip chain, cooked from a decoded image and
+	/// stored beside the source file. Cached files are memory mapped & uploaded without being copied.
+	/// 
+	/// Layout is a Header, the MipLevel table, then the 16 byte aligned blocks of each level.
+	/// </summary>
+	class TextureCache
+	{
+	public:
+		enum class Format : uint32_t
+		{
+			/// <summary>
+			/// RGB at 4 bits per pixel, also used for RGBA images that are fully opaque
+			/// </summary>
+			BC1,
+
+			/// <summary>
+			/// RGBA at 8 bits per pixel
+			/// </summary>
+			BC3,
+
+			/// <summary>
+			/// Single channel at 4 bits per pixel
+			/// </summary>
+			BC4,
+
+			/// <summary>
+			/// Two channels at 8 bits per pixel
+			/// </summary>
+			BC5
+		};
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+
+			// Source file when cooked. Content hash is only compared when size or write time have changed.
+			uint64_t SourceSize;
+			int64_t SourceWriteTime;
+			uint64_t SourceHash;
+
+			uint32_t Format;
+			uint32_t Width;
+			uint32_t Height;
+			uint32_t MipCount;
+
+			/// <summary>
+			/// Source was flipped vertically before cooking
+			/// </summary>
+			uint32_t Flipped;
+
+			/// <summary>
+			/// Cooked as a normal map, storing X & Y only
+			/// </summary>
+			uint32_t NormalMap;
+		};
+
+		struct MipLevel
+		{
+			// Offset from the start of the file
+			uint64_t Offset;
+			uint64_t Size;
+
+			uint32_t Width;
+			uint32_t Height;
+		};
+
+		/// <summary>
+		/// Increment when the layout or encoding changes, older caches are cooked again
+		/// </summary>
+		static const uint32_t Version = 2;
+
+	private:
+		MappedFile m_File;
+
+		/// <summary>
+		/// Contents of a cache cooked this session until it is saved, in the same layout as the file
+		/// </summary>
+		std::vector<unsigned char> m_Memory;
+
+		const unsigned char* m_Data;
+		size_t m_Size;
+		const Header* m_Header;
+		const MipLevel* m_Levels;
+
+		bool Validate(std::string& sourcePath, bool flipped, bool normalMap);
+
+	public:
+		ENGINE_API TextureCache();
+
+		TextureCache(const TextureCache&) = delete;
+		TextureCache& operator =(const TextureCache&) = delete;
+
+		/// <summary>
+		/// Maps a cache file, safe to call from any thread
+		/// </summary>
+		/// <returns>False if the cache is missing, corrupt, from another version or the source file has changed</returns>
+		ENGINE_API bool Open(std::string cachePath, std::string sourcePath, bool flipped, bool normalMap);
+
+		/// <summary>
+		/// Generates mips & block compresses a decoded 8-bit image, splitting blocks across worker threads.
+		/// Safe to call from any thread, the result is kept in memory until Save is called.
+		/// </summary>
+		/// <param name="pixels">Tightly packed rows of channelCount bytes per pixel</param>
+		/// <param name="normalMap">Tangent space normals with at least three channels are cooked to BC5, with each mip renormalised</param>
+		ENGINE_API bool Cook(
+			const unsigned char* pixels,
+			unsigned int width,
+			unsigned int height,
+			unsigned int channelCount,
+			std::string sourcePath,
+			bool flipped,
+			bool normalMap);
+
+		/// <summary>
+		/// Writes a cooked cache to disk, safe to call from any thread.
+		/// Once written the cache is read from the mapped file and the cooked copy in memory is released.
+		/// </summary>
+		ENGINE_API bool Save(std::string cachePath);
+		ENGINE_API void Close();
+
+		ENGINE_API bool IsOpen() const;
+		ENGINE_API Format GetFormat() const;
+		ENGINE_API unsigned int GetMipCount() const;
+		ENGINE_API const MipLevel& GetLevel(unsigned int index) const;
+
+		/// <returns>Entire cache, level offsets are relative to this</returns>
+		ENGINE_API const unsigned char* GetData() const;
+		ENGINE_API size_t GetSize() const;
+
+		/// <returns>Compressed internal format passed to glCompressedTexImage2D</returns>
+		ENGINE_API static GLenum GetInternalFormat(Format format);
+
+		/// <returns>Bytes per 4x4 block</returns>
+		ENGINE_API static unsigned int GetBlockSize(Format format);
+	};
+}
\ No newline at end of file
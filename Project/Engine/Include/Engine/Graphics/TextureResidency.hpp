@@ -0,0 +1,56 @@
+#pragma once
+#include <Engine/Api.hpp>
+#include <Engine/ResourceID.hpp>
+#include <Engine/Graphics/Texture.hpp>
+#include <Engine/Graphics/Material.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Keeps textures loaded from files within a video memory budget.
+	/// Each frame textures request the mip level needed for the screen size of what they are drawn on,
+	/// cooked textures stream in finer levels as they are requested. When over budget the least recently
+	/// used textures drop their finest levels, then unused textures are evicted until bound again.
+	/// </summary>
+	class TextureResidency
+	{
+		static size_t s_Budget;
+		static size_t s_ResidentSize;
+
+	public:
+		static constexpr size_t DefaultBudget = 512ull * 1024 * 1024;
+
+		/// <summary>
+		/// Frames since last bound before a texture can be evicted
+		/// </summary>
+		static constexpr unsigned int UnusedFrames = 120;
+
+		/// <summary>
+		/// Cooked textures are never reduced below the mip level with this resolution
+		/// </summary>
+		static constexpr unsigned int MinResolution = 64;
+
+		/// <param name="bytes">Video memory available to textures loaded from files</param>
+		ENGINE_API static void SetBudget(size_t bytes);
+		ENGINE_API static size_t GetBudget();
+
+		/// <returns>Approximate video memory used by resident textures, as of the last Update</returns>
+		ENGINE_API static size_t GetResidentSize();
+
+		/// <summary>
+		/// Requests the mip level of texture with roughly one texel per pixel when spanning screenPixels
+		/// </summary>
+		ENGINE_API static void Request(ResourceID texture, float screenPixels);
+
+		/// <summary>
+		/// Requests each texture of material, accounting for texture coordinate scale
+		/// </summary>
+		ENGINE_API static void Request(Material& material, float screenPixels);
+
+		/// <summary>
+		/// Streams in requested mip levels, reducing or evicting the least recently used textures when over budget.
+		/// Called once per frame by the application.
+		/// </summary>
+		ENGINE_API static void Update();
+	};
+}
\ No newline at end of file
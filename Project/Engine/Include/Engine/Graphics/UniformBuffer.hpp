@@ -0,0 +1,39 @@
+#pragma once
+#include <Engine/Api.hpp>
+#include <Engine/Graphics/Shader.hpp>
+
+namespace Engine::Graphics
+{
+	/// <summary>
+	/// Uniform buffer object attached to a shared binding point, visible to every shader declaring the matching block
+	/// </summary>
+	class UniformBuffer
+	{
+		unsigned int m_ID;
+		unsigned int m_Size;
+		UniformBlockBinding m_Binding;
+
+		void Create();
+
+	public:
+		ENGINE_API UniformBuffer(UniformBlockBinding binding, unsigned int size);
+		ENGINE_API ~UniformBuffer();
+
+		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer& operator =(const UniformBuffer&) = delete;
+
+		/// <summary>
+		/// Uploads data to the buffer, creating the buffer object if required
+		/// </summary>
+		ENGINE_API void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+		/// <summary>
+		/// Attaches this buffer to its binding point
+		/// </summary>
+		ENGINE_API void Bind();
+
+		ENGINE_API unsigned int GetID();
+		ENGINE_API unsigned int GetSize();
+		ENGINE_API UniformBlockBinding GetBinding();
+	};
+}
\ No newline at end of file
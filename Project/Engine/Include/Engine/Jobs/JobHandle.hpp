@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <Engine/Api.hpp>
+
+namespace Engine::Jobs
+{
+	/// <summary>
+	/// Tracks completion of one or more jobs submitted to the JobSystem
+	/// </summary>
+	class JobHandle
+	{
+		/// <summary>
+		/// Jobs remaining, shared with the JobSystem queue
+		/// </summary>
+		std::shared_ptr<std::atomic_int> m_Remaining;
+
+		friend class JobSystem;
+
+	public:
+		/// <summary>
+		/// Creates a handle which is already complete
+		/// </summary>
+		ENGINE_API JobHandle();
+
+		ENGINE_API bool IsComplete() const;
+
+		/// <summary>
+		/// Blocks until all jobs tracked by this handle have finished.
+		/// The calling thread executes this handle's jobs which are still queued, other jobs are left to workers.
+		/// </summary>
+		ENGINE_API void Wait() const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <Engine/Api.hpp>
+#include <Engine/Jobs/JobHandle.hpp>
+
+namespace Engine { class Application; }
+namespace Engine::Graphics { class EnvironmentBaker; }
+
+namespace Engine::Jobs
+{
+	typedef std::function<void()> JobFunction;
+
+	/// <summary>
+	/// Pool of worker threads executing jobs from a shared queue
+	/// </summary>
+	class JobSystem
+	{
+		struct Job
+		{
+			JobFunction Function;
+			std::shared_ptr<std::atomic_int> Remaining;
+		};
+
+		std::mutex m_QueueMutex;
+		std::deque<Job> m_Queue;
+		std::atomic_bool m_Running;
+		std::vector<std::thread> m_Workers;
+		std::condition_variable m_QueueCondition;
+
+		/// <summary>
+		/// Signalled whenever the last job tracked by a handle finishes
+		/// </summary>
+		std::condition_variable m_CompleteCondition;
+
+		static ENGINE_API JobSystem* s_Instance;
+
+		/// <param name="workerCount">Worker threads to create, 0 creates one less than the hardware thread count</param>
+		JobSystem(unsigned int workerCount = 0);
+		~JobSystem();
+
+		void WorkerLoop();
+
+		/// <summary>
+		/// Executes job & signals waiting threads if it was the last one tracked by its handle
+		/// </summary>
+		void Execute(Job& job);
+
+		/// <summary>
+		/// Pops & executes a single queued job tracked by remaining, ignoring unrelated jobs
+		/// </summary>
+		/// <returns>True if a job was executed</returns>
+		bool ExecuteNext(const std::shared_ptr<std::atomic_int>& remaining);
+
+		/// <summary>
+		/// Executes queued jobs tracked by remaining on the calling thread,
+		/// then blocks until any taken by worker threads have finished
+		/// </summary>
+		void Wait(const std::shared_ptr<std::atomic_int>& remaining);
+
+		friend class JobHandle;
+		friend class Engine::Application;
+		friend class Engine::Graphics::EnvironmentBaker;
+
+	public:
+		/// <summary>
+		/// Queues a job for execution on a worker thread
+		/// </summary>
+		ENGINE_API static JobHandle Submit(JobFunction job);
+
+		/// <summary>
+		/// Executes job for every index in [0, count), split into batches across worker threads.
+		/// Blocks until all indices have been processed, the calling thread takes part in executing batches.
+		/// </summary>
+		/// <param name="batchSize">Indices processed by a single job</param>
+		ENGINE_API static void ParallelFor(unsigned int count, std::function<void(unsigned int index)> job, unsigned int batchSize = 1);
+
+		/// <returns>Amount of worker threads, or 0 when jobs are executed on the calling thread</returns>
+		ENGINE_API static unsigned int GetWorkerCount();
+	};
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include <string>
 #include <exception>
 #include <Engine/Api.hpp>
@@ -8,6 +9,11 @@ namespace Engine
 	class ENGINE_API Log
 	{
 		static int s_LogLevel;
+
+		/// <summary>
+		/// Held while writing, so messages logged from worker threads are not interleaved
+		/// </summary>
+		static std::mutex s_OutputMutex;
 	public:
 		enum class LogLevel : int
 		{
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <Engine/Api.hpp>
+
+namespace Engine
+{
+	/// <summary>
+	/// Read-only view of a file mapped into memory, pages are read by the OS as they are accessed
+	/// </summary>
+	class MappedFile
+	{
+		const unsigned char* m_Data;
+		size_t m_Size;
+
+#if _WIN32
+		void* m_File;
+		void* m_Mapping;
+#else
+		int m_File;
+#endif
+
+	public:
+		ENGINE_API MappedFile();
+		ENGINE_API ~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator =(const MappedFile&) = delete;
+
+		/// <returns>False if the file does not exist or could not be mapped</returns>
+		ENGINE_API bool Open(std::string path);
+		ENGINE_API void Close();
+
+		ENGINE_API bool IsOpen() const { return m_Data != nullptr; }
+		ENGINE_API size_t GetSize() const { return m_Size; }
+		ENGINE_API const unsigned char* GetData() const { return m_Data; }
+
+		/// <returns>Size & last write time of path, or false if it does not exist</returns>
+		ENGINE_API static bool GetFileInfo(std::string path, uint64_t& size, int64_t& writeTime);
+
+		/// <returns>64-bit FNV-1a hash of the file's contents, or 0 if it could not be read</returns>
+		ENGINE_API static uint64_t HashFile(std::string path);
+	};
+}
\ No newline at end of file
@@ -19,6 +19,9 @@ namespace Engine
 		{
 			void* Data;
 			std::type_index Type;
+
+			// Calls the destructor of the stored type, as deleting a void* does not
+			void(*Deleter)(void*);
 		};
 
 		EngineUnorderedMap<ResourceID, ResourceInstance> m_Instances;
@@ -45,7 +48,8 @@ namespace Engine
 				ResourceInstance
 				{
 					nullptr,
-					typeid(T)
+					typeid(T),
+					[](void* data) { delete (T*)data; }
 				});
 			m_Instances.at(id).Data = new T(constructorArgs...);
 			return id;
@@ -1,6 +1,9 @@
 #include <Engine/Application.hpp>
 #include <Engine/Graphics/Gizmos.hpp>
 #include <Engine/ResourceManager.hpp>
+#include <Engine/Graphics/Model.hpp>
+#include <Engine/Graphics/Texture.hpp>
+#include <Engine/Graphics/TextureResidency.hpp>
 #include <Engine/Components/Camera.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
@@ -66,6 +69,9 @@ void Application::Run()
 
 	CreateAppWindow();
 
+	// Create worker threads
+	Jobs::JobSystem::s_Instance = (m_JobSystem = new Jobs::JobSystem());
+
 	// Create Resource Manager instance
 	m_ResourceManager = new ResourceManager();
 
@@ -107,6 +113,14 @@ void Application::Run()
 	while (!glfwWindowShouldClose(m_Window) && m_State == ApplicationState::Running)
 	{
 		float deltaTime = (float)m_Renderer->m_DeltaTime;
+
+		// Upload part of any models loaded on worker threads
+		Model::UpdateAsyncLoads();
+
+		// Choose resident texture mip levels, then upload textures decoded on worker threads
+		TextureResidency::Update();
+		Texture::UpdateStreaming();
+
 		for (auto& pair : m_Services)
 			pair.second->OnUpdate(deltaTime);
 		OnUpdate(deltaTime);
@@ -130,6 +144,8 @@ void Application::Run()
 
 		if (sceneService && sceneService->CurrentScene())
 		{
+			m_Renderer->GetPipeline()->BeginFrame();
+
 			auto cameras = sceneService->CurrentScene()->Root().GetComponentsInChildren<Camera>();
 			for(Camera* camera : cameras)
 				m_Renderer->GetPipeline()->Draw(*camera);
@@ -189,10 +205,12 @@ void Application::Run()
 	OnShutdown();
 
 	delete m_Input;
+	delete m_JobSystem;
 	delete m_ResourceManager;
 
 	m_Input = nullptr;
 	m_Window = nullptr;
+	m_JobSystem = nullptr;
 }
 
 void Application::Exit() { s_Instance->m_State = ApplicationState::Stopping; }
@@ -207,6 +225,7 @@ void Application::UpdateGlobals()
 	Input::s_Instance = m_Input;
 	Gizmos::s_Instance = m_Gizmos;
 	Renderer::s_Instance = m_Renderer;
+	Jobs::JobSystem::s_Instance = m_JobSystem;
 	ImGui::SetCurrentContext(m_ImGuiContext);
 	ResourceManager::s_Instance = m_ResourceManager;
 
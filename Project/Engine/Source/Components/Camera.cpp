@@ -24,14 +24,15 @@ Camera* Camera::GetMainCamera() { return Renderer::GetMainCamera(); }
 mat4 Camera::GetViewMatrix() { return m_ViewMatrix; }
 mat4 Camera::GetProjectionMatrix() { return m_ProjectionMatrix; }
 
-void Camera::FillShader(Shader* shader)
+void Camera::FillUniformBlock(CameraUniformBlock& block)
 {
-	shader->Set("camera.Position", GetTransform()->GetGlobalPosition());
-	shader->Set("camera.ViewMatrix", GetViewMatrix());
-	shader->Set("camera.ProjectionMatrix", GetProjectionMatrix());
+	block.Position = GetTransform()->GetGlobalPosition();
+	block.ViewMatrix = GetViewMatrix();
+	block.ProjectionMatrix = GetProjectionMatrix();
+	block.InverseViewProjectionMatrix = inverse(block.ProjectionMatrix * block.ViewMatrix);
 
-	shader->Set("camera.FarPlane", ClipFar);
-	shader->Set("camera.NearPlane", ClipNear);
+	block.FarPlane = ClipFar;
+	block.NearPlane = ClipNear;
 }
 
 void Camera::Removed()
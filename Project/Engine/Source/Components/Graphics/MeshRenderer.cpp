@@ -1,6 +1,9 @@
 #include <Engine/GameObject.hpp>
+#include <Engine/ResourceManager.hpp>
 #include <Engine/Components/Camera.hpp>
+#include <Engine/Components/Transform.hpp>
 #include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Graphics/TextureResidency.hpp>
 #include <Engine/Components/Graphics/MeshRenderer.hpp>
 
 using namespace glm;
@@ -8,12 +11,60 @@ using namespace Engine;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
+/// <returns>Projected diameter of a sphere as a fraction of the camera's screen height</returns>
+float GetScreenSize(Camera* camera, vec3 centre, float radius)
+{
+	if (camera->Orthographic)
+		return radius / camera->OrthoSize; // OrthoSize is half of the screen height
+
+	float distance = glm::distance(camera->GetTransform()->GetGlobalPosition(), centre);
+	if (distance <= radius)
+		return 1.0f; // Camera is inside bounds
+
+	// Diameter over the screen height at this distance, 2r / (2 * distance * tan(fov / 2))
+	return radius / (distance * tan(radians(camera->FieldOfView) * 0.5f));
+}
+
+ResourceID MeshRenderer::GetLODMesh(MeshInfo& meshInfo)
+{
+	if (meshInfo.LOD == 0)
+		return meshInfo.Mesh;
+
+	Mesh* mesh = ResourceManager::Get<Mesh>(meshInfo.Mesh);
+	if (!mesh || meshInfo.LOD > mesh->GetLODs().size())
+		return meshInfo.Mesh;
+	return mesh->GetLODs()[meshInfo.LOD - 1].Mesh;
+}
+
 void MeshRenderer::Draw()
 {
+	Camera* camera = Renderer::GetMainCamera();
+	Transform* transform = GetTransform();
+	mat4 modelMatrix = transform->GetModelMatrix();
+	float maxScale = glm::max(length(vec3(modelMatrix[0])), glm::max(length(vec3(modelMatrix[1])), length(vec3(modelMatrix[2]))));
+
 	for (auto& meshInfo : Meshes)
+	{
+		Mesh* mesh = ResourceManager::Get<Mesh>(meshInfo.Mesh);
+		if (mesh && camera)
+		{
+			vec3 centre = (mesh->GetBoundsMin() + mesh->GetBoundsMax()) * 0.5f;
+			float radius = length(mesh->GetBoundsMax() - centre) * maxScale;
+			float screenSize = GetScreenSize(camera, vec3(modelMatrix * vec4(centre, 1.0f)), radius);
+
+			meshInfo.LOD = mesh->GetLODs().empty() ? 0 : mesh->SelectLOD(screenSize, meshInfo.LOD);
+
+			// Projected diameter in pixels, textures are assumed to span the mesh once
+			TextureResidency::Request(meshInfo.Material, screenSize * Renderer::GetResolution().y);
+		}
+		else
+			meshInfo.LOD = 0;
+
+		ResourceID meshID = GetLODMesh(meshInfo);
 		Renderer::Submit(
-			meshInfo.Mesh,
+			meshID,
 			meshInfo.Material,
-			GetTransform()
+			transform
 		);
-}
+	}
+}
\ No newline at end of file
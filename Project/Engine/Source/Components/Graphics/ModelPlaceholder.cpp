@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <Engine/Graphics/Mesh.hpp>
+#include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Components/Graphics/ModelPlaceholder.hpp>
+
+using namespace std;
+using namespace Engine;
+using namespace Engine::Graphics;
+using namespace Engine::Components;
+
+Model* ModelPlaceholder::GetModel() { return m_Model; }
+
+void ModelPlaceholder::Added()
+{
+	m_Material.Wireframe = true;
+	m_Material.CanCastShadows = false;
+}
+
+void ModelPlaceholder::Removed()
+{
+	if (m_Model)
+	{
+		vector<ModelPlaceholder*>& placeholders = m_Model->m_Placeholders;
+		placeholders.erase(remove(placeholders.begin(), placeholders.end(), this), placeholders.end());
+		m_Model = nullptr;
+	}
+
+	Component::Removed();
+}
+
+void ModelPlaceholder::Draw()
+{
+	Renderer::Submit(
+		Mesh::Cube(),
+		m_Material,
+		GetTransform()
+	);
+}
\ No newline at end of file
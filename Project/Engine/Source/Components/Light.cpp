@@ -1,5 +1,3 @@
-#include <string>
-#include <Engine/Graphics/Shader.hpp>
 #include <Engine/Components/Light.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <Engine/Components/Transform.hpp>
@@ -26,33 +24,32 @@ void Light::SetCastShadows(bool canCast)
 		shadowPass->RemoveShadowCaster(this);
 }
 
-void Light::FillShader(unsigned int lightIndex, Shader* shader)
+void Light::FillUniformData(LightUniformData& data)
 {
 	Transform* transform = GetTransform();
-	string prefix = "lights[" + to_string(lightIndex) + "].";
 
-	shader->Set(prefix + "Position", Type != LightType::Directional ?
+	data.Position = Type != LightType::Directional ?
 		transform->GetGlobalPosition() :
-		-transform->Forward() * 10000.0f); // Directional light position is very far
+		-transform->Forward() * 10000.0f; // Directional light position is very far
 
-	shader->Set(prefix + "Colour", Colour);
-	shader->Set(prefix + "Type", (int)Type);
-	shader->Set(prefix + "Distance", Distance);
-	shader->Set(prefix + "Intensity", Intensity);
-	shader->Set(prefix + "CastShadows", m_CastShadows);
-	shader->Set(prefix + "Direction", transform->Forward());
-	shader->Set(prefix + "FadeCutoffInner", FadeCutoffInner);
-	shader->Set(prefix + "Radius", Type == LightType::Directional ? 999999.99f : Radius);
+	data.Colour = Colour;
+	data.Type = (int)Type;
+	data.Distance = Distance;
+	data.Intensity = Intensity;
+	data.CastShadows = m_CastShadows ? 1 : 0;
+	data.Direction = transform->Forward();
+	data.FadeCutoffInner = FadeCutoffInner;
+	data.Radius = Type == LightType::Directional ? 999999.99f : Radius;
 
 	if (m_CastShadows)
 	{
 		ShadowMapPass::LightShadowData& shadowData = Renderer::GetPipeline()->GetShadowMapPass()->m_ShadowCasters[this];
-		shader->Set(prefix + "ShadowMapIndex", shadowData.ShadowMapArrayIndex);
-		shader->Set(prefix + "LightSpaceMatrix", shadowData.LightSpaceMatrix);
+		data.ShadowMapIndex = shadowData.ShadowMapArrayIndex;
+		data.LightSpaceMatrix = shadowData.LightSpaceMatrices[0];
 	}
 	else
 	{
-		shader->Set(prefix + "ShadowMapIndex", -1);
-		shader->Set(prefix + "LightSpaceMatrix", mat4(1.0f));
+		data.ShadowMapIndex = -1;
+		data.LightSpaceMatrix = mat4(1.0f);
 	}
 }
\ No newline at end of file
@@ -9,11 +9,14 @@ using namespace Engine;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
+constexpr UniformHandle ModelMatrixUniform("modelMatrix");
+
 const vec3 WorldUp = { 0, 1, 0 };
 
 void Transform::Added() { m_Dirty = true; }
 
 mat4 Transform::GetModelMatrix() { return m_ModelMatrix; }
+unsigned int Transform::GetVersion() { return m_Version; }
 vec3 Transform::GetGlobalScale()	{ return m_GlobalScale; }
 vec3 Transform::GetGlobalPosition() { return m_GlobalPosition; }
 vec3 Transform::GetGlobalRotation() { return m_GlobalRotation; }
@@ -92,7 +95,7 @@ void Transform::SetParent(Transform* parent)
 Transform* Transform::GetParent() { return m_Parent; }
 std::vector<Transform*> Transform::GetChildren() { return m_Children; }
 
-void Transform::FillShader(Shader* shader) { shader->Set("modelMatrix", m_ModelMatrix); }
+void Transform::FillShader(Shader* shader) { shader->Set(ModelMatrixUniform, m_ModelMatrix); }
 
 void Transform::Update(float deltaTime)
 {
@@ -105,6 +108,7 @@ void Transform::Update(float deltaTime)
 	if (!m_Dirty)
 		return;
 	m_Dirty = false;
+	m_Version++;
 
 	for (Transform* child : m_Children)
 		child->m_Dirty = true;
@@ -0,0 +1,554 @@
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+#include <Engine/Log.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+#include <Engine/Graphics/EnvironmentBaker.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Jobs;
+using namespace Engine::Graphics;
+
+const float BakePI = 3.14159265359f;
+
+// Rows of texels processed by a single job
+const unsigned int BakeRowsPerJob = 4;
+
+/// <summary>
+/// Equirectangular HDR image, sampled the same way as EquiRectToCubemap.frag
+/// </summary>
+struct EquirectangularImage
+{
+	int Width = 0, Height = 0;
+	vector<vec3> Pixels;
+
+	bool Load(string& path)
+	{
+		int channelCount = 0;
+		float* data = stbi_loadf(path.c_str(), &Width, &Height, &channelCount, 3);
+		if (!data)
+		{
+			Log::Warning("Failed to load '" + path + "' - " + stbi_failure_reason());
+			return false;
+		}
+
+		Pixels.resize((size_t)Width * Height);
+		memcpy(Pixels.data(), data, Pixels.size() * sizeof(vec3));
+		stbi_image_free(data);
+		return true;
+	}
+
+	vec3 Texel(int x, int y)
+	{
+		x = ((x % Width) + Width) % Width; // Wraps horizontally
+		y = glm::clamp(y, 0, Height - 1);
+		return Pixels[(size_t)y * Width + x];
+	}
+
+	vec3 Sample(vec3 direction)
+	{
+		vec2 uv = vec2(atan2(direction.z, direction.x), asin(direction.y)) * vec2(0.1591f, 0.3183f) + 0.5f;
+
+		// GPU texture is flipped vertically on load, the first row is the bottom of the image
+		float x = uv.x * Width - 0.5f;
+		float y = (1.0f - uv.y) * Height - 0.5f;
+		int x0 = (int)floor(x), y0 = (int)floor(y);
+		float fx = x - x0, fy = y - y0;
+
+		return mix(
+			mix(Texel(x0, y0), Texel(x0 + 1, y0), fx),
+			mix(Texel(x0, y0 + 1), Texel(x0 + 1, y0 + 1), fx),
+			fy);
+	}
+};
+
+/// <returns>Direction through a cubemap face, with s & t in [-1, 1] following the OpenGL face layout</returns>
+vec3 GetFaceDirection(unsigned int face, float s, float t)
+{
+	switch (face)
+	{
+	default:
+	case 0: return normalize(vec3( 1.0f, -t, -s));
+	case 1: return normalize(vec3(-1.0f, -t,  s));
+	case 2: return normalize(vec3( s,  1.0f,  t));
+	case 3: return normalize(vec3( s, -1.0f, -t));
+	case 4: return normalize(vec3( s, -t,  1.0f));
+	case 5: return normalize(vec3(-s, -t, -1.0f));
+	}
+}
+
+/// <summary>
+/// Inverse of GetFaceDirection, uv is in [0, 1]
+/// </summary>
+void GetFaceCoordinates(vec3 direction, unsigned int& face, vec2& uv)
+{
+	vec3 absolute = abs(direction);
+	float major, s, t;
+	if (absolute.x >= absolute.y && absolute.x >= absolute.z)
+	{
+		face = direction.x > 0.0f ? 0 : 1;
+		major = absolute.x;
+		s = direction.x > 0.0f ? -direction.z : direction.z;
+		t = -direction.y;
+	}
+	else if (absolute.y >= absolute.z)
+	{
+		face = direction.y > 0.0f ? 2 : 3;
+		major = absolute.y;
+		s = direction.x;
+		t = direction.y > 0.0f ? direction.z : -direction.z;
+	}
+	else
+	{
+		face = direction.z > 0.0f ? 4 : 5;
+		major = absolute.z;
+		s = direction.z > 0.0f ? direction.x : -direction.x;
+		t = -direction.y;
+	}
+	uv = vec2(s, t) / major * 0.5f + 0.5f;
+}
+
+/// <summary>
+/// Cubemap with a full mip chain, each level stores all six faces one after another
+/// </summary>
+struct CubemapImage
+{
+	unsigned int Resolution = 0;
+	vector<vector<vec3>> Levels;
+
+	unsigned int GetResolution(unsigned int level) { return std::max(Resolution >> level, 1u); }
+
+	vec3 Texel(unsigned int level, unsigned int face, int x, int y)
+	{
+		int resolution = (int)GetResolution(level);
+		x = glm::clamp(x, 0, resolution - 1);
+		y = glm::clamp(y, 0, resolution - 1);
+		return Levels[level][((size_t)face * resolution + y) * resolution + x];
+	}
+
+	vec3 SampleLevel(vec3 direction, unsigned int level)
+	{
+		unsigned int face;
+		vec2 uv;
+		GetFaceCoordinates(direction, face, uv);
+
+		// Faces are filtered independently, edges are clamped
+		float resolution = (float)GetResolution(level);
+		float x = uv.x * resolution - 0.5f;
+		float y = uv.y * resolution - 0.5f;
+		int x0 = (int)floor(x), y0 = (int)floor(y);
+		float fx = x - x0, fy = y - y0;
+
+		return mix(
+			mix(Texel(level, face, x0, y0), Texel(level, face, x0 + 1, y0), fx),
+			mix(Texel(level, face, x0, y0 + 1), Texel(level, face, x0 + 1, y0 + 1), fx),
+			fy);
+	}
+
+	/// <summary>
+	/// Trilinear sample, matching textureLod
+	/// </summary>
+	vec3 Sample(vec3 direction, float lod)
+	{
+		lod = glm::clamp(lod, 0.0f, (float)(Levels.size() - 1));
+		unsigned int level = (unsigned int)lod;
+		float blend = lod - level;
+		if (blend <= 0.0f || level + 1 >= Levels.size())
+			return SampleLevel(direction, level);
+		return mix(SampleLevel(direction, level), SampleLevel(direction, level + 1), blend);
+	}
+
+	/// <summary>
+	/// Fills levels after the first by averaging each 2x2 square of the previous level
+	/// </summary>
+	void GenerateMipmaps()
+	{
+		Levels.resize(1);
+		for (unsigned int level = 1; GetResolution(level - 1) > 1; level++)
+		{
+			unsigned int resolution = GetResolution(level);
+			vector<vec3> texels((size_t)6 * resolution * resolution);
+			for (unsigned int face = 0; face < 6; face++)
+				for (unsigned int y = 0; y < resolution; y++)
+					for (unsigned int x = 0; x < resolution; x++)
+						texels[((size_t)face * resolution + y) * resolution + x] = 0.25f * (
+							Texel(level - 1, face, x * 2, y * 2) +
+							Texel(level - 1, face, x * 2 + 1, y * 2) +
+							Texel(level - 1, face, x * 2, y * 2 + 1) +
+							Texel(level - 1, face, x * 2 + 1, y * 2 + 1));
+			Levels.emplace_back(std::move(texels));
+		}
+	}
+};
+
+/// <summary>
+/// Calls texel for every texel of six faces, split across worker threads
+/// </summary>
+void ForEachCubemapTexel(unsigned int resolution, vector<vec3>& output, function<vec3(vec3 direction)> texel)
+{
+	output.resize((size_t)6 * resolution * resolution);
+	unsigned int rowCount = 6 * resolution;
+	unsigned int jobCount = (rowCount + BakeRowsPerJob - 1) / BakeRowsPerJob;
+	JobSystem::ParallelFor(jobCount, [&](unsigned int job)
+	{
+		unsigned int lastRow = std::min((job + 1) * BakeRowsPerJob, rowCount);
+		for (unsigned int row = job * BakeRowsPerJob; row < lastRow; row++)
+		{
+			unsigned int face = row / resolution, y = row % resolution;
+			float t = 2.0f * (y + 0.5f) / resolution - 1.0f;
+			for (unsigned int x = 0; x < resolution; x++)
+			{
+				float s = 2.0f * (x + 0.5f) / resolution - 1.0f;
+				output[(size_t)row * resolution + x] = texel(GetFaceDirection(face, s, t));
+			}
+		}
+	});
+}
+
+// Matches Shaders/Include/PBRFunctions.inc
+float RadicalInverseVdC(unsigned int bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10f;
+}
+
+vec2 Hammersley(unsigned int i, unsigned int count) { return vec2(float(i) / float(count), RadicalInverseVdC(i)); }
+
+vec3 ImportanceSampleGGX(vec2 xi, vec3 N, float roughness)
+{
+	float a = roughness * roughness;
+
+	float phi = 2.0f * BakePI * xi.x;
+	float cosTheta = sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+	float sinTheta = sqrt(1.0f - cosTheta * cosTheta);
+	vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(N.z) < 0.999f ? vec3(0, 0, 1) : vec3(1, 0, 0);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+float DistributionGGX(float NdotH, float roughness)
+{
+	float a2 = roughness * roughness * roughness * roughness;
+	float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+	return a2 / (BakePI * denom * denom);
+}
+
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+	float k = (roughness * roughness) / 2.0f;
+	return NdotV / (NdotV * (1.0f - k) + k);
+}
+
+vec2 IntegrateBRDF(float NdotV, float roughness, unsigned int sampleCount)
+{
+	vec3 V = vec3(sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+	vec3 N = vec3(0, 0, 1);
+
+	float A = 0.0f, B = 0.0f;
+	for (unsigned int i = 0; i < sampleCount; i++)
+	{
+		vec3 H = ImportanceSampleGGX(Hammersley(i, sampleCount), N, roughness);
+		vec3 L = normalize(2.0f * dot(V, H) * H - V);
+
+		float NdotL = std::max(L.z, 0.0f);
+		float NdotH = std::max(H.z, 0.0f);
+		float VdotH = std::max(dot(V, H), 0.0f);
+		if (NdotL > 0.0f)
+		{
+			float G = GeometrySchlickGGX(NdotV, roughness) * GeometrySchlickGGX(NdotL, roughness);
+			float GVis = (G * VdotH) / (NdotH * NdotV);
+			float Fc = pow(1.0f - VdotH, 5.0f);
+
+			A += (1.0f - Fc) * GVis;
+			B += Fc * GVis;
+		}
+	}
+	return vec2(A, B) / float(sampleCount);
+}
+
+// Normalisation constants of the first nine real spherical harmonics
+const float SHBasisConstants[9] = { 0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f };
+
+// Cosine lobe convolution of each band, divided by PI as diffuse is multiplied by albedo only (Ramamoorthi & Hanrahan)
+const float SHCosineLobe[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+/// <summary>
+/// Evaluates the spherical harmonic basis in the order used by EvaluateIrradianceSH, without normalisation constants.
+/// Four directions are evaluated at once, one per lane.
+/// </summary>
+void GetSHBasis(vec4 x, vec4 y, vec4 z, vec4 basis[9])
+{
+	basis[0] = vec4(1.0f);
+	basis[1] = y;
+	basis[2] = z;
+	basis[3] = x;
+	basis[4] = x * y;
+	basis[5] = y * z;
+	basis[6] = 3.0f * z * z - 1.0f;
+	basis[7] = x * z;
+	basis[8] = x * x - y * y;
+}
+
+/// <summary>
+/// Unnormalised directions through four texels along a row of a cubemap face, see GetFaceDirection
+/// </summary>
+void GetFaceDirections(unsigned int face, vec4 s, float t, vec4& x, vec4& y, vec4& z)
+{
+	switch (face)
+	{
+	default:
+	case 0: x = vec4( 1.0f); y = vec4(-t);    z = -s;             break;
+	case 1: x = vec4(-1.0f); y = vec4(-t);    z = s;              break;
+	case 2: x = s;           y = vec4( 1.0f); z = vec4(t);        break;
+	case 3: x = s;           y = vec4(-1.0f); z = vec4(-t);       break;
+	case 4: x = s;           y = vec4(-t);    z = vec4( 1.0f);    break;
+	case 5: x = -s;          y = vec4(-t);    z = vec4(-1.0f);    break;
+	}
+}
+
+/// <summary>
+/// Flattens a cubemap into an image to be cached
+/// </summary>
+IBLCache::Image ToImage(IBLCache::Product product, CubemapImage& cubemap)
+{
+	IBLCache::Image image;
+	image.Type = product;
+	image.Width = image.Height = cubemap.Resolution;
+	for (vector<vec3>& level : cubemap.Levels)
+		image.Levels.emplace_back((float*)level.data(), (float*)(level.data() + level.size()));
+	return image;
+}
+
+bool BakeEnvironment(EnvironmentMapArgs& args, vector<IBLCache::Image>& images, EnvironmentBakeSettings& settings)
+{
+	images.clear();
+
+	EquirectangularImage background;
+	if (!background.Load(args.Background))
+		return false;
+
+	CubemapImage cubemap;
+	cubemap.Resolution = settings.CubemapResolution;
+	cubemap.Levels.resize(1);
+	ForEachCubemapTexel(cubemap.Resolution, cubemap.Levels[0], [&](vec3 direction) { return background.Sample(direction); });
+	cubemap.GenerateMipmaps();
+	images.emplace_back(ToImage(IBLCache::Product::Cubemap, cubemap));
+
+	// Lighting is taken from the reflection image when given
+	CubemapImage reflectionCubemap;
+	bool hasReflection = !args.Reflection.empty();
+	if (hasReflection)
+	{
+		EquirectangularImage reflection;
+		if (!reflection.Load(args.Reflection))
+			return false;
+
+		reflectionCubemap.Resolution = settings.CubemapResolution;
+		reflectionCubemap.Levels.resize(1);
+		ForEachCubemapTexel(reflectionCubemap.Resolution, reflectionCubemap.Levels[0], [&](vec3 direction) { return reflection.Sample(direction); });
+		reflectionCubemap.GenerateMipmaps();
+		images.emplace_back(ToImage(IBLCache::Product::ReflectionCubemap, reflectionCubemap));
+	}
+	CubemapImage& source = hasReflection ? reflectionCubemap : cubemap;
+
+	// Diffuse irradiance, low frequency enough to be stored as nine coefficients
+	IrradianceSH irradiance = EnvironmentBaker::ProjectIrradiance((float*)source.Levels[0].data(), source.Resolution);
+	IBLCache::Image irradianceImage;
+	irradianceImage.Type = IBLCache::Product::IrradianceSH;
+	irradianceImage.FaceCount = irradianceImage.Height = 1;
+	irradianceImage.Width = 9;
+	irradianceImage.Levels.emplace_back((float*)irradiance.Coefficients, (float*)(irradiance.Coefficients + 9));
+	images.emplace_back(std::move(irradianceImage));
+
+	// Pre-filtered specular, GGX importance sampling as in PreFilterCubemap.frag
+	IBLCache::Image preFilter;
+	preFilter.Type = IBLCache::Product::PreFilter;
+	preFilter.Width = preFilter.Height = settings.PreFilterResolution;
+	float saTexel = 4.0f * BakePI / (6.0f * source.Resolution * source.Resolution);
+	for (unsigned int mip = 0; mip < settings.PreFilterMipCount; mip++)
+	{
+		unsigned int resolution = std::max(settings.PreFilterResolution >> mip, 1u);
+		float roughness = settings.PreFilterMipCount > 1 ? (float)mip / (settings.PreFilterMipCount - 1) : 0.0f;
+
+		vector<vec3> texels;
+		ForEachCubemapTexel(resolution, texels, [&](vec3 N)
+		{
+			// Mirror reflection, sample the level closest to the output resolution
+			if (roughness == 0.0f)
+				return source.Sample(N, log2((float)source.Resolution / resolution));
+
+			vec3 V = N;
+			vec3 colour = vec3(0.0f);
+			float totalWeight = 0.0f;
+			for (unsigned int i = 0; i < settings.PreFilterSamples; i++)
+			{
+				vec3 H = ImportanceSampleGGX(Hammersley(i, settings.PreFilterSamples), N, roughness);
+				vec3 L = normalize(2.0f * dot(V, H) * H - V);
+
+				float NdotL = std::max(dot(N, L), 0.0f);
+				if (NdotL <= 0.0f)
+					continue;
+
+				float NdotH = std::max(dot(N, H), 0.0f);
+				float HdotV = std::max(dot(H, V), 0.0f);
+				float pdf = DistributionGGX(NdotH, roughness) * NdotH / (4.0f * HdotV) + 0.0001f;
+				float saSample = 1.0f / (float(settings.PreFilterSamples) * pdf + 0.0001f);
+
+				colour += source.Sample(L, 0.5f * log2(saSample / saTexel)) * NdotL;
+				totalWeight += NdotL;
+			}
+			return totalWeight > 0.0f ? colour / totalWeight : colour;
+		});
+		preFilter.Levels.emplace_back((float*)texels.data(), (float*)(texels.data() + texels.size()));
+	}
+	images.emplace_back(std::move(preFilter));
+
+	// Split sum BRDF lookup, rows are roughness & columns are NdotV
+	IBLCache::Image brdf;
+	brdf.Type = IBLCache::Product::BRDF;
+	brdf.FaceCount = 1;
+	brdf.ChannelCount = 2;
+	brdf.Width = brdf.Height = settings.BRDFResolution;
+	brdf.Levels.emplace_back((size_t)brdf.Width * brdf.Height * 2);
+	vector<float>& brdfTexels = brdf.Levels[0];
+	JobSystem::ParallelFor(brdf.Height, [&](unsigned int y)
+	{
+		float roughness = (y + 0.5f) / brdf.Height;
+		for (unsigned int x = 0; x < brdf.Width; x++)
+		{
+			vec2 value = IntegrateBRDF((x + 0.5f) / brdf.Width, roughness, settings.BRDFSamples);
+			brdfTexels[((size_t)y * brdf.Width + x) * 2 + 0] = value.x;
+			brdfTexels[((size_t)y * brdf.Width + x) * 2 + 1] = value.y;
+		}
+	});
+	images.emplace_back(std::move(brdf));
+	return true;
+}
+
+bool EnvironmentBaker::Bake(EnvironmentMapArgs args, vector<IBLCache::Image>& images, EnvironmentBakeSettings settings)
+{
+	if (JobSystem::s_Instance)
+		return BakeEnvironment(args, images, settings);
+
+	// Outside of an application, e.g. when baking offline
+	JobSystem* jobSystem = new JobSystem();
+	JobSystem::s_Instance = jobSystem;
+
+	bool success = BakeEnvironment(args, images, settings);
+
+	JobSystem::s_Instance = nullptr;
+	delete jobSystem;
+	return success;
+}
+
+bool EnvironmentBaker::BakeToCache(EnvironmentMapArgs args, EnvironmentBakeSettings settings)
+{
+	vector<IBLCache::Image> images;
+	if (!Bake(args, images, settings))
+		return false;
+	return IBLCache::Save(IBLCache::GetPath(args.Background), args.Background, args.Reflection, images);
+}
+
+IrradianceSH EnvironmentBaker::ProjectIrradiance(const float* texels, unsigned int resolution)
+{
+	// Each row is summed separately so jobs never share an accumulator
+	unsigned int rowCount = 6 * resolution;
+	vector<vec3> rowSums((size_t)rowCount * 9);
+	vector<float> rowWeights(rowCount);
+	JobSystem::ParallelFor(rowCount, [&](unsigned int row)
+	{
+		unsigned int face = row / resolution, y = row % resolution;
+		float t = 2.0f * (y + 0.5f) / resolution - 1.0f;
+		const vec3* rowTexels = (const vec3*)texels + (size_t)row * resolution;
+
+		// Four texels are accumulated at a time, one per lane, with each colour channel stored separately
+		vec4 sums[3][9];
+		for (vec4(&channel)[9] : sums)
+			for (vec4& sum : channel)
+				sum = vec4(0.0f);
+		vec4 weightSums(0.0f);
+
+		const vec4 laneOffsets(0.5f, 1.5f, 2.5f, 3.5f);
+		float weightScale = 4.0f / (float(resolution) * resolution);
+		vec4 basis[9];
+		for (unsigned int x = 0; x < resolution; x += 4)
+		{
+			vec4 s = 2.0f * (vec4(float(x)) + laneOffsets) / float(resolution) - 1.0f;
+			vec4 dx, dy, dz;
+			GetFaceDirections(face, s, t, dx, dy, dz);
+
+			// Squared length of the unnormalised direction is 1 + s^2 + t^2
+			vec4 inverseLength = inversesqrt(dx * dx + dy * dy + dz * dz);
+			dx *= inverseLength;
+			dy *= inverseLength;
+			dz *= inverseLength;
+
+			// Solid angle of the texel, texels further from the face centre cover less of the sphere
+			vec4 weight = weightScale * inverseLength * inverseLength * inverseLength;
+
+			// Lanes past the end of the row are left with no weight
+			vec4 red(0.0f), green(0.0f), blue(0.0f);
+			for (unsigned int lane = 0; lane < 4; lane++)
+			{
+				if (x + lane >= resolution)
+				{
+					weight[lane] = 0.0f;
+					continue;
+				}
+				vec3 texel = rowTexels[x + lane];
+				red[lane] = texel.r;
+				green[lane] = texel.g;
+				blue[lane] = texel.b;
+			}
+			weightSums += weight;
+			red *= weight;
+			green *= weight;
+			blue *= weight;
+
+			GetSHBasis(dx, dy, dz, basis);
+			for (unsigned int i = 0; i < 9; i++)
+			{
+				sums[0][i] += red * basis[i];
+				sums[1][i] += green * basis[i];
+				sums[2][i] += blue * basis[i];
+			}
+		}
+
+		const vec4 one(1.0f);
+		for (unsigned int i = 0; i < 9; i++)
+			rowSums[(size_t)row * 9 + i] = vec3(dot(sums[0][i], one), dot(sums[1][i], one), dot(sums[2][i], one));
+		rowWeights[row] = dot(weightSums, one);
+	}, BakeRowsPerJob);
+
+	vec3 sums[9];
+	for (vec3& sum : sums)
+		sum = vec3(0.0f);
+	float weightSum = 0.0f;
+	for (unsigned int row = 0; row < rowCount; row++)
+	{
+		for (unsigned int i = 0; i < 9; i++)
+			sums[i] += rowSums[(size_t)row * 9 + i];
+		weightSum += rowWeights[row];
+	}
+
+	// Texel solid angles only approximately cover the sphere, rescale to exactly 4 PI
+	float normalisation = weightSum > 0.0f ? 4.0f * BakePI / weightSum : 0.0f;
+
+	// Both normalisation constants of the basis are folded in, one from projection & one from evaluation
+	IrradianceSH irradiance;
+	for (unsigned int i = 0; i < 9; i++)
+		irradiance.Coefficients[i] = sums[i] * normalisation * SHBasisConstants[i] * SHBasisConstants[i] * SHCosineLobe[i];
+	return irradiance;
+}
\ No newline at end of file
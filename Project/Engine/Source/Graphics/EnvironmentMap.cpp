@@ -1,32 +1,128 @@
+#include <memory>
 #include <Engine/Utilities.hpp>
 #include <Engine/Application.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
 #include <Engine/Graphics/Mesh.hpp>
 #include <Engine/ResourceManager.hpp>
 #include <Engine/Graphics/Shader.hpp>
 #include <Engine/Graphics/Texture.hpp>
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
 #include <Engine/Graphics/EnvironmentMap.hpp>
+#include <Engine/Graphics/EnvironmentBaker.hpp>
 
 using namespace std;
 using namespace glm;
 using namespace Engine;
+using namespace Engine::Jobs;
 using namespace Engine::Graphics;
 
-const string CubemapCacheExtension	  = ".Cubemap.hdr";
-const string IrradianceCacheExtension = ".Irradiance.hdr";
+constexpr UniformHandle EquirectangularMapUniform("equirectangularMap");
+constexpr UniformHandle ProjectionMatrixUniform("projectionMatrix");
+constexpr UniformHandle ViewMatrixUniform("viewMatrix");
+constexpr UniformHandle EnvironmentMapUniform("environmentMap");
+constexpr UniformHandle ResolutionUniform("resolution");
+constexpr UniformHandle RoughnessUniform("roughness");
+
+// Levels of the pre-filtered cubemap, roughness increases with each level
+const unsigned int PreFilterMipLevels = 5;
+
+/// <summary>
+/// Creates a texture from an image stored in cache
+/// </summary>
+/// <returns>Texture of product, or nullptr if not stored</returns>
+RenderTexture* LoadCachedEnvironmentImage(IBLCache& cache, IBLCache::Product product, RenderTextureArgs args)
+{
+	const IBLCache::ImageEntry* image = cache.GetImage(product);
+	if (!image)
+		return nullptr;
+
+	args.Resolution = { (int)image->Width, (int)image->Height };
+	args.GenerateMipmaps = image->MipCount > 1; // Allocates storage for every level
+	RenderTexture* texture = new RenderTexture(args);
+
+	bool isCubemap = args.Format == TextureFormat::Cubemap;
+	GLenum target = isCubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	GLenum format = image->ChannelCount == 2 ? GL_RG : GL_RGB;
+
+	glBindTexture(target, texture->GetID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2); // Rows of half floats are not always 4 byte aligned
+	for (unsigned int level = 0; level < image->MipCount; level++)
+	{
+		const uint16_t* data = cache.GetLevelData(*image, level);
+		GLsizei width = (GLsizei)std::max(image->Width >> level, 1u);
+		GLsizei height = (GLsizei)std::max(image->Height >> level, 1u);
+		size_t faceSize = (size_t)width * height * image->ChannelCount;
+
+		for (unsigned int face = 0; face < image->FaceCount; face++)
+			glTexSubImage2D(
+				isCubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D,
+				level,
+				0, 0, // Offset
+				width,
+				height,
+				format,
+				GL_HALF_FLOAT,
+				data + face * faceSize
+			);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(target, 0);
+	return texture;
+}
+
+/// <summary>
+/// Reads the first mipCount levels of a rendered texture back to the CPU
+/// </summary>
+IBLCache::Image ReadEnvironmentImage(IBLCache::Product product, RenderTexture* texture, unsigned int mipCount)
+{
+	bool isCubemap = texture->GetFormat() == TextureFormat::Cubemap;
+	ivec2 resolution = texture->GetResolution();
+
+	IBLCache::Image image;
+	image.Type = product;
+	image.FaceCount = isCubemap ? 6 : 1;
+	image.ChannelCount = isCubemap ? 3 : 2;
+	image.Width = (unsigned int)resolution.x;
+	image.Height = (unsigned int)resolution.y;
+
+	GLenum target = isCubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	glBindTexture(target, texture->GetID());
+	for (unsigned int level = 0; level < mipCount; level++)
+	{
+		size_t faceSize = (size_t)std::max(image.Width >> level, 1u) * std::max(image.Height >> level, 1u) * image.ChannelCount;
+		vector<float> texels(faceSize * image.FaceCount);
+		for (unsigned int face = 0; face < image.FaceCount; face++)
+			glGetTexImage(
+				isCubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D,
+				level,
+				isCubemap ? GL_RGB : GL_RG,
+				GL_FLOAT,
+				texels.data() + face * faceSize
+			);
+		image.Levels.emplace_back(std::move(texels));
+	}
+	glBindTexture(target, 0);
+	return image;
+}
 
 EnvironmentMap::EnvironmentMap(EnvironmentMapArgs args, ivec2 resolution) :
 	m_Args(args),
+	m_Generated(false),
 	m_Framebuffer(nullptr),
 	m_BRDFTexture(nullptr),
 	m_Resolution(resolution),
 	m_CubemapTexture(nullptr),
 	m_PreFilterTexture(nullptr),
-	m_IrradianceTexture(nullptr),
 	m_Texture(InvalidResourceID),
+	m_ReflectionTexture(InvalidResourceID),
 	m_ReflectionCubemapTexture(nullptr)
 {
+	// No ambient diffuse lighting until generated
+	for (vec3& coefficient : m_IrradianceSH.Coefficients)
+		coefficient = vec3(0.0f);
+
 	if (m_Args.Background.empty())
 	{
 		Log::Warning("Cannot create environment map - background has empty path");
@@ -38,6 +134,13 @@ EnvironmentMap::EnvironmentMap(EnvironmentMapArgs args, ivec2 resolution) :
 		return;
 	}
 
+	// Previously baked, source images & shaders are not needed
+	if (m_Cache.Open(
+		IBLCache::GetPath(m_Args.Background),
+		m_Args.Background,
+		filesystem::exists(m_Args.Reflection) ? m_Args.Reflection : ""))
+		return;
+
 	// Texture
 	TextureArgs textureArgs;
 	textureArgs.HDR = true;
@@ -54,11 +157,6 @@ EnvironmentMap::EnvironmentMap(EnvironmentMapArgs args, ivec2 resolution) :
 			Application::AssetDir + "Shaders/Misc/Cubemap.vert",
 			Application::AssetDir + "Shaders/Misc/EquiRectToCubemap.frag"
 		});
-	m_IrradianceShader = ResourceManager::LoadNamed<Shader>("Shaders/EnvironmentIrradiance", ShaderStageInfo
-		{
-			Application::AssetDir + "Shaders/Misc/Cubemap.vert",
-			Application::AssetDir + "Shaders/Misc/IrradianceConvolution.frag"
-		});
 	m_PreFilterShader = ResourceManager::LoadNamed<Shader>("Shaders/EnvironmentPreFilter", ShaderStageInfo
 		{
 			Application::AssetDir + "Shaders/Misc/Cubemap.vert",
@@ -74,44 +172,47 @@ EnvironmentMap::EnvironmentMap(EnvironmentMapArgs args, ivec2 resolution) :
 EnvironmentMap::~EnvironmentMap()
 {
 	if (m_Framebuffer)				delete m_Framebuffer;
-	if (m_IrradianceTexture)		delete m_IrradianceTexture;
+	else if (m_CubemapTexture)		delete m_CubemapTexture; // Not owned by a framebuffer when loaded from cache
+	if (m_BRDFTexture)				delete m_BRDFTexture;
 	if (m_ReflectionCubemapTexture) delete m_ReflectionCubemapTexture;
 	if (m_PreFilterTexture)			delete m_PreFilterTexture;
 
-	ResourceManager::Unload(m_Texture);
+	// Source images are not loaded when read from cache
+	if (m_Texture != InvalidResourceID)				ResourceManager::Unload(m_Texture);
+	if (m_ReflectionTexture != InvalidResourceID)	ResourceManager::Unload(m_ReflectionTexture);
 }
 
 RenderTexture* EnvironmentMap::GetBRDF()
 {
-	if (!m_Framebuffer)
+	if (!m_Generated)
 		Generate();
 	return m_BRDFTexture;
 }
 
 RenderTexture* EnvironmentMap::GetCubemap()
 {
-	if (!m_Framebuffer)
+	if (!m_Generated)
 		Generate();
 	return m_CubemapTexture;
 }
 
-RenderTexture* EnvironmentMap::GetIrradianceMap()
+IrradianceSH& EnvironmentMap::GetIrradianceSH()
 {
-	if (!m_Framebuffer)
+	if (!m_Generated)
 		Generate();
-	return m_IrradianceTexture;
+	return m_IrradianceSH;
 }
 
 RenderTexture* EnvironmentMap::GetReflectionCubemap()
 {
-	if (!m_Framebuffer)
+	if (!m_Generated)
 		Generate();
 	return m_ReflectionCubemapTexture ? m_ReflectionCubemapTexture : m_CubemapTexture;
 }
 
 RenderTexture* EnvironmentMap::GetPrefilteredCubemap()
 {
-	if (!m_Framebuffer)
+	if (!m_Generated)
 		Generate();
 	return m_PreFilterTexture ? m_PreFilterTexture : nullptr;
 }
@@ -120,11 +221,19 @@ ResourceID EnvironmentMap::GetTexture() { return m_Texture; }
 
 void EnvironmentMap::Generate()
 {
-	if (m_Framebuffer || // Already generated
-		m_Texture == InvalidResourceID // No texture found/loaded
-		)
-		return; 
-	
+	if (m_Generated)
+		return;
+
+	if (m_Cache.GetImage(IBLCache::Product::Cubemap))
+	{
+		LoadCache();
+		return;
+	}
+
+	if (m_Texture == InvalidResourceID) // No texture found/loaded
+		return;
+	m_Generated = true;
+
 	FramebufferSpec specs;
 	specs.Attachments =
 	{
@@ -156,21 +265,21 @@ void EnvironmentMap::Generate()
 	args.Resolution = m_Resolution;
 
 	// Environment Cubemap //
-	string cubemapPath = m_Args.Background + CubemapCacheExtension;
-	if (!std::filesystem::exists(cubemapPath))
 	{
 		shader->Bind();
-		shader->Set("equirectangularMap", 0);
-		shader->Set("projectionMatrix", projection);
+		shader->Set(EquirectangularMapUniform, 0);
+		shader->Set(ProjectionMatrixUniform, projection);
 
+		// Converted once, cannot wait for streaming
 		Texture* inputTexture = ResourceManager::Get<Texture>(m_Texture);
+		inputTexture->Wait();
 		inputTexture->Bind(0);
 
 		m_Framebuffer->Bind();
 
 		for (unsigned int i = 0; i < 6; i++)
 		{
-			shader->Set("viewMatrix", views[i]);
+			shader->Set(ViewMatrixUniform, views[i]);
 
 			glFramebufferTexture2D(
 				GL_FRAMEBUFFER,
@@ -185,30 +294,27 @@ void EnvironmentMap::Generate()
 			cubeMesh->Draw();
 		}
 		m_CubemapTexture = m_Framebuffer->GetColourAttachment();
-		m_CubemapTexture->SaveHDR(cubemapPath);
 	}
-	else
-		m_CubemapTexture = RenderTexture::LoadFromHDR(cubemapPath, args);
 
 	// Reflection Cubemap //
-	cubemapPath = m_Args.Reflection + CubemapCacheExtension;
-	bool fileExists = filesystem::exists(cubemapPath);
-	if (!fileExists && m_ReflectionTexture != InvalidResourceID)
+	if (m_ReflectionTexture != InvalidResourceID)
 	{
 		args.GenerateMipmaps = true;
 		m_ReflectionCubemapTexture = new RenderTexture(args);
 
 		shader->Bind();
-		shader->Set("equirectangularMap", 0);
-		shader->Set("projectionMatrix", projection);
+		shader->Set(EquirectangularMapUniform, 0);
+		shader->Set(ProjectionMatrixUniform, projection);
 
+		// Converted once, cannot wait for streaming
 		Texture* inputTexture = ResourceManager::Get<Texture>(m_ReflectionTexture);
+		inputTexture->Wait();
 		inputTexture->Bind(0);
 
 		m_Framebuffer->Bind();
 		for (unsigned int i = 0; i < 6; i++)
 		{
-			shader->Set("viewMatrix", views[i]);
+			shader->Set(ViewMatrixUniform, views[i]);
 
 			glFramebufferTexture2D(
 				GL_FRAMEBUFFER,
@@ -222,50 +328,7 @@ void EnvironmentMap::Generate()
 
 			cubeMesh->Draw();
 		}
-
-		m_ReflectionCubemapTexture->SaveHDR(cubemapPath);
-	}
-	else if(fileExists)
-		m_ReflectionCubemapTexture = RenderTexture::LoadFromHDR(cubemapPath, args);
-
-	// Irradiance Map Generation //
-	const ivec2 irradianceResolution = { 128, 128 };
-
-	args.GenerateMipmaps = false;
-	args.Resolution = irradianceResolution;
-	cubemapPath = m_Args.Background + IrradianceCacheExtension;
-	if (!std::filesystem::exists(cubemapPath))
-	{
-		m_IrradianceTexture = new RenderTexture(args);
-
-		shader = ResourceManager::Get<Shader>(m_IrradianceShader);
-		shader->Bind();
-		shader->Set("projectionMatrix", projection);
-		shader->Set("environmentMap", 6);
-		GetReflectionCubemap()->Bind(6);
-
-		glViewport(0, 0, irradianceResolution.x, irradianceResolution.y);
-		for (unsigned int i = 0; i < 6; i++)
-		{
-			shader->Set("viewMatrix", views[i]);
-
-			glFramebufferTexture2D(
-				GL_FRAMEBUFFER,
-				GL_COLOR_ATTACHMENT0,
-				GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-				m_IrradianceTexture->GetID(),
-				0 // Mipmap level
-			);
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			cubeMesh->Draw();
-		}
-
-		m_IrradianceTexture->SaveHDR(cubemapPath);
 	}
-	else
-		m_IrradianceTexture = RenderTexture::LoadFromHDR(cubemapPath, args);
 
 	// Pre-filter environment map
 	args.GenerateMipmaps = true;
@@ -276,12 +339,11 @@ void EnvironmentMap::Generate()
 	shader = ResourceManager::Get<Shader>(m_PreFilterShader);
 
 	shader->Bind();
-	shader->Set("projectionMatrix", projection);
-	shader->Set("environmentMap", 6);
+	shader->Set(ProjectionMatrixUniform, projection);
+	shader->Set(EnvironmentMapUniform, 6);
 	GetReflectionCubemap()->Bind(6);
 
-	const unsigned int MaxMipLevels = 5;
-	for (unsigned int mip = 0; mip < MaxMipLevels; mip++)
+	for (unsigned int mip = 0; mip < PreFilterMipLevels; mip++)
 	{
 		vec2 resolution =
 		{
@@ -291,11 +353,11 @@ void EnvironmentMap::Generate()
 
 		glViewport(0, 0, (GLsizei)resolution.x, (GLsizei)resolution.y);
 
-		shader->Set("resolution", resolution);
-		shader->Set("roughness", (float)mip / (float)(MaxMipLevels - 1));
+		shader->Set(ResolutionUniform, resolution);
+		shader->Set(RoughnessUniform, (float)mip / (float)(PreFilterMipLevels - 1));
 		for (int i = 0; i < 6; i++)
 		{
-			shader->Set("viewMatrix", views[i]);
+			shader->Set(ViewMatrixUniform, views[i]);
 			glFramebufferTexture2D(
 				GL_FRAMEBUFFER,
 				GL_COLOR_ATTACHMENT0,
@@ -334,4 +396,63 @@ void EnvironmentMap::Generate()
 	shader->Unbind();
 
 	m_Framebuffer->Unbind();
+
+	SaveCache();
+}
+
+void EnvironmentMap::LoadCache()
+{
+	m_Generated = true;
+
+	RenderTextureArgs args;
+	args.Format = TextureFormat::Cubemap;
+	args.PixelType = TexturePixelType::Float;
+
+	m_CubemapTexture = LoadCachedEnvironmentImage(m_Cache, IBLCache::Product::Cubemap, args);
+	m_ReflectionCubemapTexture = LoadCachedEnvironmentImage(m_Cache, IBLCache::Product::ReflectionCubemap, args);
+
+	args.MinFilter = GL_LINEAR_MIPMAP_LINEAR;
+	m_PreFilterTexture = LoadCachedEnvironmentImage(m_Cache, IBLCache::Product::PreFilter, args);
+
+	args.MinFilter = GL_LINEAR;
+	args.Format = TextureFormat::RG16F;
+	m_BRDFTexture = LoadCachedEnvironmentImage(m_Cache, IBLCache::Product::BRDF, args);
+
+	const IBLCache::ImageEntry* irradiance = m_Cache.GetImage(IBLCache::Product::IrradianceSH);
+	if (irradiance && irradiance->Width * irradiance->Height == 9)
+	{
+		const uint16_t* coefficients = m_Cache.GetLevelData(*irradiance, 0);
+		for (unsigned int i = 0; i < 9 * 3; i++)
+			m_IrradianceSH.Coefficients[i / 3][i % 3] = unpackHalf1x16(coefficients[i]);
+	}
+
+	// Textures hold a copy, file no longer needs to be mapped
+	m_Cache.Close();
+}
+
+void EnvironmentMap::SaveCache()
+{
+	shared_ptr<vector<IBLCache::Image>> images = make_shared<vector<IBLCache::Image>>();
+	images->emplace_back(ReadEnvironmentImage(IBLCache::Product::Cubemap, m_CubemapTexture, 1));
+	if (m_ReflectionCubemapTexture)
+		images->emplace_back(ReadEnvironmentImage(IBLCache::Product::ReflectionCubemap, m_ReflectionCubemapTexture, 1));
+	images->emplace_back(ReadEnvironmentImage(IBLCache::Product::PreFilter, m_PreFilterTexture, PreFilterMipLevels));
+	images->emplace_back(ReadEnvironmentImage(IBLCache::Product::BRDF, m_BRDFTexture, 1));
+
+	// Irradiance is projected from the cubemap used for lighting
+	IBLCache::Image& lighting = m_ReflectionCubemapTexture ? (*images)[1] : (*images)[0];
+	m_IrradianceSH = EnvironmentBaker::ProjectIrradiance(lighting.Levels[0].data(), lighting.Width);
+
+	IBLCache::Image irradiance;
+	irradiance.Type = IBLCache::Product::IrradianceSH;
+	irradiance.FaceCount = irradiance.Height = 1;
+	irradiance.Width = 9;
+	irradiance.Levels.emplace_back((float*)m_IrradianceSH.Coefficients, (float*)(m_IrradianceSH.Coefficients + 9));
+	images->emplace_back(std::move(irradiance));
+
+	// Half float conversion & writing is done off the main thread
+	string cachePath = IBLCache::GetPath(m_Args.Background);
+	string backgroundPath = m_Args.Background;
+	string reflectionPath = m_ReflectionTexture != InvalidResourceID ? m_Args.Reflection : "";
+	JobSystem::Submit([=]() { IBLCache::Save(cachePath, backgroundPath, reflectionPath, *images); });
 }
\ No newline at end of file
@@ -8,13 +8,28 @@ using namespace std;
 using namespace Engine;
 using namespace Engine::Graphics;
 
-Framebuffer::Framebuffer(FramebufferSpec& specs) : m_Specs(specs), m_ID(GL_INVALID_VALUE), m_DepthAttachment(nullptr)
+Framebuffer::Framebuffer(FramebufferSpec& specs) : m_Specs(specs), m_ID(GL_INVALID_VALUE), m_OwnsAttachments(true), m_DepthAttachment(nullptr)
 {
 	m_DesiredSamples = m_Specs.Samples;
 	if (m_Specs.SwapchainTarget)
 		m_ID = 0;
 }
 
+Framebuffer::Framebuffer(vector<RenderTexture*> colourAttachments, RenderTexture* depthAttachment) :
+	m_ID(GL_INVALID_VALUE),
+	m_OwnsAttachments(false),
+	m_DepthAttachment(depthAttachment),
+	m_ColourAttachments(colourAttachments)
+{
+	RenderTexture* first = colourAttachments.empty() ? depthAttachment : colourAttachments[0];
+	if (first)
+	{
+		m_Specs.Resolution = first->GetResolution();
+		m_Specs.Samples = first->GetSamples();
+	}
+	m_DesiredSamples = m_Specs.Samples;
+}
+
 Framebuffer::~Framebuffer() { Destroy(); }
 
 void Framebuffer::Destroy()
@@ -28,6 +43,9 @@ void Framebuffer::Destroy()
 	glDeleteFramebuffers(1, &m_ID);
 	m_ID = GL_INVALID_VALUE;
 
+	if (!m_OwnsAttachments)
+		return; // Kept to be attached again when recreated
+
 	for (auto& texture : m_ColourAttachments)
 	{
 		if (texture == m_DepthAttachment)
@@ -91,14 +109,15 @@ void Framebuffer::Create()
 			);
 			texture->Bind();
 
-			m_ColourAttachments.emplace_back(texture);
-
-			GLenum attachmentType = (GLenum)(GL_COLOR_ATTACHMENT0 + (m_ColourAttachments.size() - 1));
+			GLenum attachmentType = (GLenum)(GL_COLOR_ATTACHMENT0 + m_ColourAttachments.size());
 			if (m_Specs.Attachments[i].Format == TextureFormat::Depth16 ||
 				m_Specs.Attachments[i].Format == TextureFormat::Depth24)
 				attachmentType = GL_DEPTH_ATTACHMENT;
 
-			if (attachmentType == GL_DEPTH_ATTACHMENT && !m_DepthAttachment)
+			// Depth textures are not counted as colour attachments, so can be blitted & sampled alongside them
+			if (attachmentType != GL_DEPTH_ATTACHMENT)
+				m_ColourAttachments.emplace_back(texture);
+			else if (!m_DepthAttachment)
 				m_DepthAttachment = texture;
 
 			GLenum textureTarget = GetTextureTarget(m_Specs.Attachments[i].Format, m_Specs.Samples > 1, m_Specs.Attachments[i].DepthInfo);
@@ -150,6 +169,9 @@ void Framebuffer::Create()
 		}
 	}
 
+	if (!m_OwnsAttachments)
+		AttachExisting();
+
 	// Draw buffers
 	vector<GLenum> colourBuffers;
 	for (unsigned int i = 0; i < m_ColourAttachments.size(); i++)
@@ -174,9 +196,36 @@ void Framebuffer::Create()
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void Framebuffer::AttachExisting()
+{
+	for (unsigned int i = 0; i < (unsigned int)m_ColourAttachments.size(); i++)
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_COLOR_ATTACHMENT0 + i,
+			GetTextureTarget(m_ColourAttachments[i]->GetFormat(), m_ColourAttachments[i]->GetSamples() > 1),
+			m_ColourAttachments[i]->GetID(),
+			0 // Mipmap level
+		);
+
+	if (!m_DepthAttachment)
+		return;
+
+	if (m_DepthAttachment->GetFormat() == TextureFormat::RenderBuffer)
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthAttachment->GetID());
+	else
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_DEPTH_ATTACHMENT,
+			GetTextureTarget(m_DepthAttachment->GetFormat(), m_DepthAttachment->GetSamples() > 1),
+			m_DepthAttachment->GetID(),
+			0 // Mipmap level
+		);
+}
+
 void Framebuffer::Recreate()
 {
-	if (m_Specs.SwapchainTarget)
+	// Existing attachments are resized by their owner
+	if (m_Specs.SwapchainTarget || !m_OwnsAttachments)
 		return;
 
 	if (m_ID == GL_INVALID_VALUE)
@@ -211,6 +260,26 @@ void Framebuffer::BlitTo(Framebuffer* other, GLbitfield bufferFlags, GLenum filt
 	);
 }
 
+void Framebuffer::BlitTo(Framebuffer* other, ivec4 region, GLbitfield bufferFlags, GLenum filter)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, other ? other->m_ID : 0);
+	glBlitFramebuffer(
+		// Source x,y, width, height
+		region.x, region.y,
+		region.x + region.z,
+		region.y + region.w,
+		// Destination x,y, width, height
+		region.x, region.y,
+		region.x + region.z,
+		region.y + region.w,
+		// Mask (e.g. Colour, Depth)
+		bufferFlags,
+		// Filter
+		filter
+	);
+}
+
 void Framebuffer::CopyAttachmentTo(RenderTexture* destination, unsigned int colourAttachment)
 {
 	// GetColourAttachment(colourAttachment)->CopyTo(destination);
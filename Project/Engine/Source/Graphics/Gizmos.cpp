@@ -1,5 +1,9 @@
+#include <cstddef>
+#include <algorithm>
 #include <Engine/Utilities.hpp>
+#include <Engine/Application.hpp>
 #include <Engine/Graphics/Mesh.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <Engine/Graphics/Gizmos.hpp>
 #include <Engine/ResourceManager.hpp>
@@ -9,13 +13,17 @@
 
 using namespace std;
 using namespace glm;
+using namespace Engine;
 using namespace Engine::Physics;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
 Gizmos* Gizmos::s_Instance = nullptr;
 
-Gizmos::Gizmos() : m_Material()
+// Segments in each of the three circles outlining a wire sphere
+const unsigned int WireSphereSegments = 32;
+
+Gizmos::Gizmos() : m_Materials()
 {
 	if (!s_Instance)
 		s_Instance = this;
@@ -25,20 +33,45 @@ Gizmos::~Gizmos()
 {
 	if (s_Instance == this)
 		s_Instance = nullptr;
+
+	if (m_LineVAO == GL_INVALID_VALUE)
+		return; // Lines never drawn
+
+	glDeleteBuffers(1, &m_LineVBO);
+	glDeleteVertexArrays(1, &m_LineVAO);
 }
 
 void Gizmos::SetLineWidth(float width) { s_Instance->m_LineWidth = width; }
-void Gizmos::SetColour(glm::vec3 colour) { s_Instance->m_Material.Albedo = vec4(colour.r, colour.g, colour.b, 1.0f); }
-void Gizmos::SetColour(glm::vec4 colour) { s_Instance->m_Material.Albedo = colour; }
-void Gizmos::SetColour(float r, float g, float b, float a) { s_Instance->m_Material.Albedo = { r, g, b, a }; }
+void Gizmos::SetColour(glm::vec3 colour) { s_Instance->m_Colour = vec4(colour.r, colour.g, colour.b, 1.0f); }
+void Gizmos::SetColour(glm::vec4 colour) { s_Instance->m_Colour = colour; }
+void Gizmos::SetColour(float r, float g, float b, float a) { s_Instance->m_Colour = { r, g, b, a }; }
+
+void Gizmos::ResetMaterials() { s_Instance->m_MaterialsUsed = 0; }
+
+ResourceID Gizmos::GetMaterial()
+{
+	vector<Material>& materials = s_Instance->m_Materials;
+	unsigned int& used = s_Instance->m_MaterialsUsed;
+
+	// Check for material already used this frame
+	for (unsigned int i = 0; i < used; i++)
+		if (materials[i].Albedo == s_Instance->m_Colour)
+			return materials[i].Instance.ID;
+
+	if (used >= (unsigned int)materials.size())
+		materials.emplace_back(Material());
+
+	Material& material = materials[used++];
+	material.Albedo = s_Instance->m_Colour;
+	return material.GetInstance();
+}
 
 void Gizmos::Draw(ResourceID& mesh, glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
 {
-	s_Instance->m_Material.Wireframe = false;
 	Renderer::Submit(DrawCall
 		{
 			mesh,
-			s_Instance->m_Material,
+			GetMaterial(),
 			position,
 			scale,
 			eulerAngleXYZ(rotation.x, rotation.y, rotation.z),
@@ -48,11 +81,10 @@ void Gizmos::Draw(ResourceID& mesh, glm::vec3 position, glm::vec3 scale, glm::ve
 
 void Gizmos::DrawQuad(vec3 position, vec2 scale, vec3 rotation)
 {
-	s_Instance->m_Material.Wireframe = false;
 	Renderer::Submit(DrawCall
 		{
 			Mesh::Quad(),
-			s_Instance->m_Material,
+			GetMaterial(),
 			position,
 			{ scale.x, scale.y, 1 },
 			eulerAngleXYZ(rotation.x, rotation.y, rotation.z)
@@ -61,11 +93,10 @@ void Gizmos::DrawQuad(vec3 position, vec2 scale, vec3 rotation)
 
 void Gizmos::DrawCube(vec3 position, vec3 scale, vec3 rotation)
 {
-	s_Instance->m_Material.Wireframe = false;
 	Renderer::Submit(DrawCall
 		{
 			Mesh::Cube(),
-			s_Instance->m_Material,
+			GetMaterial(),
 			position,
 			scale,
 			eulerAngleXYZ(rotation.x, rotation.y, rotation.z)
@@ -74,95 +105,168 @@ void Gizmos::DrawCube(vec3 position, vec3 scale, vec3 rotation)
 
 void Gizmos::DrawSphere(vec3 position, float radius)
 {
-	s_Instance->m_Material.Wireframe = false;
 	Renderer::Submit(DrawCall
 		{
 			Mesh::Sphere(),
-			s_Instance->m_Material,
+			GetMaterial(),
 			position,
 			{ radius, radius, radius },
 			mat4(1.0f)
 		});
 }
 
+void Gizmos::AddLine(vec3 start, vec3 end)
+{
+	vector<LineBatch>& batches = s_Instance->m_LineBatches;
+	auto it = find_if(batches.begin(), batches.end(), [](LineBatch& batch) { return batch.Width == s_Instance->m_LineWidth; });
+	if (it == batches.end())
+	{
+		batches.emplace_back(LineBatch { s_Instance->m_LineWidth });
+		it = batches.end() - 1;
+	}
+
+	it->Vertices.emplace_back(LineVertex { start, s_Instance->m_Colour });
+	it->Vertices.emplace_back(LineVertex { end, s_Instance->m_Colour });
+}
+
+void Gizmos::DrawLines()
+{
+	vector<LineBatch>& batches = s_Instance->m_LineBatches;
+	unsigned int vertexCount = 0;
+	for (LineBatch& batch : batches)
+		vertexCount += (unsigned int)batch.Vertices.size();
+	if (vertexCount == 0)
+		return;
+
+	if (s_Instance->m_LineVAO == GL_INVALID_VALUE)
+	{
+		s_Instance->m_LineShader = ResourceManager::LoadNamed<Shader>("Shaders/GizmoLines",
+			ShaderStageInfo
+			{
+				Application::AssetDir + "Shaders/GizmoLines.vert",
+				Application::AssetDir + "Shaders/GizmoLines.frag"
+			});
+
+		glGenVertexArrays(1, &s_Instance->m_LineVAO);
+		glGenBuffers(1, &s_Instance->m_LineVBO);
+
+		glBindVertexArray(s_Instance->m_LineVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, s_Instance->m_LineVBO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, Position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, Colour));
+		glBindVertexArray(0);
+	}
+
+	// Buffer is orphaned each frame so the previous frame's draws aren't waited on
+	glBindBuffer(GL_ARRAY_BUFFER, s_Instance->m_LineVBO);
+	while (vertexCount > s_Instance->m_LineCapacity)
+		s_Instance->m_LineCapacity = glm::max(s_Instance->m_LineCapacity * 2, 1024u);
+	glBufferData(GL_ARRAY_BUFFER, s_Instance->m_LineCapacity * sizeof(LineVertex), nullptr, GL_STREAM_DRAW);
+
+	unsigned int offset = 0;
+	for (LineBatch& batch : batches)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(LineVertex), batch.Vertices.size() * sizeof(LineVertex), batch.Vertices.data());
+		offset += (unsigned int)batch.Vertices.size();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	Shader* shader = ResourceManager::Get<Shader>(s_Instance->m_LineShader);
+	if (shader)
+	{
+		shader->Bind();
+		glBindVertexArray(s_Instance->m_LineVAO);
+
+		offset = 0;
+		for (LineBatch& batch : batches)
+		{
+			if (batch.Vertices.empty())
+				continue;
+
+			glLineWidth(batch.Width);
+			glDrawArrays(GL_LINES, (GLint)offset, (GLsizei)batch.Vertices.size());
+			offset += (unsigned int)batch.Vertices.size();
+		}
+
+		glBindVertexArray(0);
+		glLineWidth(1.0f);
+		shader->Unbind();
+	}
+
+	for (LineBatch& batch : batches)
+		batch.Vertices.clear();
+}
+
 void Gizmos::DrawWireQuad(vec3 position, vec2 scale, vec3 rotation) { DrawWireQuad(position, scale, eulerAngleXYZ(rotation.x, rotation.y, rotation.z)); }
 void Gizmos::DrawWireQuad(vec3 position, vec2 scale, mat4 rotation)
 {
-	s_Instance->m_Material.Wireframe = true;
-	Renderer::Submit(DrawCall
-		{
-			Mesh::Quad(),
-			s_Instance->m_Material,
-			position,
-			{ scale.x, scale.y, 1 },
-			rotation,
-			s_Instance->m_LineWidth
-		});
+	// Matches the extents of Mesh::Quad
+	vec3 right = vec3(rotation * vec4(scale.x, 0, 0, 0));
+	vec3 up = vec3(rotation * vec4(0, scale.y, 0, 0));
+
+	vec3 corners[4] =
+	{
+		position - right - up,
+		position + right - up,
+		position + right + up,
+		position - right + up
+	};
+	for (unsigned int i = 0; i < 4; i++)
+		AddLine(corners[i], corners[(i + 1) % 4]);
 }
 
 void Gizmos::DrawWireCube(vec3 position, vec3 scale, vec3 rotation) { DrawWireCube(position, scale, eulerAngleXYZ(rotation.x, rotation.y, rotation.z)); }
 void Gizmos::DrawWireCube(vec3 position, vec3 scale, mat4 rotation)
 {
-	s_Instance->m_Material.Wireframe = true;
-	Renderer::Submit(DrawCall
-		{
-			Mesh::Cube(),
-			s_Instance->m_Material,
-			position,
-			scale,
-			rotation,
-			s_Instance->m_LineWidth
-		});
+	// Scale is half the size on each axis, as with collider extents
+	vec3 corners[8];
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		vec3 corner = { i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f };
+		corners[i] = position + vec3(rotation * vec4(corner * scale, 0.0f));
+	}
+
+	// Corners differing by a single axis are joined
+	for (unsigned int i = 0; i < 8; i++)
+		for (unsigned int axis : { 1u, 2u, 4u })
+			if (!(i & axis))
+				AddLine(corners[i], corners[i | axis]);
 }
 
 void Gizmos::DrawWireSphere(vec3 position, float radius)
 {
-	s_Instance->m_Material.Wireframe = true;
-	Renderer::Submit(DrawCall
-		{
-			Mesh::Sphere(),
-			s_Instance->m_Material,
-			position,
-			{ radius, radius, radius },
-			mat4(1.0f),
-			s_Instance->m_LineWidth
-		});
-}
+	// Circle around each axis
+	for (unsigned int i = 0; i < WireSphereSegments; i++)
+	{
+		float a = two_pi<float>() * i / (float)WireSphereSegments;
+		float b = two_pi<float>() * (i + 1) / (float)WireSphereSegments;
+		vec2 start = vec2(cos(a), sin(a)) * radius;
+		vec2 end = vec2(cos(b), sin(b)) * radius;
 
-void Gizmos::DrawLine(vec3 start, vec3 end)
-{
-	s_Instance->m_Material.Wireframe = false;
-	ResourceID id = ResourceManager::Load<Mesh>(vector<Mesh::Vertex>
-		{
-			{ start }, { end } // Vertices
-		}, vector<unsigned int>(), Mesh::DrawMode::Lines);
-	Renderer::Submit(DrawCall
-		{
-			id,
-			s_Instance->m_Material,
-			vec3(0),
-			vec3 { 1, 1, 1 },
-			mat4(1.0f),
-			s_Instance->m_LineWidth,
-			true  // Delete mesh after rendered
-		});
+		AddLine(position + vec3(start.x, start.y, 0), position + vec3(end.x, end.y, 0));
+		AddLine(position + vec3(start.x, 0, start.y), position + vec3(end.x, 0, end.y));
+		AddLine(position + vec3(0, start.x, start.y), position + vec3(0, end.x, end.y));
+	}
 }
 
+void Gizmos::DrawLine(vec3 start, vec3 end) { AddLine(start, end); }
+
 void Gizmos::DrawGrid(glm::vec3 position, unsigned int gridSize, glm::vec3 scale, glm::vec3 rotation)
 {
-	s_Instance->m_Material.Wireframe = false;
-	ResourceID gridID = Mesh::Grid(gridSize);
-	Renderer::Submit(DrawCall
-		{
-			gridID,
-			s_Instance->m_Material,
-			position,
-			scale,
-			eulerAngleXYZ(rotation.x, rotation.y, rotation.z),
-			s_Instance->m_LineWidth,
-			true  // Delete mesh after draw
-		});
+	if (gridSize == 0)
+		return;
+
+	// Spans [0, 1] on the X & Z axes before transforming, as with Mesh::Grid
+	mat4 transform = translate(mat4(1.0f), position) * eulerAngleXYZ(rotation.x, rotation.y, rotation.z) * glm::scale(mat4(1.0f), scale);
+	for (unsigned int i = 0; i <= gridSize; i++)
+	{
+		float t = i / (float)gridSize;
+		AddLine(vec3(transform * vec4(t, 0, 0, 1)), vec3(transform * vec4(t, 0, 1, 1)));
+		AddLine(vec3(transform * vec4(0, 0, t, 1)), vec3(transform * vec4(1, 0, t, 1)));
+	}
 }
 
 void Gizmos::DrawLine(Line line) { DrawLine(line.Start, line.End); }
-void Gizmos::DrawRay(Ray ray) { DrawLine(ray.Origin, ray.Origin + ray.Direction * 1000.0f); }
+void Gizmos::DrawRay(Ray ray) { DrawLine(ray.Origin, ray.Origin + ray.Direction * 1000.0f); }
\ No newline at end of file
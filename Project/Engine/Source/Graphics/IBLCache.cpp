@@ -0,0 +1,216 @@
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <glm/gtc/packing.hpp>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/IBLCache.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+namespace fs = std::filesystem;
+
+// "IBLC" when read as bytes
+const uint32_t IBLCacheMagic = 0x434C4249;
+
+const string IBLCacheExtension = ".ibl";
+
+// Level alignment within the file
+const uint64_t IBLLevelAlignment = 16;
+
+uint64_t AlignIBLLevel(uint64_t offset) { return (offset + IBLLevelAlignment - 1) & ~(IBLLevelAlignment - 1); }
+
+/// <returns>False if path has changed since size, writeTime & hash were recorded</returns>
+bool IsSourceUnchanged(string& path, uint64_t size, int64_t writeTime, uint64_t hash)
+{
+	if (path.empty())
+		return size == 0 && hash == 0;
+
+	uint64_t sourceSize = 0;
+	int64_t sourceWriteTime = 0;
+	if (!MappedFile::GetFileInfo(path, sourceSize, sourceWriteTime))
+		return true; // Source missing, cache is all there is
+
+	if (sourceSize != size)
+		return false;
+
+	// Source was touched, only outdated if the contents changed
+	return sourceWriteTime == writeTime || MappedFile::HashFile(path) == hash;
+}
+
+IBLCache::IBLCache() : m_File(), m_Header(nullptr), m_Entries(nullptr) { }
+
+bool IBLCache::Open(string cachePath, string backgroundPath, string reflectionPath)
+{
+	Close();
+	if (!m_File.Open(cachePath))
+		return false;
+
+	if (!Validate(backgroundPath, reflectionPath))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool IBLCache::Validate(string& backgroundPath, string& reflectionPath)
+{
+	size_t fileSize = m_File.GetSize();
+	if (fileSize < sizeof(Header))
+		return false;
+
+	m_Header = (const Header*)m_File.GetData();
+	if (m_Header->Magic != IBLCacheMagic || m_Header->Version != Version)
+		return false;
+
+	if (!IsSourceUnchanged(backgroundPath, m_Header->BackgroundSize, m_Header->BackgroundWriteTime, m_Header->BackgroundHash) ||
+		!IsSourceUnchanged(reflectionPath, m_Header->ReflectionSize, m_Header->ReflectionWriteTime, m_Header->ReflectionHash))
+		return false;
+
+	// Bounds checks, guards against truncated files
+	uint64_t tableEnd = sizeof(Header) + (uint64_t)m_Header->ImageCount * sizeof(ImageEntry);
+	if (tableEnd > fileSize)
+		return false;
+	m_Entries = (const ImageEntry*)(m_File.GetData() + sizeof(Header));
+
+	for (uint32_t i = 0; i < m_Header->ImageCount; i++)
+	{
+		const ImageEntry& image = m_Entries[i];
+		if (image.MipCount == 0 || image.Product > (uint32_t)Product::BRDF)
+			return false;
+
+		uint64_t offset = image.Offset;
+		for (unsigned int level = 0; level < image.MipCount; level++)
+			offset = AlignIBLLevel(offset + GetLevelSize(image, level));
+		if (offset > fileSize)
+			return false;
+	}
+	return true;
+}
+
+void IBLCache::Close()
+{
+	m_File.Close();
+	m_Header = nullptr;
+	m_Entries = nullptr;
+}
+
+const IBLCache::ImageEntry* IBLCache::GetImage(Product product) const
+{
+	if (!m_Header)
+		return nullptr;
+
+	for (uint32_t i = 0; i < m_Header->ImageCount; i++)
+		if (m_Entries[i].Product == (uint32_t)product)
+			return &m_Entries[i];
+	return nullptr;
+}
+
+const uint16_t* IBLCache::GetLevelData(const ImageEntry& image, unsigned int level) const
+{
+	uint64_t offset = image.Offset;
+	for (unsigned int i = 0; i < level; i++)
+		offset = AlignIBLLevel(offset + GetLevelSize(image, i));
+	return (const uint16_t*)(m_File.GetData() + offset);
+}
+
+string IBLCache::GetPath(string backgroundPath) { return backgroundPath + IBLCacheExtension; }
+
+size_t IBLCache::GetLevelSize(const ImageEntry& image, unsigned int level)
+{
+	size_t width = std::max(image.Width >> level, 1u);
+	size_t height = std::max(image.Height >> level, 1u);
+	return width * height * image.ChannelCount * image.FaceCount * sizeof(uint16_t);
+}
+
+bool IBLCache::Save(string cachePath, string backgroundPath, string reflectionPath, vector<Image>& images)
+{
+	vector<ImageEntry> entries;
+	uint64_t offset = sizeof(Header) + images.size() * sizeof(ImageEntry);
+	for (Image& image : images)
+	{
+		ImageEntry entry = {};
+		entry.Product = (uint32_t)image.Type;
+		entry.FaceCount = image.FaceCount;
+		entry.MipCount = (uint32_t)image.Levels.size();
+		entry.ChannelCount = image.ChannelCount;
+		entry.Width = image.Width;
+		entry.Height = image.Height;
+		entry.Offset = offset = AlignIBLLevel(offset);
+
+		for (unsigned int level = 0; level < entry.MipCount; level++)
+		{
+			if (image.Levels[level].size() * sizeof(uint16_t) != GetLevelSize(entry, level))
+			{
+				Log::Warning("Cannot save environment map cache '" + cachePath + "' - image level has incorrect size");
+				return false;
+			}
+			offset = AlignIBLLevel(offset + GetLevelSize(entry, level));
+		}
+		entries.emplace_back(entry);
+	}
+
+	Header header = {};
+	header.Magic = IBLCacheMagic;
+	header.Version = Version;
+	header.ImageCount = (uint32_t)entries.size();
+	if (MappedFile::GetFileInfo(backgroundPath, header.BackgroundSize, header.BackgroundWriteTime))
+		header.BackgroundHash = MappedFile::HashFile(backgroundPath);
+	if (!reflectionPath.empty() && MappedFile::GetFileInfo(reflectionPath, header.ReflectionSize, header.ReflectionWriteTime))
+		header.ReflectionHash = MappedFile::HashFile(reflectionPath);
+
+	// Written beside the cache & renamed, so a partially written cache is never read
+	string tempPath = cachePath + ".tmp";
+	{
+		ofstream file(tempPath, ios::out | ios::binary | ios::trunc);
+		if (!file)
+		{
+			Log::Warning("Failed to write environment map cache '" + cachePath + "'");
+			return false;
+		}
+
+		const char padding[IBLLevelAlignment] = {};
+		auto pad = [&]()
+		{
+			uint64_t position = (uint64_t)file.tellp();
+			file.write(padding, AlignIBLLevel(position) - position);
+		};
+
+		file.write((const char*)&header, sizeof(Header));
+		file.write((const char*)entries.data(), entries.size() * sizeof(ImageEntry));
+
+		vector<uint16_t> halves;
+		for (Image& image : images)
+		{
+			for (vector<float>& level : image.Levels)
+			{
+				halves.resize(level.size());
+				for (size_t i = 0; i < level.size(); i++)
+					halves[i] = packHalf1x16(level[i]);
+
+				pad();
+				file.write((const char*)halves.data(), halves.size() * sizeof(uint16_t));
+			}
+		}
+		pad();
+
+		if (!file)
+		{
+			Log::Warning("Failed to write environment map cache '" + cachePath + "'");
+			return false;
+		}
+	}
+
+	error_code error;
+	fs::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		Log::Warning("Failed to write environment map cache '" + cachePath + "' - " + error.message());
+		fs::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <Engine/Log.hpp>
+#include <Engine/Application.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+#include <Engine/ResourceManager.hpp>
+#include <Engine/Graphics/Shader.hpp>
+#include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Components/Transform.hpp>
+#include <Engine/Graphics/LightClusters.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Jobs;
+using namespace Engine::Graphics;
+using namespace Engine::Components;
+
+constexpr UniformHandle LightBufferUniform("lightBuffer");
+constexpr UniformHandle LightClusterGridUniform("lightClusterGrid");
+constexpr UniformHandle LightClusterIndicesUniform("lightClusterIndices");
+constexpr UniformHandle InverseProjectionUniform("inverseProjection");
+constexpr UniformHandle MaxLightsPerClusterUniform("maxLightsPerCluster");
+
+// Texture slots reserved for light buffers
+const unsigned int LightBufferSlot = 11;
+const unsigned int ClusterGridSlot = 12;
+const unsigned int ClusterIndicesSlot = 13;
+
+const unsigned int ClustersPerSlice = CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+
+LightClusters::LightClusters() :
+	m_ComputeCulling(false),
+	m_CullingShader(InvalidResourceID),
+	m_Lights(),
+	m_DirectionalCount(0),
+	m_PointCount(0),
+	m_BoundsProjection(0.0f),
+	m_Grid(CLUSTER_COUNT),
+	m_SliceIndices(CLUSTER_COUNT_Z),
+	m_SliceCandidates(CLUSTER_COUNT_Z),
+	m_SliceOverflow(CLUSTER_COUNT_Z),
+	m_OverflowCount(0),
+	m_OverflowLogged(false),
+	m_OverflowBuffer(GL_INVALID_VALUE),
+	m_OverflowFence(nullptr)
+{
+	m_LightBuffer.Format = GL_RGBA32F;
+	m_GridBuffer.Format = GL_RG32I;
+	m_IndexBuffer.Format = GL_R32I;
+
+	if (Renderer::SupportsCompute())
+		m_CullingShader = ResourceManager::LoadNamed<Shader>("Shaders/LightCulling",
+			ShaderStageInfo
+			{
+				"", // Vertex
+				"", // Fragment
+				Application::AssetDir + "Shaders/Misc/LightCulling.comp"
+			});
+}
+
+LightClusters::~LightClusters()
+{
+	Destroy(m_LightBuffer);
+	Destroy(m_GridBuffer);
+	Destroy(m_IndexBuffer);
+
+	if (m_OverflowFence)
+		glDeleteSync(m_OverflowFence);
+	if (m_OverflowBuffer != GL_INVALID_VALUE)
+		glDeleteBuffers(1, &m_OverflowBuffer);
+}
+
+void LightClusters::RecordOverflow(unsigned int count)
+{
+	m_OverflowCount = count;
+	if (count == 0 || m_OverflowLogged)
+		return;
+
+	Log::Warning(to_string(count) + " lights were left out of clusters holding more than " +
+		to_string(MAX_LIGHTS_PER_CLUSTER) + " lights (MAX_LIGHTS_PER_CLUSTER), lighting is missing where lights are densest");
+	m_OverflowLogged = true;
+}
+
+unsigned int LightClusters::GetOverflowCount() { return m_OverflowCount; }
+
+unsigned int LightClusters::GetLightCount() { return (unsigned int)m_Lights.size(); }
+unsigned int LightClusters::GetDirectionalLightCount() { return m_DirectionalCount; }
+unsigned int LightClusters::GetPointLightCount() { return m_PointCount; }
+unsigned int LightClusters::GetSpotLightCount() { return (unsigned int)m_Lights.size() - m_DirectionalCount - m_PointCount; }
+
+bool LightClusters::GetComputeCulling() { return m_ComputeCulling; }
+void LightClusters::SetComputeCulling(bool enable) { m_ComputeCulling = enable; }
+
+#pragma region Texture Buffers
+void LightClusters::Reserve(TextureBuffer& buffer, unsigned int size)
+{
+	size = std::max(size, 16u); // Buffer textures require a data store
+	if (buffer.Buffer != GL_INVALID_VALUE && size <= buffer.Capacity)
+		return;
+
+	if (buffer.Buffer == GL_INVALID_VALUE)
+	{
+		glGenBuffers(1, &buffer.Buffer);
+		glGenTextures(1, &buffer.Texture);
+	}
+
+	// Grow geometrically to avoid reallocating every time a light is added
+	buffer.Capacity = std::max(size, buffer.Capacity * 2);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer.Buffer);
+	glBufferData(GL_TEXTURE_BUFFER, buffer.Capacity, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_BUFFER, buffer.Texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, buffer.Format, buffer.Buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Upload(TextureBuffer& buffer, const void* data, unsigned int size)
+{
+	Reserve(buffer, size);
+	if (size == 0)
+		return;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer.Buffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::Destroy(TextureBuffer& buffer)
+{
+	if (buffer.Buffer == GL_INVALID_VALUE)
+		return;
+
+	glDeleteTextures(1, &buffer.Texture);
+	glDeleteBuffers(1, &buffer.Buffer);
+
+	buffer.Capacity = 0;
+	buffer.Buffer = buffer.Texture = GL_INVALID_VALUE;
+}
+#pragma endregion
+
+void LightClusters::SetLights(vector<Light*>& lights)
+{
+	m_Lights.resize(lights.size());
+
+	// Directional lights affect every cluster, store them first so they can be skipped when culling.
+	// Point & spot lights follow in contiguous ranges so light volumes can be drawn instanced per type.
+	m_DirectionalCount = m_PointCount = 0;
+	for (Light* light : lights)
+	{
+		if (light->Type == LightType::Directional)
+			m_DirectionalCount++;
+		else if (light->Type == LightType::Point)
+			m_PointCount++;
+	}
+
+	unsigned int offsets[] = { 0, m_DirectionalCount, m_DirectionalCount + m_PointCount };
+	for (Light* light : lights)
+	{
+		unsigned int& offset = light->Type == LightType::Directional ? offsets[0] :
+							   light->Type == LightType::Point ? offsets[1] : offsets[2];
+		light->FillUniformData(m_Lights[offset++]);
+	}
+
+	Upload(m_LightBuffer, m_Lights.data(), (unsigned int)(m_Lights.size() * sizeof(LightUniformData)));
+}
+
+void LightClusters::Cull(Camera& camera)
+{
+	Shader* cullingShader = m_ComputeCulling ? ResourceManager::Get<Shader>(m_CullingShader) : nullptr;
+	if (cullingShader && cullingShader->GetProgram() != GL_INVALID_VALUE)
+		CullCompute(camera);
+	else
+		CullCPU(camera);
+}
+
+#pragma region CPU Culling
+// Point on the view ray through ndc at the given view space depth
+vec3 ViewPosition(const mat4& inverseProjection, vec2 ndc, float viewDepth)
+{
+	vec4 near = inverseProjection * vec4(ndc, -1.0f, 1.0f);
+	vec4 far = inverseProjection * vec4(ndc, 1.0f, 1.0f);
+	near /= near.w;
+	far /= far.w;
+
+	float t = (viewDepth + near.z) / (near.z - far.z);
+	return mix(vec3(near), vec3(far), t);
+}
+
+void LightClusters::BuildClusterBounds(mat4 projection, float near, float far)
+{
+	m_BoundsProjection = projection;
+	m_SliceDepths.resize(CLUSTER_COUNT_Z);
+	m_ClusterBounds.resize(CLUSTER_COUNT);
+
+	mat4 inverseProjection = inverse(projection);
+	for (unsigned int z = 0; z < CLUSTER_COUNT_Z; z++)
+	{
+		// Exponential depth distribution, matches GetClusterSlice in Light.inc
+		float sliceNear = near * pow(far / near, z / (float)CLUSTER_COUNT_Z);
+		float sliceFar = near * pow(far / near, (z + 1) / (float)CLUSTER_COUNT_Z);
+		m_SliceDepths[z] = { sliceNear, sliceFar };
+
+		for (unsigned int y = 0; y < CLUSTER_COUNT_Y; y++)
+		{
+			for (unsigned int x = 0; x < CLUSTER_COUNT_X; x++)
+			{
+				vec2 ndcMin = vec2(x, y) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0f - 1.0f;
+				vec2 ndcMax = vec2(x + 1, y + 1) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0f - 1.0f;
+
+				vec3 a = ViewPosition(inverseProjection, ndcMin, sliceNear);
+				vec3 b = ViewPosition(inverseProjection, ndcMax, sliceNear);
+				vec3 c = ViewPosition(inverseProjection, ndcMin, sliceFar);
+				vec3 d = ViewPosition(inverseProjection, ndcMax, sliceFar);
+
+				ClusterBounds& bounds = m_ClusterBounds[x + y * CLUSTER_COUNT_X + z * ClustersPerSlice];
+				bounds.Min = glm::min(glm::min(a, b), glm::min(c, d));
+				bounds.Max = glm::max(glm::max(a, b), glm::max(c, d));
+			}
+		}
+	}
+}
+
+void LightClusters::CullCPU(Camera& camera)
+{
+	mat4 projection = camera.GetProjectionMatrix();
+	if (projection != m_BoundsProjection)
+		BuildClusterBounds(projection, camera.ClipNear, camera.ClipFar);
+
+	// Bounding spheres in view space
+	mat4 view = camera.GetViewMatrix();
+	m_LightSpheres.resize(m_Lights.size() - m_DirectionalCount);
+	for (size_t i = 0; i < m_LightSpheres.size(); i++)
+	{
+		LightUniformData& light = m_Lights[m_DirectionalCount + i];
+		m_LightSpheres[i] = vec4(
+			vec3(view * vec4(light.Position, 1.0f)),
+			light.Type == (int)LightType::Spot ? light.Distance : light.Radius
+		);
+	}
+
+	// Each slice only writes to its own clusters, so slices can be processed in parallel
+	JobSystem::ParallelFor(CLUSTER_COUNT_Z, [&](unsigned int slice) { CullSlice(slice); });
+
+	// Combine slices into a single index list
+	m_Indices.clear();
+	unsigned int overflow = 0;
+	for (unsigned int slice = 0; slice < CLUSTER_COUNT_Z; slice++)
+	{
+		overflow += m_SliceOverflow[slice];
+		int offset = (int)m_Indices.size();
+		for (unsigned int i = slice * ClustersPerSlice; i < (slice + 1) * ClustersPerSlice; i++)
+			m_Grid[i].x += offset;
+		m_Indices.insert(m_Indices.end(), m_SliceIndices[slice].begin(), m_SliceIndices[slice].end());
+	}
+
+	Upload(m_GridBuffer, m_Grid.data(), (unsigned int)(m_Grid.size() * sizeof(ivec2)));
+	Upload(m_IndexBuffer, m_Indices.data(), (unsigned int)(m_Indices.size() * sizeof(int)));
+	RecordOverflow(overflow);
+}
+
+void LightClusters::CullSlice(unsigned int slice)
+{
+	vector<int>& indices = m_SliceIndices[slice];
+	vector<int>& candidates = m_SliceCandidates[slice];
+	indices.clear();
+	candidates.clear();
+	m_SliceOverflow[slice] = 0;
+
+	// Find lights overlapping the depth range of this slice
+	vec2 depthRange = m_SliceDepths[slice];
+	for (int i = 0; i < (int)m_LightSpheres.size(); i++)
+	{
+		float depth = -m_LightSpheres[i].z;
+		float radius = m_LightSpheres[i].w;
+		if (depth + radius >= depthRange.x && depth - radius <= depthRange.y)
+			candidates.emplace_back(i);
+	}
+
+	for (unsigned int cluster = slice * ClustersPerSlice; cluster < (slice + 1) * ClustersPerSlice; cluster++)
+	{
+		ClusterBounds& bounds = m_ClusterBounds[cluster];
+		int start = (int)indices.size();
+		int count = 0;
+
+		for (int candidate : candidates)
+		{
+			vec4& sphere = m_LightSpheres[candidate];
+			vec3 delta = glm::clamp(vec3(sphere), bounds.Min, bounds.Max) - vec3(sphere);
+			if (dot(delta, delta) > sphere.w * sphere.w)
+				continue;
+
+			if (count >= MAX_LIGHTS_PER_CLUSTER)
+			{
+				m_SliceOverflow[slice]++;
+				continue;
+			}
+
+			indices.emplace_back(m_DirectionalCount + candidate);
+			count++;
+		}
+
+		// Offset is relative to the slice, made absolute when slices are combined
+		m_Grid[cluster] = { start, count };
+	}
+}
+#pragma endregion
+
+void LightClusters::CullCompute(Camera& camera)
+{
+	Reserve(m_GridBuffer, CLUSTER_COUNT * sizeof(ivec2));
+	Reserve(m_IndexBuffer, CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(int));
+
+	// Read back lights dropped by the previous dispatch, skipped if it has not finished yet
+	if (m_OverflowBuffer == GL_INVALID_VALUE)
+	{
+		glGenBuffers(1, &m_OverflowBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_OverflowBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+	}
+	else
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_OverflowBuffer);
+
+	if (m_OverflowFence)
+	{
+		GLenum status = glClientWaitSync(m_OverflowFence, 0, 0);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+		{
+			GLuint overflow = 0;
+			glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &overflow);
+			RecordOverflow(overflow);
+		}
+		glDeleteSync(m_OverflowFence);
+		m_OverflowFence = nullptr;
+	}
+
+	const GLuint zero = 0;
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	Shader* shader = ResourceManager::Get<Shader>(m_CullingShader);
+	shader->Bind();
+	shader->Set(InverseProjectionUniform, inverse(camera.GetProjectionMatrix()));
+	shader->Set(MaxLightsPerClusterUniform, MAX_LIGHTS_PER_CLUSTER);
+
+	glActiveTexture(GL_TEXTURE0 + LightBufferSlot);
+	glBindTexture(GL_TEXTURE_BUFFER, m_LightBuffer.Texture);
+	shader->Set(LightBufferUniform, (int)LightBufferSlot);
+
+	glBindImageTexture(0, m_GridBuffer.Texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32I);
+	glBindImageTexture(1, m_IndexBuffer.Texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32I);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_OverflowBuffer);
+
+	// One work group per depth slice
+	glDispatchCompute(1, 1, CLUSTER_COUNT_Z);
+
+	// Results are read through buffer textures when shading
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	m_OverflowFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	shader->Unbind();
+}
+
+void LightClusters::Bind()
+{
+	glActiveTexture(GL_TEXTURE0 + LightBufferSlot);
+	glBindTexture(GL_TEXTURE_BUFFER, m_LightBuffer.Texture);
+
+	glActiveTexture(GL_TEXTURE0 + ClusterGridSlot);
+	glBindTexture(GL_TEXTURE_BUFFER, m_GridBuffer.Texture);
+
+	glActiveTexture(GL_TEXTURE0 + ClusterIndicesSlot);
+	glBindTexture(GL_TEXTURE_BUFFER, m_IndexBuffer.Texture);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::Unbind()
+{
+	for (unsigned int slot : { LightBufferSlot, ClusterGridSlot, ClusterIndicesSlot })
+	{
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::FillSamplers(Shader* shader)
+{
+	if (!shader)
+		return;
+
+	shader->Set(LightBufferUniform, (int)LightBufferSlot);
+	shader->Set(LightClusterGridUniform, (int)ClusterGridSlot);
+	shader->Set(LightClusterIndicesUniform, (int)ClusterIndicesSlot);
+}
\ No newline at end of file
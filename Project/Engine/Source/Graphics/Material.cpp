@@ -9,51 +9,44 @@ using namespace std;
 using namespace Engine;
 using namespace Engine::Graphics;
 
-void BindTexture(unsigned int index, string shaderName, ResourceID& textureID, Shader* shader)
+constexpr UniformHandle AlbedoMapUniform("materialMaps.AlbedoMap");
+constexpr UniformHandle NormalMapUniform("materialMaps.NormalMap");
+constexpr UniformHandle RoughnessMapUniform("materialMaps.RoughnessMap");
+constexpr UniformHandle MetalnessMapUniform("materialMaps.MetalnessMap");
+constexpr UniformHandle AmbientOcclusionMapUniform("materialMaps.AmbientOcclusionMap");
+
+#pragma region Material Handle
+MaterialHandle::MaterialHandle(MaterialHandle&& other) noexcept : ID(other.ID) { other.ID = InvalidResourceID; }
+
+MaterialHandle::~MaterialHandle()
 {
-	shader->Set(shaderName, (int)index);
-	glActiveTexture(GL_TEXTURE0 + index);
-	
-	if (textureID != InvalidResourceID)
-	{
-		Texture* texture = ResourceManager::Get<Texture>(textureID);
-		if (texture)
-			texture->Bind(index);
-		else
-			Graphics::Renderer::GetEmptyTexture()->Bind(index);
-	}
-	else
-		Graphics::Renderer::GetEmptyTexture()->Bind(index);
+	if (ID != InvalidResourceID && ResourceManager::IsValid(ID))
+		ResourceManager::Unload(ID);
 }
 
-void Material::FillShader(Shader* shader)
+MaterialHandle& MaterialHandle::operator =(MaterialHandle&& other) noexcept
 {
-	if (!shader)
-		return;
+	if (this == &other)
+		return *this;
 
-	shader->Set("material.AlbedoColour", Albedo);
-
-	shader->Set("material.Roughness", Roughness);
-	shader->Set("material.Metalness", Metalness);
-	shader->Set("material.AlphaClipping", AlphaClipping);
-	shader->Set("material.AlphaClipThreshold", AlphaClipThreshold);
-	shader->Set("material.TextureCoordScale", TextureCoordinateScale);
-	shader->Set("material.TextureCoordOffset", TextureCoordinateOffset);
-	
-	shader->Set("material.HasAlbedoMap", AlbedoMap != InvalidResourceID);
-	shader->Set("material.HasNormalMap", NormalMap != InvalidResourceID);
-	shader->Set("material.HasRoughnessMap", RoughnessMap != InvalidResourceID);
-	shader->Set("material.HasMetalnessMap", MetalnessMap != InvalidResourceID);
-	shader->Set("material.HasAmbientOcclusionMap", AmbientOcclusionMap != InvalidResourceID);
-
-	BindTexture(0, "material.AlbedoMap", AlbedoMap, shader);
-	BindTexture(1, "material.NormalMap", NormalMap, shader);
-	BindTexture(2, "material.RoughnessMap", RoughnessMap, shader);
-	BindTexture(3, "material.MetalnessMap", MetalnessMap, shader);
-	BindTexture(4, "material.AmbientOcclusionMap", AmbientOcclusionMap, shader);
-	// Texture Slot 5 reserved for Shadow Map
-	// Texture Slot 6 reserved for Environment Map
-	// Texture Slot 7 reserved for Irradiance Map
+	if (ID != InvalidResourceID && ResourceManager::IsValid(ID))
+		ResourceManager::Unload(ID);
+
+	ID = other.ID;
+	other.ID = InvalidResourceID;
+	return *this;
+}
+#pragma endregion
+
+#pragma region Material
+ResourceID Material::GetInstance()
+{
+	if (Instance.ID == InvalidResourceID || !ResourceManager::IsValid(Instance.ID))
+		Instance.ID = ResourceManager::Load<MaterialInstance>();
+
+	// Only the packed uniforms are compared, the buffer is re-uploaded when they differ
+	ResourceManager::Get<MaterialInstance>(Instance.ID)->Update(*this);
+	return Instance.ID;
 }
 
 void Material::Serialize(DataStream& stream)
@@ -87,4 +80,96 @@ void Material::SerializeTexture(DataStream& stream, ResourceID& textureID)
 	stream.Serialize(&path);
 	if (stream.IsReading() && !path.empty())
 		textureID = ResourceManager::LoadNamed<Texture>(name, path);
-}
\ No newline at end of file
+}
+#pragma endregion
+
+#pragma region Material Instance
+MaterialInstance::MaterialInstance() :
+	m_Dirty(true),
+	m_Buffer(UniformBlockBinding::Material, sizeof(MaterialUniformBlock)),
+	m_Uniforms(),
+	m_Textures { InvalidResourceID, InvalidResourceID, InvalidResourceID, InvalidResourceID, InvalidResourceID },
+	m_Wireframe(false) { }
+
+MaterialInstance::~MaterialInstance() { }
+
+bool MaterialInstance::IsDirty() { return m_Dirty; }
+bool MaterialInstance::IsWireframe() { return m_Wireframe; }
+bool MaterialInstance::IsTransparent() { return m_Uniforms.AlbedoColour.a < 1.0f; }
+
+void MaterialInstance::Update(Material& material)
+{
+	MaterialUniformBlock uniforms = {};
+	uniforms.AlbedoColour = material.Albedo;
+	uniforms.TextureCoordScale = material.TextureCoordinateScale;
+	uniforms.TextureCoordOffset = material.TextureCoordinateOffset;
+
+	uniforms.Roughness = material.Roughness;
+	uniforms.Metalness = material.Metalness;
+	uniforms.AlphaClipping = material.AlphaClipping ? 1 : 0;
+	uniforms.AlphaClipThreshold = material.AlphaClipThreshold;
+
+	uniforms.HasAlbedoMap = material.AlbedoMap != InvalidResourceID;
+	uniforms.HasNormalMap = material.NormalMap != InvalidResourceID;
+	uniforms.HasRoughnessMap = material.RoughnessMap != InvalidResourceID;
+	uniforms.HasMetalnessMap = material.MetalnessMap != InvalidResourceID;
+	uniforms.HasAmbientOcclusionMap = material.AmbientOcclusionMap != InvalidResourceID;
+
+	if (uniforms != m_Uniforms)
+	{
+		m_Uniforms = uniforms;
+		m_Dirty = true;
+	}
+
+	// Texture IDs & render state are read when binding, no upload required
+	m_Textures[0] = material.AlbedoMap;
+	m_Textures[1] = material.NormalMap;
+	m_Textures[2] = material.RoughnessMap;
+	m_Textures[3] = material.MetalnessMap;
+	m_Textures[4] = material.AmbientOcclusionMap;
+	m_Wireframe = material.Wireframe;
+}
+
+bool MaterialInstance::IsEquivalent(MaterialInstance& other)
+{
+	return m_Uniforms == other.m_Uniforms &&
+		memcmp(m_Textures, other.m_Textures, sizeof(m_Textures)) == 0 &&
+		m_Wireframe == other.m_Wireframe;
+}
+
+void MaterialInstance::Bind()
+{
+	if (m_Dirty)
+	{
+		m_Buffer.SetData(&m_Uniforms, sizeof(MaterialUniformBlock));
+		m_Dirty = false;
+	}
+	m_Buffer.Bind();
+
+	for (unsigned int i = 0; i < 5; i++)
+		BindTexture(i, m_Textures[i]);
+	// Texture Slot 5 reserved for Shadow Map
+	// Texture Slot 6 reserved for Environment Map
+}
+
+void MaterialInstance::BindTexture(unsigned int index, ResourceID textureID)
+{
+	Texture* texture = textureID != InvalidResourceID ? ResourceManager::Get<Texture>(textureID) : nullptr;
+	if (texture)
+		texture->Bind(index);
+	else
+		Graphics::Renderer::GetEmptyTexture()->Bind(index);
+}
+
+void MaterialInstance::FillSamplers(Shader* shader)
+{
+	if (!shader)
+		return;
+
+	shader->Set(AlbedoMapUniform, 0);
+	shader->Set(NormalMapUniform, 1);
+	shader->Set(RoughnessMapUniform, 2);
+	shader->Set(MetalnessMapUniform, 3);
+	shader->Set(AmbientOcclusionMapUniform, 4);
+}
+#pragma endregion
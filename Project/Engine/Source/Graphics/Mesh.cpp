@@ -1,16 +1,21 @@
 #include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/constants.hpp>
 #include <Engine/Application.hpp>
 #include <Engine/Graphics/Mesh.hpp>
 #include <Engine/Graphics/Model.hpp>
 #include <Engine/ResourceManager.hpp>
 #include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Graphics/MeshBuffer.hpp>
 
 using namespace glm;
 using namespace std;
 using namespace Engine;
 using namespace Engine::Graphics;
 
-Mesh::Mesh() : m_Vertices(), m_Setup(true), m_Indices(), m_VAO(GL_INVALID_VALUE), m_VBO(), m_EBO(), m_DrawMode(DrawMode::Triangles) { }
+Mesh::VertexFormat Mesh::s_DefaultVertexFormat = Mesh::VertexFormat::Compact;
+
+Mesh::Mesh() : m_Vertices(), m_Setup(true), m_Indices(), m_VertexCount(0), m_IndexCount(0), m_VAO(GL_INVALID_VALUE), m_VBO(), m_EBO(), m_DrawMode(DrawMode::Triangles), m_Shared(false), m_VertexFormat(s_DefaultVertexFormat), m_Allocation(), m_BoundsMin(0.0f), m_BoundsMax(0.0f) { }
 
 Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, DrawMode drawMode) : Mesh()
 {
@@ -18,6 +23,38 @@ Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, DrawMode drawM
 	m_DrawMode = drawMode;
 	m_Vertices = vertices;
 	m_Indices = indices;
+	m_VertexCount = (unsigned int)m_Vertices.size();
+	m_IndexCount = (unsigned int)m_Indices.size();
+
+	CalculateBounds();
+}
+
+Mesh::Mesh(PackedData data, bool shared) : Mesh()
+{
+	m_VertexCount = data.VertexCount;
+	m_IndexCount = data.IndexCount;
+	m_BoundsMin = data.BoundsMin;
+	m_BoundsMax = data.BoundsMax;
+
+	if (shared && m_IndexCount > 0)
+	{
+		m_Shared = true;
+		MeshBuffer* meshBuffer = Renderer::GetMeshBuffer();
+		if (meshBuffer->GetVertexFormat() == data.Format)
+			m_Allocation = meshBuffer->Allocate(data.Vertices, data.VertexCount, data.Indices, data.IndexCount);
+		else
+		{
+			// Shared buffer uses another layout, repack
+			vector<Vertex> vertices = UnpackVertices(data.Vertices, data.VertexCount, data.Format);
+			vector<unsigned int> indices(data.Indices, data.Indices + data.IndexCount);
+			m_Allocation = meshBuffer->Allocate(vertices, indices);
+		}
+		m_VertexFormat = meshBuffer->GetVertexFormat();
+		return;
+	}
+
+	m_VertexFormat = data.Format;
+	CreateBuffers(data.Vertices, (size_t)data.VertexCount * GetVertexSize(data.Format), data.Indices, data.IndexCount);
 }
 
 Mesh::~Mesh()
@@ -32,8 +69,30 @@ Mesh::~Mesh()
 
 void Mesh::SetData(std::vector<Vertex>& vertices, std::vector<unsigned int> indices)
 {
+	bool sameSize = vertices.size() == m_Vertices.size() && indices.size() == m_Indices.size();
+
 	m_Vertices = vertices;
 	m_Indices = indices;
+	m_VertexCount = (unsigned int)m_Vertices.size();
+	m_IndexCount = (unsigned int)m_Indices.size();
+
+	CalculateBounds();
+
+	if (m_Shared)
+	{
+		if (!m_Setup)
+			return; // Uploaded when first drawn
+
+		// Shared buffer space is never freed, resized meshes are appended to the end
+		if (sameSize)
+			Renderer::GetMeshBuffer()->Update(m_Allocation, m_Vertices, m_Indices);
+		else
+		{
+			Log::Warning("Resizing shared mesh, previous space in the shared mesh buffer is not reclaimed");
+			m_Allocation = Renderer::GetMeshBuffer()->Allocate(m_Vertices, m_Indices);
+		}
+		return;
+	}
 
 	if (m_VAO == GL_INVALID_VALUE)
 	{
@@ -41,9 +100,11 @@ void Mesh::SetData(std::vector<Vertex>& vertices, std::vector<unsigned int> indi
 		return;
 	}
 
+	vector<unsigned char> vertexData = PackVertices(m_Vertices, m_VertexFormat);
+
 	glBindVertexArray(m_VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, m_Vertices.size() * sizeof(Vertex), &m_Vertices[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size(), vertexData.data());
 
 	if (m_Indices.size() > 0)
 	{
@@ -54,26 +115,209 @@ void Mesh::SetData(std::vector<Vertex>& vertices, std::vector<unsigned int> indi
 	glBindVertexArray(0);
 }
 
-void Mesh::Setup()
+void Mesh::CalculateBounds()
 {
-	// Generate buffers
-	glGenBuffers(1, &m_VBO);
-	glGenBuffers(1, &m_EBO);
-	glGenVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
+	if (m_Vertices.empty())
+	{
+		m_BoundsMin = m_BoundsMax = vec3(0.0f);
+		return;
+	}
 
-	// Fill vertex data
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(Vertex), &m_Vertices[0], GL_STATIC_DRAW);
+	m_BoundsMin = m_BoundsMax = m_Vertices[0].Position;
+	for (Vertex& vertex : m_Vertices)
+	{
+		m_BoundsMin = glm::min(m_BoundsMin, vertex.Position);
+		m_BoundsMax = glm::max(m_BoundsMax, vertex.Position);
+	}
+}
 
-	// Fill index data
-	if (m_Indices.size() > 0)
+void Mesh::AddLOD(ResourceID mesh, float screenSize)
+{
+	if (!m_LODs.empty() && screenSize >= m_LODs.back().ScreenSize)
+		Log::Warning("LODs should be added with decreasing screen size");
+	m_LODs.emplace_back(LODLevel { mesh, screenSize });
+}
+
+void Mesh::ClearLODs() { m_LODs.clear(); }
+
+unsigned int Mesh::SelectLOD(float screenSize, unsigned int currentLOD)
+{
+	unsigned int lod = glm::min(currentLOD, (unsigned int)m_LODs.size());
+
+	// Lower detail once well below the next level's screen size
+	while (lod < m_LODs.size() && screenSize < m_LODs[lod].ScreenSize * (1.0f - LODHysteresis))
+		lod++;
+
+	// Higher detail once well above the current level's screen size
+	while (lod > 0 && screenSize > m_LODs[lod - 1].ScreenSize * (1.0f + LODHysteresis))
+		lod--;
+
+	return lod;
+}
+
+void Mesh::SetShared(bool shared)
+{
+	if (m_Setup && m_Shared != shared)
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(unsigned int), &m_Indices[0], GL_STATIC_DRAW);
+		Log::Warning("Cannot change if mesh is shared after it has been uploaded");
+		return;
+	}
+
+	if (shared && (m_Indices.empty() || m_DrawMode != DrawMode::Triangles))
+	{
+		Log::Warning("Only indexed triangle meshes can be stored in the shared mesh buffer");
+		return;
+	}
+
+	m_Shared = shared;
+}
+
+void Mesh::SetVertexFormat(VertexFormat format)
+{
+	if (m_Setup && m_VertexFormat != format)
+	{
+		Log::Warning("Cannot change vertex format of mesh after it has been uploaded");
+		return;
+	}
+	m_VertexFormat = format;
+}
+
+void Mesh::SetDefaultVertexFormat(VertexFormat format) { s_DefaultVertexFormat = format; }
+Mesh::VertexFormat Mesh::GetDefaultVertexFormat() { return s_DefaultVertexFormat; }
+
+unsigned int Mesh::GetVertexSize(VertexFormat format)
+{
+	switch (format)
+	{
+	default:
+	case VertexFormat::Full: return sizeof(Vertex);
+	case VertexFormat::Compact: return sizeof(CompactVertex);
+	case VertexFormat::CompactHalfPosition: return sizeof(CompactHalfPositionVertex);
+	}
+}
+
+vector<unsigned char> Mesh::PackVertices(vector<Vertex>& vertices, VertexFormat format)
+{
+	vector<unsigned char> data(vertices.size() * GetVertexSize(format));
+	if (vertices.empty())
+		return data;
+
+	if (format == VertexFormat::Full)
+	{
+		memcpy(data.data(), vertices.data(), data.size());
+		return data;
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Vertex& vertex = vertices[i];
+
+		// Bitangent is rebuilt from the normal & tangent, only handedness is stored
+		float bitangentSign = dot(cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+
+		uint32_t normal = packSnorm3x10_1x2(vec4(vertex.Normal, 0.0f));
+		uint32_t tangent = packSnorm3x10_1x2(vec4(vertex.Tangent, bitangentSign));
+		uint32_t texCoords = packHalf2x16(vertex.TexCoords);
+
+		if (format == VertexFormat::Compact)
+		{
+			((CompactVertex*)data.data())[i] = { vertex.Position, normal, tangent, texCoords };
+			continue;
+		}
+
+		CompactHalfPositionVertex& packed = ((CompactHalfPositionVertex*)data.data())[i];
+		uint64_t position = packHalf4x16(vec4(vertex.Position, 1.0f));
+		memcpy(packed.Position, &position, sizeof(packed.Position));
+		packed.Normal = normal;
+		packed.Tangent = tangent;
+		packed.TexCoords = texCoords;
+	}
+	return data;
+}
+
+vector<Mesh::Vertex> Mesh::UnpackVertices(const unsigned char* data, unsigned int vertexCount, VertexFormat format)
+{
+	vector<Vertex> vertices(vertexCount);
+	if (vertexCount == 0)
+		return vertices;
+
+	if (format == VertexFormat::Full)
+	{
+		memcpy(vertices.data(), data, vertexCount * sizeof(Vertex));
+		return vertices;
+	}
+
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		Vertex& vertex = vertices[i];
+		uint32_t normal, tangent, texCoords;
+		if (format == VertexFormat::Compact)
+		{
+			const CompactVertex& packed = ((const CompactVertex*)data)[i];
+			vertex.Position = packed.Position;
+			normal = packed.Normal;
+			tangent = packed.Tangent;
+			texCoords = packed.TexCoords;
+		}
+		else
+		{
+			const CompactHalfPositionVertex& packed = ((const CompactHalfPositionVertex*)data)[i];
+			uint64_t position = 0;
+			memcpy(&position, packed.Position, sizeof(packed.Position));
+			vertex.Position = vec3(unpackHalf4x16(position));
+			normal = packed.Normal;
+			tangent = packed.Tangent;
+			texCoords = packed.TexCoords;
+		}
+
+		vec4 unpackedTangent = unpackSnorm3x10_1x2(tangent);
+		vertex.Normal = vec3(unpackSnorm3x10_1x2(normal));
+		vertex.Tangent = vec3(unpackedTangent);
+		vertex.TexCoords = unpackHalf2x16(texCoords);
+		vertex.Bitangent = cross(vertex.Normal, vertex.Tangent) * (unpackedTangent.w < 0.0f ? -1.0f : 1.0f);
+	}
+	return vertices;
+}
+
+void Mesh::Upload()
+{
+	if (!m_Setup)
+		Setup();
+}
+
+Mesh::SharedAllocation& Mesh::GetSharedAllocation()
+{
+	Upload();
+	return m_Allocation;
+}
+
+void Mesh::SetupVertexAttributes(VertexFormat format)
+{
+	if (format != VertexFormat::Full)
+	{
+		bool halfPosition = format == VertexFormat::CompactHalfPosition;
+		GLsizei stride = (GLsizei)GetVertexSize(format);
+		size_t normalOffset = halfPosition ? offsetof(CompactHalfPositionVertex, Normal) : offsetof(CompactVertex, Normal);
+		size_t tangentOffset = halfPosition ? offsetof(CompactHalfPositionVertex, Tangent) : offsetof(CompactVertex, Tangent);
+		size_t texCoordsOffset = halfPosition ? offsetof(CompactHalfPositionVertex, TexCoords) : offsetof(CompactVertex, TexCoords);
+
+		// Position
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, halfPosition ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, stride, (void*)0);
+		// Normal
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)normalOffset);
+		// Texture Coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)texCoordsOffset);
+		// Tangent, w is bitangent sign
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)tangentOffset);
+		// Bitangent is not stored, reads as zero & is rebuilt in the vertex shader
+		glDisableVertexAttribArray(4);
+		return;
 	}
 
-	// Vertex data layout
 	// Position
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -89,6 +333,44 @@ void Mesh::Setup()
 	// Bitangent
 	glEnableVertexAttribArray(4);
 	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+}
+
+void Mesh::Setup()
+{
+	if (m_Shared)
+	{
+		MeshBuffer* meshBuffer = Renderer::GetMeshBuffer();
+		m_Allocation = meshBuffer->Allocate(m_Vertices, m_Indices);
+		m_VertexFormat = meshBuffer->GetVertexFormat();
+		m_Setup = true;
+		return;
+	}
+
+	vector<unsigned char> vertexData = PackVertices(m_Vertices, m_VertexFormat);
+	CreateBuffers(vertexData.data(), vertexData.size(), m_Indices.data(), (unsigned int)m_Indices.size());
+}
+
+void Mesh::CreateBuffers(const unsigned char* vertexData, size_t vertexDataSize, const unsigned int* indices, unsigned int indexCount)
+{
+	// Generate buffers
+	glGenBuffers(1, &m_VBO);
+	glGenBuffers(1, &m_EBO);
+	glGenVertexArrays(1, &m_VAO);
+	glBindVertexArray(m_VAO);
+
+	// Fill vertex data
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexDataSize, vertexData, GL_STATIC_DRAW);
+
+	// Fill index data
+	if (indexCount > 0)
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	}
+
+	// Vertex data layout
+	SetupVertexAttributes(m_VertexFormat);
 
 	// Unbind VAO to prevent data being overriden accidentally
 	glBindVertexArray(0);
@@ -96,8 +378,11 @@ void Mesh::Setup()
 	m_Setup = true;
 }
 
-void Mesh::Draw()
+void Mesh::Draw(unsigned int instances)
 {
+	if (instances == 0)
+		return;
+
 	if (!m_Setup)
 		Setup();
 
@@ -105,11 +390,34 @@ void Mesh::Draw()
 	if (!Renderer::GetPipeline()->CurrentShader()->GetStages().TessellationEvaluate.empty())
 		drawMode = GL_PATCHES;
 
+	if (m_Shared)
+	{
+		MeshBuffer* meshBuffer = Renderer::GetMeshBuffer();
+		meshBuffer->Bind();
+		glDrawElementsInstancedBaseVertex(
+			drawMode,
+			(GLsizei)m_Allocation.IndexCount,
+			GL_UNSIGNED_INT,
+			(void*)(m_Allocation.FirstIndex * sizeof(unsigned int)),
+			(GLsizei)instances,
+			m_Allocation.BaseVertex
+		);
+		meshBuffer->Unbind();
+		return;
+	}
+
 	glBindVertexArray(m_VAO);
-	if (m_Indices.size() > 0)
-		glDrawElements(drawMode, (GLsizei)m_Indices.size(), GL_UNSIGNED_INT, 0);
+	if (instances > 1)
+	{
+		if (m_IndexCount > 0)
+			glDrawElementsInstanced(drawMode, (GLsizei)m_IndexCount, GL_UNSIGNED_INT, 0, (GLsizei)instances);
+		else
+			glDrawArraysInstanced(drawMode, 0, (GLint)m_VertexCount, (GLsizei)instances);
+	}
+	else if (m_IndexCount > 0)
+		glDrawElements(drawMode, (GLsizei)m_IndexCount, GL_UNSIGNED_INT, 0);
 	else
-		glDrawArrays(drawMode, 0, (GLint)m_Vertices.size());
+		glDrawArrays(drawMode, 0, (GLint)m_VertexCount);
 	glBindVertexArray(0);
 }
 
@@ -256,4 +564,89 @@ ResourceID& Mesh::Sphere()
 	ResourceID modelID = ResourceManager::LoadNamed<Model>("PrimitiveSphere", Application::AssetDir + "Models/Primitives/Sphere.fbx");
 	Model* model = ResourceManager::Get<Model>(modelID);
 	return (sphereMeshID = model->GetMeshes()[0]);
+}
+
+ResourceID& Mesh::LightSphere()
+{
+	static ResourceID sphereMeshID = InvalidResourceID;
+	if (sphereMeshID != InvalidResourceID)
+		return sphereMeshID;
+
+	const unsigned int Stacks = 8;
+	const unsigned int Slices = 16;
+
+	// Push vertices out so flat faces do not cut into the unit sphere
+	const float Scale = 1.0f / (cos(pi<float>() / Slices) * cos(pi<float>() / Stacks));
+
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	for (unsigned int i = 0; i <= Stacks; i++)
+	{
+		float theta = pi<float>() * i / (float)Stacks;
+		for (unsigned int j = 0; j <= Slices; j++)
+		{
+			float phi = two_pi<float>() * j / (float)Slices;
+			vec3 normal = { sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi) };
+			vertices.emplace_back(Vertex { normal * Scale, normal, { j / (float)Slices, i / (float)Stacks } });
+		}
+	}
+
+	for (unsigned int i = 0; i < Stacks; i++)
+	{
+		for (unsigned int j = 0; j < Slices; j++)
+		{
+			unsigned int a = i * (Slices + 1) + j;
+			unsigned int b = a + Slices + 1;
+			indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+		}
+	}
+
+	const string PrimitiveLightSphereName = "PrimitiveLightSphere";
+	if (ResourceManager::IsValid(PrimitiveLightSphereName))
+		sphereMeshID = *ResourceManager::Get<ResourceID>(PrimitiveLightSphereName);
+	else
+	{
+		sphereMeshID = ResourceManager::Load<Mesh>(vertices, indices);
+		ResourceManager::LoadNamed<ResourceID>(PrimitiveLightSphereName, sphereMeshID);
+	}
+	return sphereMeshID;
+}
+
+ResourceID& Mesh::LightCone()
+{
+	static ResourceID coneMeshID = InvalidResourceID;
+	if (coneMeshID != InvalidResourceID)
+		return coneMeshID;
+
+	const unsigned int Slices = 16;
+
+	// Push base vertices out so flat sides do not cut into the unit cone
+	const float Scale = 1.0f / cos(pi<float>() / Slices);
+
+	vector<Vertex> vertices =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } }, // Apex
+		{ { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f,  1.0f } }  // Base centre
+	};
+	vector<unsigned int> indices;
+	for (unsigned int i = 0; i < Slices; i++)
+	{
+		float phi = two_pi<float>() * i / (float)Slices;
+		vec2 ring = vec2(cos(phi), sin(phi));
+		vertices.emplace_back(Vertex { vec3(ring * Scale, 1.0f), normalize(vec3(ring, -1.0f)) });
+
+		unsigned int current = 2 + i;
+		unsigned int next = 2 + (i + 1) % Slices;
+		indices.insert(indices.end(), { 0, next, current, 1, current, next });
+	}
+
+	const string PrimitiveLightConeName = "PrimitiveLightCone";
+	if (ResourceManager::IsValid(PrimitiveLightConeName))
+		coneMeshID = *ResourceManager::Get<ResourceID>(PrimitiveLightConeName);
+	else
+	{
+		coneMeshID = ResourceManager::Load<Mesh>(vertices, indices);
+		ResourceManager::LoadNamed<ResourceID>(PrimitiveLightConeName, coneMeshID);
+	}
+	return coneMeshID;
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include <glad/glad.h>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/MeshBuffer.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+// Initial capacities, doubled whenever exceeded
+const unsigned int InitialVertexCapacity = 65536;
+const unsigned int InitialIndexCapacity = 196608;
+const unsigned int InitialInstanceCapacity = 1024;
+
+MeshBuffer::MeshBuffer() :
+	m_VAO(GL_INVALID_VALUE),
+	m_VBO(GL_INVALID_VALUE),
+	m_EBO(GL_INVALID_VALUE),
+	m_InstanceBuffer(GL_INVALID_VALUE),
+	m_CommandBuffer(GL_INVALID_VALUE),
+	m_VertexFormat(Mesh::VertexFormat::Full),
+	m_VertexCount(0),
+	m_VertexCapacity(0),
+	m_IndexCount(0),
+	m_IndexCapacity(0),
+	m_InstanceCapacity(0),
+	m_CommandCapacity(0) { }
+
+MeshBuffer::~MeshBuffer()
+{
+	if (m_VAO == GL_INVALID_VALUE)
+		return; // Not created
+
+	glDeleteBuffers(1, &m_VBO);
+	glDeleteBuffers(1, &m_EBO);
+	glDeleteBuffers(1, &m_InstanceBuffer);
+	glDeleteBuffers(1, &m_CommandBuffer);
+	glDeleteVertexArrays(1, &m_VAO);
+}
+
+void MeshBuffer::Create()
+{
+	glGenVertexArrays(1, &m_VAO);
+
+	m_VertexFormat = Mesh::GetDefaultVertexFormat();
+	m_VertexCapacity = InitialVertexCapacity;
+	m_IndexCapacity = InitialIndexCapacity;
+	m_InstanceCapacity = m_CommandCapacity = InitialInstanceCapacity;
+
+	glGenBuffers(1, &m_VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, m_VertexCapacity * Mesh::GetVertexSize(m_VertexFormat), nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_EBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_EBO);
+	glBufferData(GL_ARRAY_BUFFER, m_IndexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_InstanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity * sizeof(mat4), nullptr, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &m_CommandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_CommandCapacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	SetupAttributes();
+}
+
+void MeshBuffer::SetupAttributes()
+{
+	glBindVertexArray(m_VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	Mesh::SetupVertexAttributes(m_VertexFormat);
+
+	// Model matrix takes four attribute locations, one per column
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(InstanceMatrixLocation + i);
+		glVertexAttribPointer(InstanceMatrixLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), (void*)(sizeof(vec4) * i));
+		glVertexAttribDivisor(InstanceMatrixLocation + i, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshBuffer::Grow(unsigned int& buffer, GLenum target, size_t usedSize, size_t newSize, GLenum usage)
+{
+	unsigned int newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, usage);
+
+	if (usedSize > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &buffer);
+	buffer = newBuffer;
+
+	// Vertex array still references the deleted buffer
+	if (target != GL_DRAW_INDIRECT_BUFFER)
+		SetupAttributes();
+}
+
+Mesh::SharedAllocation MeshBuffer::Allocate(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+
+	vector<unsigned char> vertexData = Mesh::PackVertices(vertices, m_VertexFormat);
+	return Allocate(vertexData.data(), (unsigned int)vertices.size(), indices.data(), (unsigned int)indices.size());
+}
+
+Mesh::SharedAllocation MeshBuffer::Allocate(const unsigned char* vertexData, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+
+	unsigned int vertexSize = Mesh::GetVertexSize(m_VertexFormat);
+	unsigned int vertexCapacity = m_VertexCapacity;
+	while (m_VertexCount + vertexCount > vertexCapacity)
+		vertexCapacity *= 2;
+	if (vertexCapacity != m_VertexCapacity)
+	{
+		Grow(m_VBO, GL_ARRAY_BUFFER, m_VertexCount * vertexSize, vertexCapacity * vertexSize, GL_STATIC_DRAW);
+		m_VertexCapacity = vertexCapacity;
+	}
+
+	unsigned int indexCapacity = m_IndexCapacity;
+	while (m_IndexCount + indexCount > indexCapacity)
+		indexCapacity *= 2;
+	if (indexCapacity != m_IndexCapacity)
+	{
+		Grow(m_EBO, GL_ELEMENT_ARRAY_BUFFER, m_IndexCount * sizeof(unsigned int), indexCapacity * sizeof(unsigned int), GL_STATIC_DRAW);
+		m_IndexCapacity = indexCapacity;
+	}
+
+	Mesh::SharedAllocation allocation;
+	allocation.BaseVertex = (int)m_VertexCount;
+	allocation.FirstIndex = m_IndexCount;
+	allocation.IndexCount = indexCount;
+
+	m_VertexCount += vertexCount;
+	m_IndexCount += indexCount;
+
+	if (vertexCount > 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, allocation.BaseVertex * vertexSize, (size_t)vertexCount * vertexSize, vertexData);
+	}
+
+	if (indexCount > 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_EBO);
+		glBufferSubData(GL_ARRAY_BUFFER, allocation.FirstIndex * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return allocation;
+}
+
+void MeshBuffer::Update(Mesh::SharedAllocation& allocation, vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	if (indices.size() != allocation.IndexCount)
+	{
+		Log::Warning("Cannot change index count of a shared mesh allocation");
+		return;
+	}
+
+	if (!vertices.empty())
+	{
+		vector<unsigned char> vertexData = Mesh::PackVertices(vertices, m_VertexFormat);
+		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, allocation.BaseVertex * Mesh::GetVertexSize(m_VertexFormat), vertexData.size(), vertexData.data());
+	}
+
+	if (!indices.empty())
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_EBO);
+		glBufferSubData(GL_ARRAY_BUFFER, allocation.FirstIndex * sizeof(unsigned int), indices.size() * sizeof(unsigned int), &indices[0]);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshBuffer::SetInstances(vector<mat4>& modelMatrices)
+{
+	if (modelMatrices.empty())
+		return;
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+
+	if (modelMatrices.size() > m_InstanceCapacity)
+	{
+		while (modelMatrices.size() > m_InstanceCapacity)
+			m_InstanceCapacity *= 2;
+
+		// Previous contents are fully replaced
+		Grow(m_InstanceBuffer, GL_ARRAY_BUFFER, 0, m_InstanceCapacity * sizeof(mat4), GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, modelMatrices.size() * sizeof(mat4), &modelMatrices[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshBuffer::SetCommands(vector<DrawElementsIndirectCommand>& commands)
+{
+	if (commands.empty())
+		return;
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+
+	if (commands.size() > m_CommandCapacity)
+	{
+		while (commands.size() > m_CommandCapacity)
+			m_CommandCapacity *= 2;
+		Grow(m_CommandBuffer, GL_DRAW_INDIRECT_BUFFER, 0, m_CommandCapacity * sizeof(DrawElementsIndirectCommand), GL_DYNAMIC_DRAW);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), &commands[0]);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void MeshBuffer::DrawIndirect(GLenum drawMode, unsigned int first, unsigned int count)
+{
+	if (count == 0 || m_VAO == GL_INVALID_VALUE)
+		return;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+	glMultiDrawElementsIndirect(
+		drawMode,
+		GL_UNSIGNED_INT,
+		(void*)(first * sizeof(DrawElementsIndirectCommand)),
+		(GLsizei)count,
+		0 // Tightly packed
+	);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+unsigned int MeshBuffer::GetCommandBuffer() { return m_CommandBuffer; }
+
+void MeshBuffer::Bind()
+{
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+	glBindVertexArray(m_VAO);
+}
+
+void MeshBuffer::Unbind() { glBindVertexArray(0); }
+
+Mesh::VertexFormat MeshBuffer::GetVertexFormat()
+{
+	if (m_VAO == GL_INVALID_VALUE)
+		Create();
+	return m_VertexFormat;
+}
\ No newline at end of file
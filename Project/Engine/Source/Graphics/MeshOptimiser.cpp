@@ -0,0 +1,502 @@
+#include <cmath>
+#include <algorithm>
+#include <unordered_set>
+#include <Engine/Graphics/MeshOptimiser.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+// Forsyth scoring parameters
+const unsigned int VertexCacheSize = 32; // Simulated LRU cache
+const float CacheDecayPower = 1.5f;
+const float LastTriangleScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+// Size of FIFO cache used to find cluster boundaries, matching CalculateACMR's default
+const unsigned int ClusterCacheSize = 16;
+
+// Simplification stops after this many passes, even if the target is not reached
+const unsigned int MaxSimplifyPasses = 32;
+
+/// <summary>
+/// Symmetric 4x4 matrix measuring squared distance to a set of planes, upper triangle stored
+/// </summary>
+struct Quadric
+{
+	double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+	double a11 = 0, a12 = 0, a13 = 0;
+	double a22 = 0, a23 = 0;
+	double a33 = 0;
+
+	Quadric() = default;
+
+	/// <summary>
+	/// Plane with unit normal (a, b, c) & offset d
+	/// </summary>
+	Quadric(double a, double b, double c, double d) :
+		a00(a * a), a01(a * b), a02(a * c), a03(a * d),
+		a11(b * b), a12(b * c), a13(b * d),
+		a22(c * c), a23(c * d),
+		a33(d * d) { }
+
+	Quadric& operator +=(const Quadric& other)
+	{
+		a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+		a11 += other.a11; a12 += other.a12; a13 += other.a13;
+		a22 += other.a22; a23 += other.a23;
+		a33 += other.a33;
+		return *this;
+	}
+
+	Quadric operator +(const Quadric& other) const { Quadric result = *this; return result += other; }
+
+	double Evaluate(const vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		return a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x +
+			a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y +
+			a22 * z * z + 2.0 * a23 * z +
+			a33;
+	}
+};
+
+/// <summary>
+/// Checks if moving vertex 'from' onto 'to' would flip or collapse any triangle using 'from', other than those being removed
+/// </summary>
+bool CollapseFlipsTriangle(
+	vector<Mesh::Vertex>& vertices,
+	vector<unsigned int>& indices,
+	vector<unsigned int>& adjacencyOffsets,
+	vector<unsigned int>& adjacency,
+	unsigned int from, unsigned int to)
+{
+	for (unsigned int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+	{
+		unsigned int* triangle = &indices[adjacency[i] * 3];
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			continue; // Removed by collapse
+
+		vec3 before[3], after[3];
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			before[j] = vertices[triangle[j]].Position;
+			after[j] = triangle[j] == from ? vertices[to].Position : before[j];
+		}
+
+		vec3 normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+		vec3 normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+		if (dot(normalBefore, normalAfter) <= 0.0f)
+			return true;
+	}
+	return false;
+}
+
+float GetVertexScore(int cachePosition, unsigned int remainingValence)
+{
+	if (remainingValence == 0)
+		return -1.0f; // No triangles left to use this vertex
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// Vertices of the last triangle are scored lower, so the strip does not double back on itself
+		if (cachePosition < 3)
+			score = LastTriangleScore;
+		else
+			score = pow(1.0f - (cachePosition - 3) / (float)(VertexCacheSize - 3), CacheDecayPower);
+	}
+
+	// Prioritise vertices with few triangles remaining, to avoid leaving lone triangles behind
+	score += ValenceBoostScale * pow((float)remainingValence, -ValenceBoostPower);
+	return score;
+}
+
+MeshOptimiser::Stats MeshOptimiser::Optimise(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	Stats stats;
+	if (indices.size() < 3 || indices.size() % 3 != 0)
+		return stats;
+
+	stats.ACMRBefore = CalculateACMR(indices, (unsigned int)vertices.size());
+
+	OptimiseVertexCache(indices, (unsigned int)vertices.size());
+	stats.ClusterCount = OptimiseOverdraw(vertices, indices);
+	OptimiseVertexFetch(vertices, indices);
+
+	stats.ACMRAfter = CalculateACMR(indices, (unsigned int)vertices.size());
+	return stats;
+}
+
+void MeshOptimiser::OptimiseVertexCache(vector<unsigned int>& indices, unsigned int vertexCount)
+{
+	unsigned int triangleCount = (unsigned int)indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex, remaining triangles are kept at the front of each range
+	vector<unsigned int> remainingValence(vertexCount, 0);
+	for (unsigned int index : indices)
+		remainingValence[index]++;
+
+	vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for (unsigned int i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingValence[i];
+
+	vector<unsigned int> adjacency(indices.size());
+	vector<unsigned int> adjacencyCursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (unsigned int i = 0; i < (unsigned int)indices.size(); i++)
+		adjacency[adjacencyCursor[indices[i]]++] = i / 3;
+
+	vector<int> cachePositions(vertexCount, -1);
+	vector<float> vertexScores(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+		vertexScores[i] = GetVertexScore(-1, remainingValence[i]);
+
+	vector<float> triangleScores(triangleCount);
+	for (unsigned int i = 0; i < triangleCount; i++)
+		triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+	vector<bool> triangleAdded(triangleCount, false);
+	vector<unsigned int> output;
+	output.reserve(indices.size());
+
+	vector<unsigned int> cache, newCache;
+	cache.reserve(VertexCacheSize + 3);
+	newCache.reserve(VertexCacheSize + 3);
+
+	int bestTriangle = 0;
+	unsigned int searchCursor = 0;
+	for (unsigned int added = 0; added < triangleCount; added++)
+	{
+		// No candidates in cache, continue from the first triangle not yet added
+		if (bestTriangle < 0)
+		{
+			while (triangleAdded[searchCursor])
+				searchCursor++;
+			bestTriangle = (int)searchCursor;
+		}
+
+		unsigned int* triangle = &indices[bestTriangle * 3];
+		output.insert(output.end(), { triangle[0], triangle[1], triangle[2] });
+		triangleAdded[bestTriangle] = true;
+
+		// Remove triangle from the remaining triangles of its vertices
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			unsigned int vertex = triangle[i];
+			unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+			unsigned int* end = begin + remainingValence[vertex];
+			unsigned int* it = find(begin, end, (unsigned int)bestTriangle);
+			if (it != end)
+			{
+				*it = *(end - 1);
+				remainingValence[vertex]--;
+			}
+		}
+
+		// Triangle's vertices move to the front of the cache
+		newCache.assign(triangle, triangle + 3);
+		for (unsigned int vertex : cache)
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache.emplace_back(vertex);
+
+		// Update scores of all vertices which were or are in the cache, including those just evicted
+		for (unsigned int i = 0; i < (unsigned int)newCache.size(); i++)
+		{
+			unsigned int vertex = newCache[i];
+			cachePositions[vertex] = i < VertexCacheSize ? (int)i : -1;
+
+			float score = GetVertexScore(cachePositions[vertex], remainingValence[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+
+			for (unsigned int j = 0; j < remainingValence[vertex]; j++)
+				triangleScores[adjacency[adjacencyOffsets[vertex] + j]] += delta;
+		}
+
+		// Next triangle is the highest scoring one using a cached vertex
+		float bestScore = -1.0f;
+		bestTriangle = -1;
+		for (unsigned int i = 0; i < (unsigned int)newCache.size() && i < VertexCacheSize; i++)
+		{
+			unsigned int vertex = newCache[i];
+			for (unsigned int j = 0; j < remainingValence[vertex]; j++)
+			{
+				unsigned int adjacent = adjacency[adjacencyOffsets[vertex] + j];
+				if (triangleScores[adjacent] > bestScore)
+				{
+					bestScore = triangleScores[adjacent];
+					bestTriangle = (int)adjacent;
+				}
+			}
+		}
+
+		if (newCache.size() > VertexCacheSize)
+			newCache.resize(VertexCacheSize);
+		swap(cache, newCache);
+	}
+
+	indices = move(output);
+}
+
+unsigned int MeshOptimiser::OptimiseOverdraw(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	unsigned int triangleCount = (unsigned int)indices.size() / 3;
+	if (triangleCount == 0)
+		return 0;
+
+	// Cluster boundaries are where all of a triangle's vertices miss the cache,
+	// reordering clusters there leaves the cache efficiency mostly unchanged
+	vector<unsigned int> clusterStarts;
+	vector<unsigned int> cacheTimestamps(vertices.size(), 0);
+	unsigned int timestamp = ClusterCacheSize + 1;
+	for (unsigned int i = 0; i < triangleCount; i++)
+	{
+		unsigned int misses = 0;
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			unsigned int vertex = indices[i * 3 + j];
+			if (timestamp - cacheTimestamps[vertex] > ClusterCacheSize)
+			{
+				cacheTimestamps[vertex] = timestamp++;
+				misses++;
+			}
+		}
+
+		if (misses == 3 || i == 0)
+			clusterStarts.emplace_back(i);
+	}
+
+	unsigned int clusterCount = (unsigned int)clusterStarts.size();
+	if (clusterCount <= 1)
+		return clusterCount;
+	clusterStarts.emplace_back(triangleCount);
+
+	// Centroid of the whole mesh
+	vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	vector<vec3> clusterCentroids(clusterCount, vec3(0.0f));
+	vector<vec3> clusterNormals(clusterCount, vec3(0.0f));
+	vector<float> clusterAreas(clusterCount, 0.0f);
+	for (unsigned int cluster = 0; cluster < clusterCount; cluster++)
+	{
+		for (unsigned int i = clusterStarts[cluster]; i < clusterStarts[cluster + 1]; i++)
+		{
+			vec3& a = vertices[indices[i * 3]].Position;
+			vec3& b = vertices[indices[i * 3 + 1]].Position;
+			vec3& c = vertices[indices[i * 3 + 2]].Position;
+
+			// Length of cross product is twice the triangle area
+			vec3 normal = cross(b - a, c - a);
+			float area = length(normal);
+
+			clusterCentroids[cluster] += (a + b + c) / 3.0f * area;
+			clusterNormals[cluster] += normal;
+			clusterAreas[cluster] += area;
+		}
+
+		meshCentroid += clusterCentroids[cluster];
+		meshArea += clusterAreas[cluster];
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	// Clusters facing away from the centre of the mesh are likely visible & occlude others, draw them first
+	vector<float> sortKeys(clusterCount, 0.0f);
+	for (unsigned int cluster = 0; cluster < clusterCount; cluster++)
+	{
+		if (clusterAreas[cluster] <= 0.0f)
+			continue;
+
+		vec3 centroid = clusterCentroids[cluster] / clusterAreas[cluster];
+		float normalLength = length(clusterNormals[cluster]);
+		if (normalLength > 0.0f)
+			sortKeys[cluster] = dot(centroid - meshCentroid, clusterNormals[cluster] / normalLength);
+	}
+
+	vector<unsigned int> clusterOrder(clusterCount);
+	for (unsigned int i = 0; i < clusterCount; i++)
+		clusterOrder[i] = i;
+	stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (unsigned int cluster : clusterOrder)
+		output.insert(output.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	indices = move(output);
+
+	return clusterCount;
+}
+
+void MeshOptimiser::OptimiseVertexFetch(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	const unsigned int Unassigned = ~0u;
+	vector<unsigned int> remap(vertices.size(), Unassigned);
+
+	vector<Mesh::Vertex> output;
+	output.reserve(vertices.size());
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == Unassigned)
+		{
+			remap[index] = (unsigned int)output.size();
+			output.emplace_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = move(output);
+}
+
+vector<unsigned int> MeshOptimiser::Simplify(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices, unsigned int targetIndexCount, float maxError)
+{
+	vector<unsigned int> result = indices;
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	if (result.size() % 3 != 0)
+		return result;
+
+	// Sum of planes of all triangles using each vertex
+	vector<Quadric> quadrics(vertexCount);
+	for (unsigned int i = 0; i < (unsigned int)result.size(); i += 3)
+	{
+		vec3& a = vertices[result[i]].Position;
+		vec3& b = vertices[result[i + 1]].Position;
+		vec3& c = vertices[result[i + 2]].Position;
+
+		vec3 normal = cross(b - a, c - a);
+		float area = length(normal);
+		if (area <= 0.0f)
+			continue;
+		normal /= area;
+
+		Quadric plane(normal.x, normal.y, normal.z, -dot(normal, a));
+		for (unsigned int j = 0; j < 3; j++)
+			quadrics[result[i + j]] += plane;
+	}
+
+	// Edges only used in one direction are open, their vertices are locked to preserve borders & seams
+	unordered_set<unsigned long long> edges;
+	for (unsigned int i = 0; i < (unsigned int)result.size(); i += 3)
+		for (unsigned int j = 0; j < 3; j++)
+			edges.emplace(((unsigned long long)result[i + j] << 32) | result[i + (j + 1) % 3]);
+
+	vector<bool> locked(vertexCount, false);
+	for (unsigned long long edge : edges)
+	{
+		unsigned int a = (unsigned int)(edge >> 32), b = (unsigned int)edge;
+		if (edges.find(((unsigned long long)b << 32) | a) == edges.end())
+			locked[a] = locked[b] = true;
+	}
+
+	struct Collapse
+	{
+		unsigned int From, To;
+		double Error;
+	};
+	vector<Collapse> collapses;
+	vector<bool> touched(vertexCount);
+	vector<unsigned int> adjacencyOffsets(vertexCount + 1), adjacency;
+
+	for (unsigned int pass = 0; pass < MaxSimplifyPasses && result.size() > targetIndexCount; pass++)
+	{
+		// Triangles using each vertex, for flip checks
+		fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (unsigned int index : result)
+			adjacencyOffsets[index + 1]++;
+		for (unsigned int i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+		adjacency.resize(result.size());
+		vector<unsigned int> adjacencyCursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (unsigned int i = 0; i < (unsigned int)result.size(); i++)
+			adjacency[adjacencyCursor[result[i]]++] = i / 3;
+
+		// Collapse each vertex onto a neighbour, keeping the neighbour's position & attributes
+		collapses.clear();
+		for (unsigned int i = 0; i < (unsigned int)result.size(); i += 3)
+		{
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				unsigned int a = result[i + j], b = result[i + (j + 1) % 3];
+				if (!locked[a])
+					collapses.emplace_back(Collapse { a, b, (quadrics[a] + quadrics[b]).Evaluate(vertices[b].Position) });
+				if (!locked[b])
+					collapses.emplace_back(Collapse { b, a, (quadrics[a] + quadrics[b]).Evaluate(vertices[a].Position) });
+			}
+		}
+		sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Error < b.Error; });
+
+		// Each collapse removes around two triangles
+		unsigned int collapseLimit = std::max(1u, (unsigned int)(result.size() - targetIndexCount) / 6);
+		unsigned int collapseCount = 0;
+
+		fill(touched.begin(), touched.end(), false);
+		vector<unsigned int> remap(vertexCount);
+		for (unsigned int i = 0; i < vertexCount; i++)
+			remap[i] = i;
+
+		for (Collapse& collapse : collapses)
+		{
+			if (collapse.Error > maxError || collapseCount >= collapseLimit)
+				break;
+			if (touched[collapse.From] || touched[collapse.To])
+				continue;
+			if (CollapseFlipsTriangle(vertices, result, adjacencyOffsets, adjacency, collapse.From, collapse.To))
+				continue;
+
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To] += quadrics[collapse.From];
+			collapseCount++;
+
+			// Neighbouring triangles changed shape, flip checks using this pass' adjacency are no longer valid
+			for (unsigned int i = adjacencyOffsets[collapse.From]; i < adjacencyOffsets[collapse.From + 1]; i++)
+				for (unsigned int j = 0; j < 3; j++)
+					touched[result[adjacency[i] * 3 + j]] = true;
+		}
+
+		if (collapseCount == 0)
+			break; // Error limit reached, or every remaining collapse is invalid
+
+		// Apply collapses & remove triangles which became degenerate
+		unsigned int writeIndex = 0;
+		for (unsigned int i = 0; i < (unsigned int)result.size(); i += 3)
+		{
+			unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	return result;
+}
+
+float MeshOptimiser::CalculateACMR(vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	unsigned int triangleCount = (unsigned int)indices.size() / 3;
+	if (triangleCount == 0)
+		return 0.0f;
+
+	// Vertex is in cache if it was added within the last cacheSize misses
+	vector<unsigned int> cacheTimestamps(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (timestamp - cacheTimestamps[index] > cacheSize)
+		{
+			cacheTimestamps[index] = timestamp++;
+			misses++;
+		}
+	}
+
+	return misses / (float)triangleCount;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <filesystem>
+#include <algorithm>
 #include <Engine/Log.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
@@ -9,12 +10,19 @@
 #include <Engine/Graphics/Shader.hpp>
 #include <Engine/ResourceManager.hpp>
 #include <Engine/Graphics/Texture.hpp>
+#include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+#include <Engine/Graphics/ModelCache.hpp>
+#include <Engine/Graphics/MeshOptimiser.hpp>
 #include <Engine/Components/Graphics/MeshRenderer.hpp>
+#include <Engine/Components/Graphics/ModelPlaceholder.hpp>
 
 using namespace glm;
 using namespace std;
 using namespace Assimp;
+using namespace std::chrono;
 using namespace Engine;
+using namespace Engine::Jobs;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
@@ -22,16 +30,156 @@ namespace fs = std::filesystem;
 
 #define ENABLE_CACHING 1
 
-Model::Model() : m_Path(""), m_Root(), m_Meshes() { }
-Model::Model(string path) : m_Path(path), m_Root(), m_Meshes() { Load(); }
+// Levels of detail generated per mesh, each targeting half the triangles of the previous
+const unsigned int MaxLODs = 3;
+const unsigned int MinLODTriangles = 64;
+const float LODScreenSizes[MaxLODs] = { 0.5f, 0.25f, 0.125f };
+
+// Maximum simplification error per LOD, as a fraction of the mesh's bounds diagonal
+const float LODMaxErrors[MaxLODs] = { 0.01f, 0.02f, 0.04f };
+
+struct Model::AsyncLoad
+{
+	string Path;
+	JobHandle Job;
+
+	/// <summary>
+	/// Set after the cache failed to read, forcing a full import
+	/// </summary>
+	bool IgnoreCache = false;
+
+	// Set when imported from the model file, the scene is kept to create materials on the main thread
+	unique_ptr<Importer> SceneImporter;
+	const aiScene* Scene = nullptr;
+	vector<ImportedMesh> Meshes;
+	uint64_t SourceHash = 0;
+
+	// Set when read from the cache, meshes are uploaded straight from the mapped file
+	unique_ptr<ModelCache> Cache;
+};
+
+vector<Model*> Model::s_AsyncLoads = {};
+
+Model::Model() : m_Path(""), m_Root(), m_Meshes(), m_State(LoadState::Loaded) { }
+Model::Model(string path, bool async) : m_Path(path), m_Root(), m_Meshes(), m_State(LoadState::Loading)
+{
+	if (async)
+		BeginLoad();
+	else
+		Load();
+}
 
 Model::~Model()
+{
+	// Worker holds its own reference to any load in progress
+	s_AsyncLoads.erase(remove(s_AsyncLoads.begin(), s_AsyncLoads.end(), this), s_AsyncLoads.end());
+	m_AsyncLoad.reset();
+
+	for (ModelPlaceholder* placeholder : m_Placeholders)
+		placeholder->m_Model = nullptr;
+	m_Placeholders.clear();
+
+	UnloadMeshes();
+}
+
+ResourceID Model::LoadAsync(string path) { return ResourceManager::Load<Model>(path, true); }
+
+void Model::UnloadMeshes()
 {
 	for (ResourceID meshID : m_Meshes)
+	{
+		Mesh* mesh = ResourceManager::Get<Mesh>(meshID);
+		if (!mesh)
+			continue;
+
+		for (Mesh::LODLevel& lod : mesh->GetLODs())
+			ResourceManager::Unload(lod.Mesh);
 		ResourceManager::Unload(meshID);
+	}
 	m_Meshes.clear();
 }
 
+/// <summary>
+/// Loads a mesh into the shared mesh buffer when indirect drawing is supported
+/// </summary>
+ResourceID LoadModelMesh(vector<Mesh::Vertex>& vertices, vector<unsigned int>& indices)
+{
+	ResourceID meshID = ResourceManager::Load<Mesh>(vertices, indices);
+	if (Renderer::SupportsMultiDrawIndirect() && !indices.empty())
+		ResourceManager::Get<Mesh>(meshID)->SetShared();
+	return meshID;
+}
+
+/// <summary>
+/// Simplifies an optimised mesh into lower levels of detail, stored in mesh.LODs
+/// </summary>
+void GenerateLODs(Model::ImportedMesh& mesh)
+{
+	if (mesh.Vertices.empty())
+		return;
+
+	vec3 boundsMin = mesh.Vertices[0].Position, boundsMax = mesh.Vertices[0].Position;
+	for (Mesh::Vertex& vertex : mesh.Vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.Position);
+		boundsMax = glm::max(boundsMax, vertex.Position);
+	}
+	float extent = length(boundsMax - boundsMin);
+
+	vector<unsigned int> lodIndices = mesh.Indices;
+	for (unsigned int lod = 0; lod < MaxLODs; lod++)
+	{
+		unsigned int targetIndexCount = (unsigned int)(mesh.Indices.size() >> (lod + 1)) / 3 * 3;
+		if (targetIndexCount / 3 < MinLODTriangles)
+			break;
+
+		float maxError = extent * LODMaxErrors[lod];
+		size_t previousIndexCount = lodIndices.size();
+		lodIndices = MeshOptimiser::Simplify(mesh.Vertices, lodIndices, targetIndexCount, maxError * maxError);
+
+		// Simplification stalled, the previous level is as simple as the error limit allows
+		if (lodIndices.size() > previousIndexCount * 0.8f)
+			break;
+
+		// Each level only keeps the vertices it uses
+		Model::ImportedMesh lodMesh;
+		lodMesh.Vertices = mesh.Vertices;
+		lodMesh.Indices = lodIndices;
+		lodMesh.ScreenSize = LODScreenSizes[lod];
+		MeshOptimiser::OptimiseVertexCache(lodMesh.Indices, (unsigned int)lodMesh.Vertices.size());
+		MeshOptimiser::OptimiseVertexFetch(lodMesh.Vertices, lodMesh.Indices);
+
+		Log::Debug("Generated LOD " + to_string(lod + 1) + " with " + to_string(lodMesh.Indices.size() / 3) + " triangles");
+		mesh.LODs.emplace_back(std::move(lodMesh));
+	}
+}
+
+ResourceID Model::CreateMesh(ImportedMesh& imported)
+{
+	ResourceID meshID = LoadModelMesh(imported.Vertices, imported.Indices);
+	Mesh* mesh = ResourceManager::Get<Mesh>(meshID);
+	mesh->SetVertexFormat(imported.Format);
+	mesh->Upload();
+
+	for (ImportedMesh& lod : imported.LODs)
+		mesh->AddLOD(CreateMesh(lod), lod.ScreenSize);
+	return meshID;
+}
+
+/// <summary>
+/// Uploads a mesh & its levels of detail from the mapped cache
+/// </summary>
+ResourceID LoadCachedMesh(ModelCache& cache, unsigned int index)
+{
+	const ModelCache::MeshEntry& entry = cache.GetEntry(index);
+	ResourceID meshID = ResourceManager::Load<Mesh>(cache.GetPackedData(entry), Renderer::SupportsMultiDrawIndirect());
+
+	Mesh* mesh = ResourceManager::Get<Mesh>(meshID);
+	for (unsigned int i = entry.FirstLOD; i < entry.FirstLOD + entry.LODCount; i++)
+		mesh->AddLOD(LoadCachedMesh(cache, i), cache.GetEntry(i).ScreenSize);
+	return meshID;
+}
+
 void ApplyAssimpTransformation(aiMatrix4x4 transformation, Transform* transform)
 {
 	aiVector3D scale = {};
@@ -49,6 +197,18 @@ std::vector<ResourceID>& Model::GetMeshes() { return m_Meshes; }
 
 GameObject* Model::CreateEntity(GameObject* parent, vec3 position)
 {
+	if (parent && (m_State == LoadState::Loading || m_State == LoadState::Uploading))
+	{
+		// Filled in once loading finishes
+		GameObject* placeholder = new GameObject(parent, fs::path(m_Path).stem().string());
+		placeholder->GetTransform()->Position = position;
+
+		ModelPlaceholder* component = placeholder->AddComponent<ModelPlaceholder>();
+		component->m_Model = this;
+		m_Placeholders.emplace_back(component);
+		return placeholder;
+	}
+
 	if (!parent || (m_Root.MeshIDs.size() == 0 && m_Root.Children.size() == 0))
 		return nullptr; // Return invalid entity
 
@@ -91,45 +251,186 @@ void Model::CreateEntity(MeshData& mesh, GameObject* parent)
 }
 
 void Model::Load()
+{
+	BeginLoad();
+	Wait();
+}
+
+void Model::BeginLoad()
+{
+	m_State = LoadState::Loading;
+	m_AsyncLoad = make_shared<AsyncLoad>();
+	m_AsyncLoad->Path = m_Path;
+
+	shared_ptr<AsyncLoad> load = m_AsyncLoad;
+	m_AsyncLoad->Job = JobSystem::Submit([load]() { ImportModel(*load); });
+
+	s_AsyncLoads.emplace_back(this);
+}
+
+void Model::ImportModel(AsyncLoad& load)
 {
 #if ENABLE_CACHING
-	if (fs::exists(m_Path + ".cache"))
+	if (!load.IgnoreCache)
 	{
-		LoadFromCache();
-		return;
+		load.Cache = make_unique<ModelCache>();
+		if (load.Cache->Open(load.Path + ".cache", load.Path))
+			return;
+
+		if (fs::exists(load.Path + ".cache"))
+			Log::Warning("Model cache '" + load.Path + ".cache' is outdated or corrupt, re-importing");
+		load.Cache.reset();
 	}
 #endif
-	Log::Info("Loading model " + m_Path);
+	Log::Info("Loading model " + load.Path);
 
-	Importer importer;
-
-	const aiScene* scene = nullptr;
 	unsigned int postProcessing = aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
 
+	// Replaced by MeshOptimiser, which also reduces overdraw & reorders vertices
+	postProcessing &= ~aiProcess_ImproveCacheLocality;
+
 	// Read in model file
-	scene = importer.ReadFile(m_Path, postProcessing);
+	load.SceneImporter = make_unique<Importer>();
+	load.Scene = load.SceneImporter->ReadFile(load.Path, postProcessing);
 
 	// Safety check
-	if (!scene)
+	if (!load.Scene)
 	{
-		Log::Error("Failed to load model '" + m_Path + "' - " + string(importer.GetErrorString()));
+		Log::Error("Failed to load model '" + load.Path + "' - " + string(load.SceneImporter->GetErrorString()));
 		return;
 	}
 
-	// Read in meshes
-	m_Meshes.reserve(scene->mNumMeshes);
-	for (unsigned int i = 0; i < scene->mNumMeshes; i++)
-		m_Meshes.emplace_back(ProcessMesh(scene->mMeshes[i], scene));
+	// Optimisation & simplification dominate import time, process meshes in parallel
+	load.Meshes.resize(load.Scene->mNumMeshes);
+	JobSystem::ParallelFor(load.Scene->mNumMeshes, [&](unsigned int i)
+	{
+		load.Meshes[i] = ProcessMesh(load.Scene->mMeshes[i]);
+	});
+
+#if ENABLE_CACHING
+	load.SourceHash = MappedFile::HashFile(load.Path);
+#endif
+}
+
+bool Model::ContinueLoad(steady_clock::time_point deadline)
+{
+	AsyncLoad& load = *m_AsyncLoad;
+	if (!load.Job.IsComplete())
+		return false;
+
+	if (!load.Scene && !load.Cache)
+	{
+		FinishLoad(LoadState::Failed);
+		return true;
+	}
+
+	// Upload meshes, at least one per call so loading always progresses
+	m_State = LoadState::Uploading;
+	size_t meshCount = load.Cache ? load.Cache->GetMeshCount() : load.Meshes.size();
+	m_Meshes.reserve(meshCount);
+	while (m_Meshes.size() < meshCount)
+	{
+		unsigned int index = (unsigned int)m_Meshes.size();
+		m_Meshes.emplace_back(load.Cache ? LoadCachedMesh(*load.Cache, index) : CreateMesh(load.Meshes[index]));
+		if (steady_clock::now() >= deadline)
+			return false;
+	}
+
+	if (load.Cache)
+	{
+		try
+		{
+			DataStream hierarchy = load.Cache->GetHierarchy();
+			SerializeHierarchy(hierarchy);
+		}
+		catch (runtime_error&)
+		{
+			Log::Warning("Model cache '" + m_Path + ".cache' is outdated or corrupt, re-importing");
+
+			UnloadMeshes();
+			m_Root = {};
 
-	m_Root = {};
+			// Restart from the model file
+			m_State = LoadState::Loading;
+			load.IgnoreCache = true;
+			load.Cache.reset();
 
-	// Create mesh data hierarchy
-	ProcessNode(scene->mRootNode, nullptr, scene);
+			shared_ptr<AsyncLoad> asyncLoad = m_AsyncLoad;
+			load.Job = JobSystem::Submit([asyncLoad]() { ImportModel(*asyncLoad); });
+			return false;
+		}
+		Log::Debug("Loaded '" + m_Path + "' from cache");
+	}
+	else
+	{
+		// Create mesh data hierarchy
+		m_Root = {};
+		ProcessNode(load.Scene->mRootNode, nullptr, load.Scene);
 #if ENABLE_CACHING
-	SaveCache();
+		// Written on a worker, which keeps the imported meshes alive until done
+		shared_ptr<DataStream> hierarchy = make_shared<DataStream>();
+		SerializeHierarchy(*hierarchy);
+
+		shared_ptr<AsyncLoad> asyncLoad = m_AsyncLoad;
+		JobSystem::Submit([asyncLoad, hierarchy]()
+		{
+			if (ModelCache::Save(asyncLoad->Path + ".cache", asyncLoad->Path, asyncLoad->SourceHash, asyncLoad->Meshes, *hierarchy))
+				Log::Debug("Cached '" + asyncLoad->Path + "'");
+		});
 #endif
+	}
+
+	FinishLoad(LoadState::Loaded);
+	return true;
+}
+
+void Model::FinishLoad(LoadState state)
+{
+	m_State = state;
+	m_AsyncLoad.reset();
+	s_AsyncLoads.erase(remove(s_AsyncLoads.begin(), s_AsyncLoads.end(), this), s_AsyncLoads.end());
+
+	// Removing a placeholder also removes it from m_Placeholders
+	vector<ModelPlaceholder*> placeholders = m_Placeholders;
+	for (ModelPlaceholder* placeholder : placeholders)
+	{
+		GameObject* entity = placeholder->GetGameObject();
+		entity->RemoveComponent<ModelPlaceholder>();
+
+		if (state != LoadState::Loaded)
+			continue;
+
+		entity->SetName(m_Root.Name);
+		CreateEntity(m_Root, entity);
+	}
+}
+
+void Model::Wait()
+{
+	while (m_AsyncLoad)
+	{
+		m_AsyncLoad->Job.Wait();
+		ContinueLoad(steady_clock::time_point::max());
+	}
 }
 
+void Model::UpdateAsyncLoads(float timeBudget)
+{
+	steady_clock::time_point deadline = steady_clock::now() + duration_cast<steady_clock::duration>(duration<float, milli>(timeBudget));
+
+	// Finished loads remove themselves from s_AsyncLoads
+	vector<Model*> loads = s_AsyncLoads;
+	for (Model* model : loads)
+	{
+		model->ContinueLoad(deadline);
+		if (steady_clock::now() >= deadline)
+			break;
+	}
+}
+
+Model::LoadState Model::GetLoadState() { return m_State; }
+bool Model::IsLoaded() { return m_State == LoadState::Loaded; }
+
 void LoadMaterialTextures(
 	string currentDirectory,
 	aiTextureType textureType,
@@ -150,7 +451,11 @@ void LoadMaterialTextures(
 	string texturePath = currentDirectory + aiTexturePath.C_Str();
 	replace(texturePath.begin(), texturePath.end(), '\\', '/');
 
-	materialTexture = ResourceManager::LoadNamed<Texture>(aiTexturePath.C_Str(), texturePath);
+	// Normal maps are compressed to two channels, see TextureArgs::NormalMap
+	TextureArgs args;
+	args.NormalMap = textureType == aiTextureType_NORMALS || textureType == aiTextureType_HEIGHT;
+
+	materialTexture = ResourceManager::LoadNamed<Texture>(aiTexturePath.C_Str(), texturePath, args);
 }
 
 
@@ -200,10 +505,13 @@ void Model::ProcessNode(aiNode* node, MeshData* parent, const aiScene* scene)
 		m_Root = meshData;
 }
 
-ResourceID Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+Model::ImportedMesh Model::ProcessMesh(aiMesh* mesh)
 {
-	vector<Mesh::Vertex> vertices;
-	vector<unsigned int> indices;
+	ImportedMesh imported;
+	vector<Mesh::Vertex>& vertices = imported.Vertices;
+	vector<unsigned int>& indices = imported.Indices;
+	vertices.reserve(mesh->mNumVertices);
+	indices.reserve(mesh->mNumFaces * 3);
 
 	// Process vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -232,32 +540,33 @@ ResourceID Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
 			indices.emplace_back(mesh->mFaces[i].mIndices[j]);
 
-	return ResourceManager::Load<Mesh>(vertices, indices);
-}
-
-void Model::LoadFromCache()
-{
-	DataStream stream(Engine::Read(m_Path + ".cache"));
-	Serialize(stream);
-	Log::Debug("Loaded '" + m_Path + "' from cache");
-}
+	// Optimised once at import, result is stored in the model cache
+	if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+	{
+		MeshOptimiser::Stats stats = MeshOptimiser::Optimise(vertices, indices);
+		Log::Debug("Optimised mesh '" + string(mesh->mName.C_Str()) + "' (" + to_string(indices.size() / 3) + " triangles, " +
+			to_string(stats.ClusterCount) + " clusters) - ACMR " + to_string(stats.ACMRBefore) + " -> " + to_string(stats.ACMRAfter));
 
-void Model::SaveCache()
-{
-	DataStream stream;
-	Serialize(stream);
-	stream.SaveTo(m_Path + ".cache");
-	Log::Debug("Cached '" + m_Path + "'");
+		GenerateLODs(imported);
+	}
+	return imported;
 }
 
 void SerializeMeshData(DataStream& stream, Model::MeshData& mesh)
 {
 	stream.Serialize(&mesh.Name);
 
-	// Transform
-	for (int i = 0; i < 4; i++)
-		for (int j = 0; j < 4; j++)
-			stream.Serialize(&mesh.Transformation[i][j]);
+	// Transform, as a single blob rather than 16 individually tagged floats
+	if (stream.IsWriting())
+		stream.Write((unsigned char*)&mesh.Transformation, sizeof(aiMatrix4x4));
+	else
+	{
+		size_t length = 0;
+		unsigned char* transformation = stream.ReadArray<unsigned char*>(&length);
+		if (length != sizeof(aiMatrix4x4))
+			throw runtime_error("Model cache transformation size mismatch");
+		memcpy(&mesh.Transformation, transformation, sizeof(aiMatrix4x4));
+	}
 
 	// Mesh IDs
 	unsigned int meshIDCount = (unsigned int)mesh.MeshIDs.size();
@@ -284,52 +593,4 @@ void SerializeMeshData(DataStream& stream, Model::MeshData& mesh)
 		SerializeMeshData(stream, mesh.Children[i]);
 }
 
-void Model::Serialize(DataStream& stream)
-{
-	stream.Serialize(&m_Path);
-
-	unsigned int meshCount = (unsigned int)m_Meshes.size();
-	stream.Serialize(&meshCount);
-	if (stream.IsReading())
-		m_Meshes.resize(meshCount);
-
-	for (unsigned int i = 0; i < meshCount; i++)
-	{
-		Mesh* mesh = nullptr;
-		if (stream.IsWriting())
-			mesh = ResourceManager::Get<Mesh>(m_Meshes[i]);
-
-		vector<Mesh::Vertex> vertices = mesh ? mesh->GetVertices() : vector<Mesh::Vertex>();
-		vector<unsigned int> indices = mesh ? mesh->GetIndices() : vector<unsigned int>();
-
-		unsigned int vertexCount = (unsigned int)vertices.size();
-		unsigned int indexCount = (unsigned int)indices.size();
-
-		stream.Serialize(&vertexCount);
-		if (stream.IsReading())
-			vertices.resize(vertexCount);
-		else
-			stream.Reserve(vertexCount * sizeof(Mesh::Vertex));
-
-		for (unsigned int v = 0; v < vertexCount; v++)
-		{
-			stream.Serialize(&vertices[v].Position);
-			stream.Serialize(&vertices[v].Normal);
-			stream.Serialize(&vertices[v].TexCoords);
-			stream.Serialize(&vertices[v].Tangent);
-			stream.Serialize(&vertices[v].Bitangent);
-		}
-
-		stream.Serialize(&indexCount);
-		if (stream.IsReading())
-			indices.resize(indexCount);
-
-		for (unsigned int j = 0; j < indexCount; j++)
-			stream.Serialize(&indices[j]);
-
-		if (stream.IsReading())
-			m_Meshes[i] = ResourceManager::Load<Mesh>(vertices, indices);
-	}
-
-	SerializeMeshData(stream, m_Root);
-}
\ No newline at end of file
+void Model::SerializeHierarchy(DataStream& stream) { SerializeMeshData(stream, m_Root); }
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include <fstream>
+#include <filesystem>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/ModelCache.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+namespace fs = std::filesystem;
+
+// "MDLC" when read as bytes
+const uint32_t CacheMagic = 0x434C444D;
+
+// Vertex & index data alignment within the file
+const uint64_t DataAlignment = 16;
+
+uint64_t Align(uint64_t offset) { return (offset + DataAlignment - 1) & ~(DataAlignment - 1); }
+
+ModelCache::ModelCache() : m_File(), m_Header(nullptr), m_Entries(nullptr) { }
+
+bool ModelCache::Open(string cachePath, string sourcePath)
+{
+	Close();
+	if (!m_File.Open(cachePath))
+		return false;
+
+	if (!Validate(sourcePath))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool ModelCache::Validate(string& sourcePath)
+{
+	size_t fileSize = m_File.GetSize();
+	const unsigned char* data = m_File.GetData();
+	if (fileSize < sizeof(Header))
+		return false;
+
+	m_Header = (const Header*)data;
+	if (m_Header->Magic != CacheMagic || m_Header->Version != Version)
+		return false;
+
+	uint64_t sourceSize = 0;
+	int64_t sourceWriteTime = 0;
+	if (MappedFile::GetFileInfo(sourcePath, sourceSize, sourceWriteTime) &&
+		(sourceSize != m_Header->SourceSize || sourceWriteTime != m_Header->SourceWriteTime))
+	{
+		// Source was touched, only outdated if the contents changed
+		if (sourceSize != m_Header->SourceSize || MappedFile::HashFile(sourcePath) != m_Header->SourceHash)
+			return false;
+	}
+
+	// Bounds checks, guards against truncated files
+	uint64_t tableEnd = sizeof(Header) + (uint64_t)m_Header->EntryCount * sizeof(MeshEntry);
+	if (m_Header->MeshCount > m_Header->EntryCount || tableEnd > fileSize)
+		return false;
+	m_Entries = (const MeshEntry*)(data + sizeof(Header));
+
+	for (uint32_t i = 0; i < m_Header->EntryCount; i++)
+	{
+		const MeshEntry& entry = m_Entries[i];
+		if (entry.Format > (uint32_t)Mesh::VertexFormat::CompactHalfPosition ||
+			entry.VertexOffset + (uint64_t)entry.VertexCount * Mesh::GetVertexSize((Mesh::VertexFormat)entry.Format) > fileSize ||
+			entry.IndexOffset + (uint64_t)entry.IndexCount * sizeof(unsigned int) > fileSize ||
+			(uint64_t)entry.FirstLOD + entry.LODCount > m_Header->EntryCount)
+			return false;
+
+		// LODs are loaded recursively, only pointing forward guarantees this terminates
+		if (entry.LODCount > 0 && entry.FirstLOD <= i)
+			return false;
+
+		// Out of range indices would read past the vertex data on the GPU
+		const unsigned int* indices = (const unsigned int*)(data + entry.IndexOffset);
+		for (uint32_t j = 0; j < entry.IndexCount; j++)
+			if (indices[j] >= entry.VertexCount)
+				return false;
+	}
+
+	return m_Header->HierarchyOffset + m_Header->HierarchySize <= fileSize && m_Header->HierarchySize > 0;
+}
+
+void ModelCache::Close()
+{
+	m_File.Close();
+	m_Header = nullptr;
+	m_Entries = nullptr;
+}
+
+unsigned int ModelCache::GetMeshCount() const { return m_Header ? m_Header->MeshCount : 0; }
+const ModelCache::MeshEntry& ModelCache::GetEntry(unsigned int index) const { return m_Entries[index]; }
+
+Mesh::PackedData ModelCache::GetPackedData(const MeshEntry& entry) const
+{
+	Mesh::PackedData data;
+	data.Vertices = m_File.GetData() + entry.VertexOffset;
+	data.VertexCount = entry.VertexCount;
+	data.Indices = (const unsigned int*)(m_File.GetData() + entry.IndexOffset);
+	data.IndexCount = entry.IndexCount;
+	data.Format = (Mesh::VertexFormat)entry.Format;
+	data.BoundsMin = vec3(entry.BoundsMin[0], entry.BoundsMin[1], entry.BoundsMin[2]);
+	data.BoundsMax = vec3(entry.BoundsMax[0], entry.BoundsMax[1], entry.BoundsMax[2]);
+	return data;
+}
+
+DataStream ModelCache::GetHierarchy() const
+{
+	if (!m_Header)
+		return DataStream::Empty();
+	return DataStream((unsigned char*)m_File.GetData() + m_Header->HierarchyOffset, (size_t)m_Header->HierarchySize);
+}
+
+bool ModelCache::Save(string cachePath, string sourcePath, uint64_t sourceHash, vector<Model::ImportedMesh>& meshes, DataStream& hierarchy)
+{
+	// Flatten meshes & levels of detail into a table, each mesh's levels of detail are contiguous
+	vector<Model::ImportedMesh*> order;
+	for (Model::ImportedMesh& mesh : meshes)
+		order.emplace_back(&mesh);
+
+	vector<MeshEntry> entries;
+	vector<vector<unsigned char>> vertexData;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		Model::ImportedMesh& mesh = *order[i];
+
+		MeshEntry entry = {};
+		entry.VertexCount = (uint32_t)mesh.Vertices.size();
+		entry.IndexCount = (uint32_t)mesh.Indices.size();
+		entry.Format = (uint32_t)mesh.Format;
+		entry.ScreenSize = mesh.ScreenSize;
+		entry.FirstLOD = (uint32_t)order.size();
+		entry.LODCount = (uint32_t)mesh.LODs.size();
+		for (Model::ImportedMesh& lod : mesh.LODs)
+			order.emplace_back(&lod);
+
+		vec3 boundsMin(0.0f), boundsMax(0.0f);
+		if (!mesh.Vertices.empty())
+			boundsMin = boundsMax = mesh.Vertices[0].Position;
+		for (Mesh::Vertex& vertex : mesh.Vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.Position);
+			boundsMax = glm::max(boundsMax, vertex.Position);
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			entry.BoundsMin[axis] = boundsMin[axis];
+			entry.BoundsMax[axis] = boundsMax[axis];
+		}
+
+		entries.emplace_back(entry);
+		vertexData.emplace_back(Mesh::PackVertices(mesh.Vertices, mesh.Format));
+	}
+
+	// Assign data offsets once the table size is known
+	uint64_t offset = sizeof(Header) + entries.size() * sizeof(MeshEntry);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		entries[i].VertexOffset = offset = Align(offset);
+		offset += vertexData[i].size();
+
+		entries[i].IndexOffset = offset = Align(offset);
+		offset += (uint64_t)entries[i].IndexCount * sizeof(unsigned int);
+	}
+
+	Header header = {};
+	header.Magic = CacheMagic;
+	header.Version = Version;
+	header.SourceHash = sourceHash;
+	header.MeshCount = (uint32_t)meshes.size();
+	header.EntryCount = (uint32_t)entries.size();
+	header.HierarchyOffset = Align(offset);
+	header.HierarchySize = hierarchy.GetLength();
+	MappedFile::GetFileInfo(sourcePath, header.SourceSize, header.SourceWriteTime);
+
+	// Written beside the cache & renamed, so a partially written cache is never read
+	string tempPath = cachePath + ".tmp";
+	{
+		ofstream file(tempPath, ios::out | ios::binary | ios::trunc);
+		if (!file)
+		{
+			Log::Warning("Failed to write model cache '" + cachePath + "'");
+			return false;
+		}
+
+		const char padding[DataAlignment] = {};
+		auto pad = [&]()
+		{
+			uint64_t position = (uint64_t)file.tellp();
+			file.write(padding, Align(position) - position);
+		};
+
+		file.write((const char*)&header, sizeof(Header));
+		file.write((const char*)entries.data(), entries.size() * sizeof(MeshEntry));
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			pad();
+			file.write((const char*)vertexData[i].data(), vertexData[i].size());
+			pad();
+			file.write((const char*)order[i]->Indices.data(), order[i]->Indices.size() * sizeof(unsigned int));
+		}
+		pad();
+
+		vector<unsigned char> hierarchyData = hierarchy.GetData();
+		file.write((const char*)hierarchyData.data(), header.HierarchySize);
+
+		if (!file)
+		{
+			Log::Warning("Failed to write model cache '" + cachePath + "'");
+			return false;
+		}
+	}
+
+	error_code error;
+	fs::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		Log::Warning("Failed to write model cache '" + cachePath + "' - " + error.message());
+		fs::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
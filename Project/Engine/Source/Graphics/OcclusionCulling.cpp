@@ -0,0 +1,350 @@
+#include <limits>
+#include <cstring>
+#include <Engine/Log.hpp>
+#include <Engine/Application.hpp>
+#include <Engine/Graphics/Mesh.hpp>
+#include <Engine/ResourceManager.hpp>
+#include <Engine/Graphics/Shader.hpp>
+#include <Engine/Graphics/Renderer.hpp>
+#include <Engine/Graphics/RenderTexture.hpp>
+#include <Engine/Graphics/OcclusionCulling.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+using namespace Engine::Components;
+
+constexpr UniformHandle InputDepthUniform("inputDepth");
+constexpr UniformHandle InputSizeUniform("inputSize");
+constexpr UniformHandle OutputSizeUniform("outputSize");
+constexpr UniformHandle PyramidUniform("pyramid");
+constexpr UniformHandle PyramidSizeUniform("pyramidSize");
+constexpr UniformHandle LevelCountUniform("levelCount");
+constexpr UniformHandle ViewProjectionUniform("viewProjection");
+constexpr UniformHandle CommandCountUniform("commandCount");
+
+// Largest level read back to the CPU, small enough to copy & test against every frame
+const int ReadbackMaxResolution = 128;
+
+// Must match local_size_x in OcclusionCulling.comp
+const unsigned int CullingGroupSize = 64;
+
+OcclusionCulling::OcclusionCulling() :
+	m_Enabled(false),
+	m_ComputeCulling(false),
+	m_DownsampleShader(InvalidResourceID),
+	m_CullingShader(InvalidResourceID),
+	m_Pyramid(GL_INVALID_VALUE),
+	m_Framebuffer(GL_INVALID_VALUE),
+	m_BoundsBuffer(GL_INVALID_VALUE),
+	m_BoundsCapacity(0),
+	m_Size(0),
+	m_LevelCount(0),
+	m_Camera(nullptr),
+	m_ViewProjection(1.0f),
+	m_ReadbackIndex(0),
+	m_ReadbackLevel(0),
+	m_DepthsSize(0),
+	m_DepthsViewProjection(1.0f),
+	m_DepthsCamera(nullptr)
+{
+	m_DownsampleShader = ResourceManager::LoadNamed<Shader>("Shaders/HiZDownsample",
+		ShaderStageInfo
+		{
+			Application::AssetDir + "Shaders/TextureQuad.vert",
+			Application::AssetDir + "Shaders/Misc/HiZDownsample.frag"
+		});
+
+	if (Renderer::SupportsCompute())
+		m_CullingShader = ResourceManager::LoadNamed<Shader>("Shaders/OcclusionCulling",
+			ShaderStageInfo
+			{
+				"", // Vertex
+				"", // Fragment
+				Application::AssetDir + "Shaders/Misc/OcclusionCulling.comp"
+			});
+}
+
+OcclusionCulling::~OcclusionCulling()
+{
+	Destroy();
+
+	if (m_BoundsBuffer != GL_INVALID_VALUE)
+		glDeleteBuffers(1, &m_BoundsBuffer);
+}
+
+bool OcclusionCulling::GetEnabled() { return m_Enabled; }
+void OcclusionCulling::SetEnabled(bool enable) { m_Enabled = enable; }
+
+bool OcclusionCulling::GetComputeCulling() { return m_ComputeCulling && Renderer::SupportsCompute(); }
+void OcclusionCulling::SetComputeCulling(bool enable) { m_ComputeCulling = enable; }
+
+ivec2 OcclusionCulling::GetLevelSize(unsigned int level) { return glm::max(ivec2(m_Size.x >> level, m_Size.y >> level), ivec2(1)); }
+
+void OcclusionCulling::Create(ivec2 size)
+{
+	m_Size = size;
+	m_LevelCount = 1;
+	while (GetLevelSize(m_LevelCount - 1) != ivec2(1))
+		m_LevelCount++;
+
+	glGenTextures(1, &m_Pyramid);
+	glBindTexture(GL_TEXTURE_2D, m_Pyramid);
+	for (unsigned int level = 0; level < m_LevelCount; level++)
+	{
+		ivec2 levelSize = GetLevelSize(level);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, levelSize.x, levelSize.y, 0, GL_RED, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &m_Framebuffer);
+
+	// First level small enough to read back
+	m_ReadbackLevel = 0;
+	while (m_ReadbackLevel < m_LevelCount - 1 &&
+		(GetLevelSize(m_ReadbackLevel).x > ReadbackMaxResolution || GetLevelSize(m_ReadbackLevel).y > ReadbackMaxResolution))
+		m_ReadbackLevel++;
+
+	ivec2 readbackSize = GetLevelSize(m_ReadbackLevel);
+	for (Readback& readback : m_Readbacks)
+	{
+		glGenBuffers(1, &readback.Buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.Buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, readbackSize.x * readbackSize.y * sizeof(float), nullptr, GL_STREAM_READ);
+		readback.Size = readbackSize;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	Log::Debug("Created Hi-Z pyramid [" + to_string(m_Size.x) + "x" + to_string(m_Size.y) + "][" + to_string(m_LevelCount) + " levels]");
+}
+
+void OcclusionCulling::Destroy()
+{
+	if (m_Pyramid == GL_INVALID_VALUE)
+		return; // Not created
+
+	glDeleteTextures(1, &m_Pyramid);
+	glDeleteFramebuffers(1, &m_Framebuffer);
+	m_Pyramid = m_Framebuffer = GL_INVALID_VALUE;
+
+	for (Readback& readback : m_Readbacks)
+	{
+		if (readback.Fence)
+			glDeleteSync(readback.Fence);
+		glDeleteBuffers(1, &readback.Buffer);
+		readback = Readback();
+	}
+
+	m_Camera = m_DepthsCamera = nullptr;
+	m_Depths.clear();
+}
+
+void OcclusionCulling::Build(RenderTexture* depth, Camera& camera)
+{
+	Shader* shader = ResourceManager::Get<Shader>(m_DownsampleShader);
+	if (!m_Enabled || !depth || !shader)
+		return;
+
+	// Largest power of two that fits in half the depth resolution
+	ivec2 depthSize = depth->GetResolution();
+	ivec2 size(1);
+	while (size.x * 2 <= depthSize.x / 2) size.x *= 2;
+	while (size.y * 2 <= depthSize.y / 2) size.y *= 2;
+	if (size != m_Size)
+	{
+		Destroy();
+		Create(size);
+	}
+
+	// Take the most recent finished readback, older first so a newer result overwrites it
+	ResolveReadback(m_Readbacks[m_ReadbackIndex]);
+	ResolveReadback(m_Readbacks[(m_ReadbackIndex + 1) % 2]);
+
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	glDisable(GL_DEPTH_TEST);
+
+	Mesh* quad = ResourceManager::Get<Mesh>(Mesh::Quad());
+	shader->Bind();
+	shader->Set(InputDepthUniform, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	for (unsigned int level = 0; level < m_LevelCount; level++)
+	{
+		ivec2 inputSize = depthSize;
+		if (level == 0)
+			depth->Bind(0);
+		else
+		{
+			// Limit sampling to the previous level, which is not the one being drawn to
+			inputSize = GetLevelSize(level - 1);
+			glBindTexture(GL_TEXTURE_2D, m_Pyramid);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+		}
+
+		ivec2 outputSize = GetLevelSize(level);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Pyramid, level);
+		glViewport(0, 0, outputSize.x, outputSize.y);
+
+		shader->Set(InputSizeUniform, vec2(inputSize));
+		shader->Set(OutputSizeUniform, vec2(outputSize));
+		quad->Draw();
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	shader->Unbind();
+
+	glBindTexture(GL_TEXTURE_2D, m_Pyramid);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (depthTest)
+		glEnable(GL_DEPTH_TEST);
+
+	m_Camera = &camera;
+	m_ViewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+	if (!GetComputeCulling())
+		QueueReadback();
+}
+
+void OcclusionCulling::QueueReadback()
+{
+	Readback& readback = m_Readbacks[m_ReadbackIndex];
+	m_ReadbackIndex = (m_ReadbackIndex + 1) % 2;
+
+	// An unresolved readback is replaced by newer contents
+	if (readback.Fence)
+		glDeleteSync(readback.Fence);
+
+	// Copied into the pixel pack buffer asynchronously, mapped once the fence signals
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.Buffer);
+	glBindTexture(GL_TEXTURE_2D, m_Pyramid);
+	glGetTexImage(GL_TEXTURE_2D, m_ReadbackLevel, GL_RED, GL_FLOAT, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.ViewProjection = m_ViewProjection;
+	readback.Camera = m_Camera;
+}
+
+void OcclusionCulling::ResolveReadback(Readback& readback)
+{
+	if (!readback.Fence)
+		return;
+
+	GLenum status = glClientWaitSync(readback.Fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return; // Not finished, don't wait for it
+
+	glDeleteSync(readback.Fence);
+	readback.Fence = nullptr;
+
+	size_t size = (size_t)readback.Size.x * readback.Size.y;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.Buffer);
+	void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size * sizeof(float), GL_MAP_READ_BIT);
+	if (data)
+	{
+		m_Depths.resize(size);
+		memcpy(m_Depths.data(), data, size * sizeof(float));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+		m_DepthsSize = readback.Size;
+		m_DepthsViewProjection = readback.ViewProjection;
+		m_DepthsCamera = readback.Camera;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool OcclusionCulling::IsReady(Camera* camera)
+{
+	if (!m_Enabled || !camera)
+		return false;
+	if (GetComputeCulling())
+		return m_Camera == camera && m_CullingShader != InvalidResourceID;
+	return m_DepthsCamera == camera && !m_Depths.empty();
+}
+
+bool OcclusionCulling::IsVisible(vec3 boundsMin, vec3 boundsMax)
+{
+	if (m_Depths.empty())
+		return true;
+
+	vec3 ndcMin(numeric_limits<float>::max());
+	vec3 ndcMax(-numeric_limits<float>::max());
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		vec3 corner = mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+		vec4 clip = m_DepthsViewProjection * vec4(corner, 1.0f);
+		if (clip.w <= 0.0f)
+			return true; // Crosses the camera plane
+
+		vec3 ndc = vec3(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	// Parts outside of the previous view have no depth to be hidden behind
+	if (ndcMin.x < -1.0f || ndcMin.y < -1.0f || ndcMax.x > 1.0f || ndcMax.y > 1.0f)
+		return true;
+
+	ivec2 first = ivec2((vec2(ndcMin) * 0.5f + 0.5f) * vec2(m_DepthsSize));
+	ivec2 last = glm::min(ivec2((vec2(ndcMax) * 0.5f + 0.5f) * vec2(m_DepthsSize)), m_DepthsSize - 1);
+	float nearest = ndcMin.z * 0.5f + 0.5f;
+
+	// Visible if any covered texel is farther than the nearest point of the bounds
+	for (int y = first.y; y <= last.y; y++)
+		for (int x = first.x; x <= last.x; x++)
+			if (m_Depths[y * m_DepthsSize.x + x] >= nearest)
+				return true;
+	return false;
+}
+
+void OcclusionCulling::Cull(vector<vec4>& bounds, unsigned int commandBuffer, unsigned int commandCount)
+{
+	Shader* shader = ResourceManager::Get<Shader>(m_CullingShader);
+	if (!shader || commandCount == 0)
+		return;
+
+	unsigned int size = (unsigned int)(bounds.size() * sizeof(vec4));
+	if (m_BoundsBuffer == GL_INVALID_VALUE)
+		glGenBuffers(1, &m_BoundsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BoundsBuffer);
+	if (size > m_BoundsCapacity)
+	{
+		m_BoundsCapacity = glm::max(size, m_BoundsCapacity * 2);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_BoundsCapacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, bounds.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	shader->Bind();
+	shader->Set(ViewProjectionUniform, m_ViewProjection);
+	shader->Set(PyramidSizeUniform, vec2(m_Size));
+	shader->Set(LevelCountUniform, (int)m_LevelCount);
+	shader->Set(CommandCountUniform, (int)commandCount);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_Pyramid);
+	shader->Set(PyramidUniform, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_BoundsBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+
+	glDispatchCompute((commandCount + CullingGroupSize - 1) / CullingGroupSize, 1, 1);
+
+	// Instance counts are read when drawing indirectly
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	shader->Unbind();
+}
\ No newline at end of file
@@ -6,9 +6,23 @@
 #include <Engine/Graphics/Passes/PostProcessing.hpp>
 
 using namespace std;
+using namespace glm;
 using namespace Engine;
 using namespace Engine::Graphics;
 
+constexpr UniformHandle InputTextureUniform("inputTexture");
+constexpr UniformHandle InputTextureMSUniform("inputTextureMS");
+constexpr UniformHandle SamplesUniform("samples");
+constexpr UniformHandle GammaUniform("gamma");
+constexpr UniformHandle ExposureUniform("exposure");
+constexpr UniformHandle TonemapperUniform("tonemapper");
+constexpr UniformHandle TexelSizeUniform("texelSize");
+constexpr UniformHandle FirstLevelUniform("firstLevel");
+constexpr UniformHandle ThresholdUniform("threshold");
+constexpr UniformHandle RadiusUniform("radius");
+constexpr UniformHandle BloomTextureUniform("bloomTexture");
+constexpr UniformHandle IntensityUniform("intensity");
+
 const string FullscreenVertexShader = "Shaders/TextureQuad.vert";
 
 #pragma region Fullscreen Effect Pass
@@ -16,10 +30,9 @@ FullscreenEffectPass::FullscreenEffectPass(std::string fragmentShaderPath)
 {
 	m_Pass.Name = "Fullscreen Effect";
 
-	FramebufferSpec specs;
-	specs.Resolution = Renderer::GetResolution();
-	specs.Attachments = { { TextureFormat::RGBA16F, TexturePixelType::Float } };
-	m_Pass.Pass = new Framebuffer(specs);
+	// Each effect draws to its own render graph texture, which may share memory with textures no longer in use
+	static unsigned int effectCount = 0;
+	m_Pass.Writes = { { "FullscreenEffect" + to_string(effectCount++), TextureFormat::RGBA16F, TexturePixelType::Float } };
 
 	m_Pass.Shader = ResourceManager::LoadNamed<Shader>("Shaders/Fullscreen/" + fragmentShaderPath,
 		ShaderStageInfo
@@ -32,11 +45,7 @@ FullscreenEffectPass::FullscreenEffectPass(std::string fragmentShaderPath)
 	m_Shader = ResourceManager::Get<Shader>(m_Pass.Shader);
 }
 
-FullscreenEffectPass::~FullscreenEffectPass()
-{
-	delete m_Pass.Pass;
-	ResourceManager::Unload(m_Pass.Shader);
-}
+FullscreenEffectPass::~FullscreenEffectPass() { ResourceManager::Unload(m_Pass.Shader); }
 
 void FullscreenEffectPass::DrawCallback(Framebuffer* previous)
 {
@@ -46,9 +55,9 @@ void FullscreenEffectPass::DrawCallback(Framebuffer* previous)
 	previous->GetColourAttachment()->Bind();
 	if (m_Shader)
 	{
-		m_Shader->Set("inputTexture", 0);
-		m_Shader->Set("inputTextureMS", 0);
-		m_Shader->Set("samples", (int)previous->GetSamples());
+		m_Shader->Set(InputTextureUniform, 0);
+		m_Shader->Set(InputTextureMSUniform, 0);
+		m_Shader->Set(SamplesUniform, (int)previous->GetSamples());
 	}
 	OnDraw(m_Shader);
 
@@ -59,6 +68,126 @@ void FullscreenEffectPass::DrawCallback(Framebuffer* previous)
 RenderPipelinePass& FullscreenEffectPass::GetPipelinePass() { return m_Pass; }
 #pragma endregion
 
+#pragma region Bloom Pass
+const string BloomShader = "Shaders/PostProcessing/Bloom.frag";
+const string BloomDownsampleShader = "Shaders/PostProcessing/BloomDownsample.frag";
+const string BloomUpsampleShader = "Shaders/PostProcessing/BloomUpsample.frag";
+
+// Levels are not made smaller than this, a few texels is already a full screen blur
+const int BloomMinResolution = 4;
+
+BloomPass::BloomPass() : FullscreenEffectPass(BloomShader)
+{
+	GetPipelinePass().Name = "Bloom";
+
+	m_DownsampleShader = ResourceManager::LoadNamed<Shader>("Shaders/Fullscreen/" + BloomDownsampleShader,
+		ShaderStageInfo
+		{
+			Application::AssetDir + FullscreenVertexShader,
+			Application::AssetDir + BloomDownsampleShader
+		});
+	m_UpsampleShader = ResourceManager::LoadNamed<Shader>("Shaders/Fullscreen/" + BloomUpsampleShader,
+		ShaderStageInfo
+		{
+			Application::AssetDir + FullscreenVertexShader,
+			Application::AssetDir + BloomUpsampleShader
+		});
+}
+
+BloomPass::~BloomPass()
+{
+	for (Framebuffer* level : m_Levels)
+		delete level;
+
+	ResourceManager::Unload(m_DownsampleShader);
+	ResourceManager::Unload(m_UpsampleShader);
+}
+
+void BloomPass::CreateLevels(ivec2 inputResolution)
+{
+	if (inputResolution == m_Resolution)
+		return;
+	m_Resolution = inputResolution;
+
+	for (Framebuffer* level : m_Levels)
+		delete level;
+	m_Levels.clear();
+
+	FramebufferSpec specs;
+	specs.Attachments = { { TextureFormat::RGBA16F, TexturePixelType::Float } };
+	specs.Attachments[0].Wrap = GL_CLAMP_TO_EDGE; // Samples outside of the edge would wrap light to the other side
+
+	ivec2 resolution = inputResolution / 2;
+	while (m_Levels.size() < MaxLevels && resolution.x >= BloomMinResolution && resolution.y >= BloomMinResolution)
+	{
+		specs.Resolution = resolution;
+		m_Levels.emplace_back(new Framebuffer(specs));
+		resolution /= 2;
+	}
+}
+
+void BloomPass::OnDraw(Shader* shader)
+{
+	Framebuffer* previous = Renderer::GetPipeline()->GetPreviousPass();
+	if (!shader || !previous)
+		return;
+
+	RenderTexture* input = previous->GetColourAttachment();
+	CreateLevels(input->GetResolution());
+	if (m_Levels.empty())
+	{
+		// Too small for bloom, pass input through unchanged
+		shader->Set(IntensityUniform, 0.0f);
+		return;
+	}
+
+	Mesh* quad = ResourceManager::Get<Mesh>(Mesh::Quad());
+
+	// Downsample, first level removes light below threshold
+	Shader* downsample = ResourceManager::Get<Shader>(m_DownsampleShader);
+	downsample->Bind();
+	downsample->Set(InputTextureUniform, 0);
+	downsample->Set(ThresholdUniform, Threshold);
+	for (unsigned int i = 0; i < (unsigned int)m_Levels.size(); i++)
+	{
+		RenderTexture* source = i == 0 ? input : m_Levels[i - 1]->GetColourAttachment();
+		source->Bind(0);
+
+		m_Levels[i]->Bind();
+		downsample->Set(TexelSizeUniform, 1.0f / vec2(source->GetResolution()));
+		downsample->Set(FirstLevelUniform, i == 0);
+		quad->Draw();
+	}
+
+	// Upsample, each level is blurred & added to the next larger level
+	Shader* upsample = ResourceManager::Get<Shader>(m_UpsampleShader);
+	upsample->Bind();
+	upsample->Set(InputTextureUniform, 0);
+	upsample->Set(RadiusUniform, Radius);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	for (int i = (int)m_Levels.size() - 1; i > 0; i--)
+	{
+		RenderTexture* source = m_Levels[i]->GetColourAttachment();
+		source->Bind(0);
+
+		m_Levels[i - 1]->Bind();
+		upsample->Set(TexelSizeUniform, 1.0f / vec2(source->GetResolution()));
+		quad->Draw();
+	}
+	glDisable(GL_BLEND);
+
+	// Composite into this pass' output
+	Renderer::GetPipeline()->GetCurrentPass()->Bind();
+	shader->Bind();
+	input->Bind(0);
+	m_Levels[0]->GetColourAttachment()->Bind(1);
+	shader->Set(BloomTextureUniform, 1);
+	shader->Set(IntensityUniform, Intensity);
+}
+#pragma endregion
+
 #pragma region Tonemapping Pass
 const string TonemappingShader = "Shaders/PostProcessing/Tonemapping.frag";
 TonemappingPass::TonemappingPass() : FullscreenEffectPass(TonemappingShader)
@@ -71,8 +200,8 @@ void TonemappingPass::OnDraw(Shader* shader)
 	if (!shader)
 		return;
 
-	shader->Set("gamma", Gamma);
-	shader->Set("exposure", Exposure);
-	shader->Set("tonemapper", (int)Tonemapper);
+	shader->Set(GammaUniform, Gamma);
+	shader->Set(ExposureUniform, Exposure);
+	shader->Set(TonemapperUniform, (int)Tonemapper);
 }
 #pragma endregion
@@ -1,24 +1,44 @@
 #include <Engine/Application.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
 #include <Engine/ResourceManager.hpp>
 #include <Engine/Components/Light.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
 #include <Engine/Services/SceneService.hpp>
+#include <Engine/Graphics/ShadowAtlas.hpp>
 #include <Engine/Graphics/Passes/ShadowMap.hpp>
 #include <Engine/Components/Graphics/MeshRenderer.hpp>
 
 using namespace std;
 using namespace glm;
 using namespace Engine;
+using namespace Engine::Jobs;
 using namespace Engine::Graphics;
 using namespace Engine::Services;
 using namespace Engine::Components;
 
-ShadowMapPass::ShadowMapPass(ivec2 resolution) : m_ShadowCasters()
+constexpr UniformHandle ModelMatrixUniform("modelMatrix");
+constexpr UniformHandle LightSpaceMatrixUniform("lightSpaceMatrix");
+
+// Depth16 texels, for both the output & static caster atlases
+const unsigned int AtlasBytesPerTexel = 2 * 2;
+
+// Largest power of two atlas size fitting inside of budget
+unsigned int GetAtlasSizeForBudget(unsigned int megabytes)
+{
+	unsigned long long budget = megabytes * 1024ull * 1024ull;
+	unsigned int size = 256;
+	while ((unsigned long long)size * 2 * size * 2 * AtlasBytesPerTexel <= budget)
+		size *= 2;
+	return size;
+}
+
+ShadowMapPass::ShadowMapPass(ivec2 resolution, unsigned int memoryBudget) : m_Resolution(resolution),
+	m_Atlas(GetAtlasSizeForBudget(memoryBudget)), m_MemoryBudget(memoryBudget), m_ShadowCasters()
 {
 	FramebufferSpec specs;
-	specs.Resolution = m_Resolution = resolution;
+	specs.Resolution = { m_Atlas.GetSize(), m_Atlas.GetSize() };
 	specs.Attachments =
 	{
 		{
@@ -26,19 +46,18 @@ ShadowMapPass::ShadowMapPass(ivec2 resolution) : m_ShadowCasters()
 			TexturePixelType::Float  // Data Type
 		}
 	};
-	specs.Attachments[0].DepthInfo.Force3D = true;
 	m_Pass.Pass = new Framebuffer(specs);
 	m_Pass.ResizeWithScreen = false;
 
+	m_StaticPass = new Framebuffer(specs);
+
 	m_Pass.Name = "Shadow Mapping";
 
 	m_Pass.Shader = ResourceManager::LoadNamed<Shader>("Shaders/ShadowMap",
 		ShaderStageInfo
 		{
 			Application::AssetDir + "Shaders/Misc/ShadowMap/ShadowMap.vert",
-			Application::AssetDir + "Shaders/Misc/ShadowMap/ShadowMap.frag",
-			"", // Compute
-			Application::AssetDir + "Shaders/Misc/ShadowMap/ShadowMap.geo" // Geometry shader
+			Application::AssetDir + "Shaders/Misc/ShadowMap/ShadowMap.frag"
 		});
 	m_Pass.DrawCallback = bind(&ShadowMapPass::DrawCallback, this, ::placeholders::_1);
 }
@@ -48,114 +67,377 @@ ShadowMapPass::~ShadowMapPass()
 	Renderer::GetPipeline()->RemovePass(m_Pass.Pass);
 	if (m_Pass.Pass)
 		delete m_Pass.Pass;
+	delete m_StaticPass;
 }
 
 void ShadowMapPass::SetResolution(ivec2 resolution)
 {
+	// Tiles are reallocated next frame
 	m_Resolution = resolution;
+}
+
+unsigned int ShadowMapPass::GetMemoryBudget() { return m_MemoryBudget; }
+unsigned int ShadowMapPass::GetAtlasSize() { return m_Atlas.GetSize(); }
+
+void ShadowMapPass::SetMemoryBudget(unsigned int megabytes)
+{
+	m_MemoryBudget = megabytes;
+	unsigned int size = GetAtlasSizeForBudget(megabytes);
+	if (size == m_Atlas.GetSize())
+		return;
+
+	m_Atlas.Reset(size);
 	if (m_Pass.Pass)
-		m_Pass.Pass->SetResolution(resolution);
+		m_Pass.Pass->SetResolution({ size, size });
+	m_StaticPass->SetResolution({ size, size });
+
+	// Contents are lost when textures are recreated
+	Invalidate();
+}
+
+void ShadowMapPass::Invalidate()
+{
+	for (ShadowLayer& layer : m_Layers)
+		layer.StaticDirty = layer.Dirty = true;
 }
 
 ivec2& ShadowMapPass::GetResolution() { return m_Resolution; }
 RenderPipelinePass& ShadowMapPass::GetPipelinePass() { return m_Pass; }
 RenderTexture* ShadowMapPass::GetTexture() { return m_Pass.Pass->GetDepthAttachment(); }
 
-void ShadowMapPass::SetBorder()
+void ShadowMapPass::DrawCasters(ShadowLayer& layer, vector<unsigned int>& drawList)
 {
-	// Set texture clamping to border and assign border colour of white.
-	// If sampling texture outside of texture coordinates (outside of shadow map),
-	//   a value of white represents no shadow. Therefore any texture sampling outside
-	//   of the shadow map implies no shadows
-	RenderTexture* attachment = m_Pass.Pass->GetDepthAttachment();
-	attachment->Bind();
-	glBindTexture(GL_TEXTURE_2D_ARRAY, attachment->GetID());
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-	float borderColour[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColour);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-	attachment->Unbind();
+	if (drawList.empty())
+		return;
+
+	// Casters between the light and the cascade are flattened onto the near plane instead of clipped
+	if (layer.Orthographic)
+		glEnable(GL_DEPTH_CLAMP);
+
+	Shader* shader = ResourceManager::Get<Shader>(m_Pass.Shader);
+	shader->Set(LightSpaceMatrixUniform, layer.LightSpaceMatrix);
+	for (unsigned int casterIndex : drawList)
+	{
+		ShadowCaster& caster = m_Casters[casterIndex];
+		shader->Set(ModelMatrixUniform, caster.ModelMatrix);
+		ResourceManager::Get<Mesh>(caster.Mesh)->Draw();
+	}
+
+	if (layer.Orthographic)
+		glDisable(GL_DEPTH_CLAMP);
 }
 
-void SortDrawQueue(vector<MeshRenderer*>& renderers, DrawSortType sortType, vec3 viewPos)
+void ShadowMapPass::DrawCallback(Framebuffer* previous)
 {
-	if (sortType == DrawSortType::None)
+	// Skip pass entirely when no tile changed
+	bool anyDirty = false;
+	for (unsigned int i = 0; i < (unsigned int)m_Layers.size() && !anyDirty; i++)
+		anyDirty = m_Layers[i].Dirty;
+	if (!anyDirty)
 		return;
 
-	sort(renderers.begin(), renderers.end(), [=](MeshRenderer* a, MeshRenderer* b)
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+
+	// Restrict clearing & blitting to tile
+	glEnable(GL_SCISSOR_TEST);
+
+	for (ShadowLayer& layer : m_Layers)
+	{
+		if (!layer.Dirty)
+			continue; // Nothing changed since last drawn
+
+		ivec4& tile = layer.Tile;
+		glScissor(tile.x, tile.y, tile.z, tile.w);
+
+		// Redraw static casters into cache
+		if (layer.StaticDirty)
 		{
-			float distanceA = glm::distance(viewPos, a->GetTransform()->GetGlobalPosition());
-			float distanceB = glm::distance(viewPos, b->GetTransform()->GetGlobalPosition());
-			return sortType == DrawSortType::BackToFront ? (distanceA > distanceB) : (distanceB > distanceA);
-		});
+			m_StaticPass->Bind();
+			glViewport(tile.x, tile.y, tile.z, tile.w);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			DrawCasters(layer, layer.StaticDrawList);
+		}
+
+		// Start from cached static casters
+		m_StaticPass->BlitTo(m_Pass.Pass, tile, GL_DEPTH_BUFFER_BIT);
+
+		// Composite dynamic casters on top
+		m_Pass.Pass->Bind();
+		glViewport(tile.x, tile.y, tile.z, tile.w);
+		DrawCasters(layer, layer.DynamicDrawList);
+
+		layer.StaticDirty = false;
+
+		// Tiles with dynamic casters are redrawn next frame,
+		// otherwise one last time after they leave to clear them
+		layer.Dirty = !layer.DynamicDrawList.empty();
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_CULL_FACE);
+
+	m_Pass.Pass->Bind();
 }
 
-void ShadowMapPass::DrawCallback(Framebuffer* previous)
+void ShadowMapPass::UpdateShadowData()
 {
-	glEnable(GL_DEPTH_TEST);
-	glClear(GL_DEPTH_BUFFER_BIT);
-	glViewport(0, 0, m_Resolution.x, m_Resolution.y);
-
-	RenderTexture* outputTexture = m_Pass.Pass->GetDepthAttachment();
-	glFramebufferTexture(
-		GL_FRAMEBUFFER,			// Target
-		GL_DEPTH_ATTACHMENT,	// Attachment
-		outputTexture->GetID(),	// Texture
-		0						// Mipmap Level
-	);
-	glClear(GL_DEPTH_BUFFER_BIT);
-	if (m_ShadowCasters.size() == 0)
+	if (!Camera::GetMainCamera())
 		return;
 
-	SetBorder();
-
-	Shader* shader = ResourceManager::Get<Shader>(m_Pass.Shader);
+	AllocateTiles();
 
-	unsigned int lightIndex = 0;
+	// Assign layers, directional lights take one per cascade
+	unsigned int layerCount = 0;
 	for (auto& lightPair : m_ShadowCasters)
 	{
-		FillShadowData(lightPair.first, lightPair.second);
+		LightShadowData& shadowData = lightPair.second;
+		if (shadowData.ShadowMapArrayIndex < 0)
+			continue; // No space in atlas
 
-		if(lightPair.first->Type != LightType::Point)
-			lightPair.second.ShadowMapArrayIndex = lightIndex;
+		FillShadowData(lightPair.first, shadowData);
+		shadowData.ShadowMapArrayIndex = (int)layerCount;
+		layerCount += shadowData.LayerCount;
+	}
 
-		lightPair.first->FillShader(lightIndex++, shader);
+	m_Layers.resize(layerCount);
+	vector<bool> moved(layerCount, false);
+	for (auto& lightPair : m_ShadowCasters)
+	{
+		LightShadowData& shadowData = lightPair.second;
+		for (unsigned int i = 0; shadowData.ShadowMapArrayIndex >= 0 && i < shadowData.LayerCount; i++)
+		{
+			unsigned int index = shadowData.ShadowMapArrayIndex + i;
+			ShadowLayer& layer = m_Layers[index];
+			moved[index] = layer.LightSpaceMatrix != shadowData.LightSpaceMatrices[i] || layer.Tile != shadowData.Tiles[i];
+
+			layer.Tile = shadowData.Tiles[i];
+			layer.LightSpaceMatrix = shadowData.LightSpaceMatrices[i];
+			layer.Orthographic = lightPair.first->Type == LightType::Directional;
+		}
 	}
 
-	shader->Set("lightCount", std::min((int)m_ShadowCasters.size(), MAX_LIGHTS));
+	GatherCasters();
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	// Build separate draw lists for each layer, only when light or casters changed
+	JobSystem::ParallelFor(layerCount, [&](unsigned int index)
+		{
+			ShadowLayer& layer = m_Layers[index];
+			if (!moved[index] && !m_CastersChanged && !layer.StaticDirty)
+				return;
+
+			size_t previousHash = layer.StaticHash;
+			bool hadDynamic = !layer.DynamicDrawList.empty();
+			CullLayer(layer);
+
+			layer.StaticDirty |= moved[index] || layer.StaticHash != previousHash;
+			layer.Dirty |= layer.StaticDirty || hadDynamic || !layer.DynamicDrawList.empty();
+		});
+}
+
+void ShadowMapPass::GatherCasters()
+{
+	m_Casters.clear();
 
 	Scene* scene = Application::GetService<SceneService>()->CurrentScene();
-	vector<MeshRenderer*> shadowReceivers = scene->Root().GetComponentsInChildren<MeshRenderer>();
-	for (MeshRenderer* renderer : shadowReceivers)
+	vector<MeshRenderer*> renderers = scene ? scene->Root().GetComponentsInChildren<MeshRenderer>() : vector<MeshRenderer*>();
+
+	// Rebuilt every frame so removed renderers are dropped
+	EngineUnorderedMap<MeshRenderer*, CasterState> previousStates;
+	swap(previousStates, m_CasterStates);
+	m_CastersChanged = previousStates.size() != renderers.size();
+
+	for (MeshRenderer* renderer : renderers)
 	{
-		renderer->GetTransform()->FillShader(shader);
-		for (MeshRenderer::MeshInfo& mesh : renderer->Meshes)
+		Transform* transform = renderer->GetTransform();
+		CasterState& state = m_CasterStates[renderer];
+
+		auto it = previousStates.find(renderer);
+		if (it != previousStates.end() && it->second.TransformVersion == transform->GetVersion())
+			state.UnchangedFrames = it->second.UnchangedFrames + 1;
+		else
+			m_CastersChanged = true; // Added or moved
+		state.TransformVersion = transform->GetVersion();
+
+		// Becoming static changes which list it is drawn in
+		if (state.UnchangedFrames == StaticCasterFrames)
+			m_CastersChanged = true;
+
+		mat4 modelMatrix = transform->GetModelMatrix();
+		float maxScale = glm::max(length(vec3(modelMatrix[0])), glm::max(length(vec3(modelMatrix[1])), length(vec3(modelMatrix[2]))));
+
+		for (MeshRenderer::MeshInfo& meshInfo : renderer->Meshes)
 		{
-			if (mesh.Material.CanCastShadows)
-				ResourceManager::Get<Mesh>(mesh.Mesh)->Draw();
+			Mesh* mesh = ResourceManager::Get<Mesh>(meshInfo.Mesh);
+			if (!mesh || !meshInfo.Material.CanCastShadows)
+				continue;
+
+			vec3 centre = (mesh->GetBoundsMin() + mesh->GetBoundsMax()) * 0.5f;
+			float radius = length(mesh->GetBoundsMax() - centre) * maxScale;
+
+			// Level of detail chosen for the main camera is reused for shadows
+			m_Casters.emplace_back(ShadowCaster
+			{
+				modelMatrix,
+				MeshRenderer::GetLODMesh(meshInfo),
+				renderer,
+				vec4(vec3(modelMatrix * vec4(centre, 1.0f)), radius),
+				state.UnchangedFrames >= StaticCasterFrames
+			});
 		}
 	}
+}
 
-	glDisable(GL_CULL_FACE);
+void ShadowMapPass::CullLayer(ShadowLayer& layer)
+{
+	// Extract frustum planes from light space matrix (left, right, bottom, top, near, far)
+	mat4 m = transpose(layer.LightSpaceMatrix);
+	vec4 planes[6] =
+	{
+		m[3] + m[0], m[3] - m[0],
+		m[3] + m[1], m[3] - m[1],
+		m[3] + m[2], m[3] - m[2]
+	};
+	for (vec4& plane : planes)
+		plane /= length(vec3(plane));
+
+	layer.StaticHash = 0;
+	layer.StaticDrawList.clear();
+	layer.DynamicDrawList.clear();
+	for (unsigned int i = 0; i < (unsigned int)m_Casters.size(); i++)
+	{
+		ShadowCaster& caster = m_Casters[i];
+		vec4& sphere = caster.BoundingSphere;
+
+		bool visible = true;
+		for (unsigned int p = 0; p < 6 && visible; p++)
+		{
+			if (p == 4 && layer.Orthographic)
+				continue; // Casters in front of the near plane still cast shadows
+
+			visible = dot(vec3(planes[p]), vec3(sphere)) + planes[p].w >= -sphere.w;
+		}
+
+		if (!visible)
+			continue;
+
+		if (!caster.Static)
+		{
+			layer.DynamicDrawList.emplace_back(i);
+			continue;
+		}
+
+		layer.StaticDrawList.emplace_back(i);
+
+		// Combine renderer & mesh so any change to the static set is detected
+		size_t casterHash = hash<void*>()(caster.Renderer) ^ (hash<ResourceID>()(caster.Mesh) << 1);
+		layer.StaticHash ^= casterHash + 0x9e3779b9 + (layer.StaticHash << 6) + (layer.StaticHash >> 2);
+	}
+}
+
+float ShadowMapPass::GetImportance(Light* light)
+{
+	// Directional lights cover the whole view
+	if (light->Type == LightType::Directional)
+		return 1.0f;
+
+	Camera* camera = Camera::GetMainCamera();
+	Transform* cameraTransform = camera->GetTransform();
+	Transform* transform = light->GetTransform();
+
+	// Bounding sphere of spot light cone
+	float halfLength = light->Distance * 0.5f;
+	float coneRadius = light->Distance * tan(radians(glm::clamp(light->Radius, 0.01f, 89.0f)));
+	vec3 centre = transform->GetGlobalPosition() + transform->Forward() * halfLength;
+	float radius = sqrt(halfLength * halfLength + coneRadius * coneRadius);
+
+	vec3 toLight = centre - cameraTransform->GetGlobalPosition();
+	float distance = length(toLight);
+	if (distance <= radius)
+		return 1.0f; // Camera inside light
+
+	// Approximate fraction of screen height covered by light
+	float importance = radius / (distance * tan(radians(camera->FieldOfView) * 0.5f));
+
+	// Lights behind the camera are only seen through their shadows
+	if (dot(toLight, cameraTransform->Forward()) < -radius)
+		importance *= 0.25f;
+
+	return glm::clamp(importance, 0.0f, 1.0f);
+}
+
+void ShadowMapPass::AllocateTiles()
+{
+	struct TileRequest
+	{
+		LightShadowData* ShadowData;
+		float Importance;
+	};
+
+	// Most important lights get space first
+	vector<TileRequest> requests;
+	for (auto& lightPair : m_ShadowCasters)
+	{
+		LightShadowData& shadowData = lightPair.second;
+		shadowData.ShadowMapArrayIndex = -1;
+
+		// Point light shadows are not supported yet, so they don't take up a tile
+		switch (lightPair.first->Type)
+		{
+		case LightType::Directional: shadowData.LayerCount = SHADOW_CASCADE_COUNT; break;
+		case LightType::Spot:		 shadowData.LayerCount = 1; break;
+		default:					 shadowData.LayerCount = 0; break;
+		}
+
+		if (shadowData.LayerCount > 0)
+			requests.emplace_back(TileRequest { &shadowData, GetImportance(lightPair.first) });
+	}
+	sort(requests.begin(), requests.end(), [](const TileRequest& a, const TileRequest& b) { return a.Importance > b.Importance; });
+
+	m_Atlas.Clear();
+	unsigned int layerCount = 0;
+	for (TileRequest& request : requests)
+	{
+		LightShadowData& shadowData = *request.ShadowData;
+		if (layerCount + shadowData.LayerCount > MAX_SHADOW_MAPS)
+			break;
+
+		// Shrink tiles when atlas runs out of space
+		unsigned int size = m_Atlas.GetTileSize((unsigned int)(m_Resolution.x * request.Importance));
+		unsigned int allocatedCount = 0;
+		for (; allocatedCount < shadowData.LayerCount; allocatedCount++)
+		{
+			bool allocated;
+			while (!(allocated = m_Atlas.Allocate(size, shadowData.Tiles[allocatedCount])) && size > m_Atlas.GetMinTileSize())
+				size /= 2;
+			if (!allocated)
+				break;
+		}
+
+		if (allocatedCount < shadowData.LayerCount)
+		{
+			// No shadows for this light, return tiles of earlier cascades so less important lights can use them
+			for (unsigned int i = 0; i < allocatedCount; i++)
+				m_Atlas.Free(shadowData.Tiles[i]);
+			continue;
+		}
+
+		// Marks light as having tiles, final index is assigned in UpdateShadowData
+		shadowData.ShadowMapArrayIndex = 0;
+		layerCount += shadowData.LayerCount;
+	}
 }
 
 void ShadowMapPass::FillShadowData(Light* light, LightShadowData& shadowData)
 {
 	Transform* transform = light->GetTransform();
-	Transform* mainCamTransform = Camera::GetMainCamera()->GetTransform();
 	switch (light->Type)
 	{
 	default:
 	case LightType::Spot:
 	{
-		shadowData.ShadowMapArrayIndex = -1; // Reset
-
 		const float SpotNear = 0.1f;
 
 		// Calculate view matrix
@@ -173,84 +455,102 @@ void ShadowMapPass::FillShadowData(Light* light, LightShadowData& shadowData)
 		light->Radius = std::clamp(light->Radius, 0.01f, 90.0f);
 		mat4 projection = perspective(
 			radians(light->Radius * 2.0f),
-			(float)m_Resolution.x / (float)m_Resolution.y,
+			1.0f, // Tiles are square
 			SpotNear,
 			light->Distance + SpotNear
 		);
 
 		// Combine matrices
-		shadowData.LightSpaceMatrix = projection * viewMatrix;
+		shadowData.LightSpaceMatrices[0] = projection * viewMatrix;
 		break;
 	}
 	case LightType::Directional:
+		FillCascades(light, shadowData);
+		break;
+	case LightType::Point:
+		// TODO: Point Lights
+		break;
+	}
+}
+
+// Point on the view ray through ndc at the given view space depth
+vec3 FrustumCorner(const mat4& inverseProjection, vec2 ndc, float viewDepth)
+{
+	vec4 near = inverseProjection * vec4(ndc, -1.0f, 1.0f);
+	vec4 far = inverseProjection * vec4(ndc, 1.0f, 1.0f);
+	near /= near.w;
+	far /= far.w;
+
+	float t = (viewDepth + near.z) / (near.z - far.z);
+	return mix(vec3(near), vec3(far), t);
+}
+
+void ShadowMapPass::FillCascades(Light* light, LightShadowData& shadowData)
+{
+	Camera* camera = Camera::GetMainCamera();
+	mat4 inverseView = inverse(camera->GetViewMatrix());
+	mat4 inverseProjection = inverse(camera->GetProjectionMatrix());
+
+	// Shadows are drawn up to light's distance from the camera
+	float near = camera->ClipNear;
+	float far = glm::clamp(light->Distance, near + 0.01f, camera->ClipFar);
+
+	vec3 direction = normalize(light->GetTransform()->Forward());
+	vec3 up = abs(direction.y) > 0.99f ? vec3(0, 0, 1) : vec3(0, 1, 0);
+
+	float splitNear = near;
+	for (unsigned int i = 0; i < SHADOW_CASCADE_COUNT; i++)
 	{
-		shadowData.ShadowMapArrayIndex = -1; // Reset
+		// Blend of logarithmic & uniform split distribution
+		float t = (i + 1) / (float)SHADOW_CASCADE_COUNT;
+		float splitFar = mix(near + (far - near) * t, near * pow(far / near, t), CascadeSplitLambda);
+
+		// Bounding sphere of frustum slice, keeps cascade size constant when camera rotates
+		vec3 corners[8];
+		vec3 centre = vec3(0.0f);
+		for (unsigned int c = 0; c < 8; c++)
+		{
+			vec2 ndc = { (c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f };
+			corners[c] = vec3(inverseView * vec4(FrustumCorner(inverseProjection, ndc, (c & 4) ? splitFar : splitNear), 1.0f));
+			centre += corners[c] / 8.0f;
+		}
 
-		const float DirNear = 1.0f;
-		const float DirFar = 100.0f;
+		float radius = 0.0f;
+		for (vec3& corner : corners)
+			radius = glm::max(radius, distance(corner, centre));
+		radius = ceil(radius * 16.0f) / 16.0f;
 
-		// Calculate view matrix
-		vec3 pos = mainCamTransform->GetGlobalPosition() - transform->Forward() * (DirFar / 2.0f);
-		mat4 viewMatrix = lookAt(
-			pos,
-			pos + transform->Forward(),
-			vec3{ 0, 1, 0 }
-		);
+		mat4 viewMatrix = lookAt(centre - direction * radius, centre, up);
+		mat4 projection = ortho(-radius, radius, -radius, radius, 0.0f, radius * 2.0f);
 
-		mat4 projection = ortho(
-			-light->Distance,
-			light->Distance,
-			-light->Distance,
-			light->Distance, 
-			DirNear,
-			DirFar
-		);
+		// Snap to shadow map texels to prevent shimmering when the camera moves
+		vec2 resolution = vec2(shadowData.Tiles[i].z, shadowData.Tiles[i].w);
+		vec4 origin = projection * viewMatrix * vec4(0, 0, 0, 1);
+		vec2 texelOrigin = vec2(origin) * resolution * 0.5f;
+		vec2 offset = (round(texelOrigin) - texelOrigin) * 2.0f / resolution;
+		projection[3][0] += offset.x;
+		projection[3][1] += offset.y;
 
-		// Combine matrices
-		shadowData.LightSpaceMatrix = projection * viewMatrix;
-		break;
-	}
-	case LightType::Point:
-		// TODO: Point Lights
-		shadowData.ShadowMapArrayIndex = -1; // Reset
-		break;
+		shadowData.LightSpaceMatrices[i] = projection * viewMatrix;
+		splitNear = splitFar;
 	}
 }
 
 void ShadowMapPass::AddShadowCaster(Components::Light* light)
 {
-	auto& it = m_ShadowCasters.find(light);
+	auto it = m_ShadowCasters.find(light);
 	if (it != m_ShadowCasters.end())
 		return; // Already in map
 
+	// Shadow map layers are assigned in UpdateShadowData
 	m_ShadowCasters.emplace(make_pair(light, LightShadowData()));
-
-	RenderTexture* depthAttachment = m_Pass.Pass->GetDepthAttachment();
-	if (!depthAttachment)
-		m_Pass.Pass->GetSpecs().Attachments[0].DepthInfo.Depth++;
-	else if(m_ShadowCasters.size() > 0)
-	{
-		m_Pass.Pass->GetDepthAttachment()->GetArgs().Depth.Depth++;
-		depthAttachment->SetDirty();
-	}
 }
 
 void ShadowMapPass::RemoveShadowCaster(Components::Light* light)
 {
-	auto& it = m_ShadowCasters.find(light);
+	auto it = m_ShadowCasters.find(light);
 	if (it == m_ShadowCasters.end())
 		return; // Not in map
 
-	m_ShadowCasters.erase(light);
-
-	RenderTextureArgs& rtArgs = m_Pass.Pass->GetDepthAttachment()->GetArgs();
-	rtArgs.Depth.Depth = std::max(rtArgs.Depth.Depth - 1u, 1u); // Minimum value of 1 for valid framebuffer
-
-	RenderTexture* depthAttachment = m_Pass.Pass->GetDepthAttachment();
-	unsigned int& depth = depthAttachment ? depthAttachment->GetArgs().Depth.Depth :
-							m_Pass.Pass->GetSpecs().Attachments[0].DepthInfo.Depth;
-	depth = std::max(depth - 1u, 1u); // Minimum value of 1 for valid framebuffer object
-
-	if(depthAttachment)
-		depthAttachment->SetDirty();
-}
+	m_ShadowCasters.erase(it);
+}
\ No newline at end of file
@@ -10,7 +10,16 @@ using namespace Engine;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
-Skybox::Skybox() : EnvironmentMap(nullptr), AmbientLightStrength(1.0f)
+constexpr UniformHandle AmbientLightStrengthUniform("environment.AmbientLightStrength");
+constexpr UniformHandle EnvironmentMapUniform("environment.EnvironmentMap");
+constexpr UniformHandle ReflectionMapUniform("environment.ReflectionMap");
+constexpr UniformHandle PrefilterMapUniform("environment.PrefilterMap");
+constexpr UniformHandle BRDFMapUniform("environment.BRDFMap");
+
+Skybox::Skybox() :
+	m_EnvironmentBuffer(UniformBlockBinding::Environment, sizeof(EnvironmentUniformBlock)),
+	EnvironmentMap(nullptr),
+	AmbientLightStrength(1.0f)
 {
 	m_ShaderID = ResourceManager::LoadNamed<Shader>("Shaders/Skybox", ShaderStageInfo
 	{
@@ -36,10 +45,6 @@ void Skybox::Draw()
 
 	FillShaderData(m_Shader);
 
-	Camera* camera = Camera::GetMainCamera();
-	if (camera)
-		camera->FillShader(m_Shader);
-
 	ResourceManager::Get<Mesh>(Mesh::Cube())->Draw();
 
 	m_Shader->Unbind();
@@ -51,14 +56,13 @@ void Skybox::Draw()
 
 void Skybox::FillShaderData(Shader* shader)
 {
-	shader->Set("environment.AmbientLightStrength", AmbientLightStrength);
+	shader->Set(AmbientLightStrengthUniform, AmbientLightStrength);
 
 	// Environment Map
-	shader->Set("environment.EnvironmentMap", 6);
-	shader->Set("environment.IrradianceMap", 7);
-	shader->Set("environment.ReflectionMap", 8);
-	shader->Set("environment.PrefilterMap", 9);
-	shader->Set("environment.BRDFMap", 10);
+	shader->Set(EnvironmentMapUniform, 6);
+	shader->Set(ReflectionMapUniform, 8);
+	shader->Set(PrefilterMapUniform, 9);
+	shader->Set(BRDFMapUniform, 10);
 
 	// Environment Map
 	glActiveTexture(GL_TEXTURE6);
@@ -67,12 +71,13 @@ void Skybox::FillShaderData(Shader* shader)
 		EnvironmentMap->GetCubemap()->GetID() : 0
 	);
 
-	// Irradiance Map
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_CUBE_MAP,
-		EnvironmentMap && EnvironmentMap->GetIrradianceMap() ?
-		EnvironmentMap->GetIrradianceMap()->GetID() : 0
-	);
+	// Irradiance
+	EnvironmentUniformBlock environment;
+	IrradianceSH* irradiance = EnvironmentMap ? &EnvironmentMap->GetIrradianceSH() : nullptr;
+	for (unsigned int i = 0; i < 9; i++)
+		environment.IrradianceSH[i] = irradiance ? vec4(irradiance->Coefficients[i], 0.0f) : vec4(0.0f);
+	m_EnvironmentBuffer.SetData(&environment, sizeof(EnvironmentUniformBlock));
+	m_EnvironmentBuffer.Bind();
 
 	// Reflection Map
 	glActiveTexture(GL_TEXTURE8);
@@ -3,6 +3,8 @@
 #include <Engine/ResourceManager.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
+#include <Engine/Graphics/LightClusters.hpp>
+#include <Engine/Graphics/OcclusionCulling.hpp>
 #include <Engine/Services/SceneService.hpp>
 #include <Engine/Graphics/Passes/Skybox.hpp>
 #include <Engine/Graphics/Passes/ShadowMap.hpp>
@@ -18,21 +20,37 @@ using namespace Engine::Graphics;
 using namespace Engine::Components;
 using namespace Engine::Graphics::Pipelines;
 
+constexpr UniformHandle InputNormalUniform("inputNormal");
+constexpr UniformHandle InputAlbedoMetalnessUniform("inputAlbedoMetalness");
+constexpr UniformHandle InputRoughnessFlagsUniform("inputRoughnessFlags");
+constexpr UniformHandle InputDepthUniform("inputDepth");
+constexpr UniformHandle InputDepthMSUniform("inputDepthMS");
+constexpr UniformHandle ShadowMapUniform("shadowMap");
+constexpr UniformHandle LightOffsetUniform("lightOffset");
+
+// Render graph textures, layout must match GBuffer.inc.
+// World position is reconstructed from depth, so it is sampled & not a renderbuffer.
+const string NormalTexture = "GBuffer.Normal";
+const string AlbedoMetalnessTexture = "GBuffer.AlbedoMetalness";
+const string RoughnessFlagsTexture = "GBuffer.RoughnessFlags";
+const string DepthTexture = "Depth";
+const string SceneColourTexture = "SceneColour";
+
+const string MeshPassName = "Deferred -> Mesh";
+
 DeferredRenderPipeline::DeferredRenderPipeline()
 {
-	FramebufferSpec framebufferSpecs = { Renderer::GetResolution() };
-
 	// Mesh Pass //
-	framebufferSpecs.Attachments =
+	RenderPipelinePass pass;
+	pass.Name = MeshPassName;
+	pass.Writes =
 	{
-		{ TextureFormat::RGBA16F, TexturePixelType::Float },	// Position + Roughness
-		{ TextureFormat::RGBA16F, TexturePixelType::Float },	// Normal + Metalness
-		TextureFormat::RGB8,	// Albedo
-		TextureFormat::Depth
+		{ NormalTexture, TextureFormat::RG16, TexturePixelType::UnsignedShort },
+		{ AlbedoMetalnessTexture, TextureFormat::RGBA8, TexturePixelType::UnsignedByte },
+		{ RoughnessFlagsTexture, TextureFormat::RG8, TexturePixelType::UnsignedByte },
+		{ DepthTexture, TextureFormat::Depth24, TexturePixelType::Float }
 	};
 
-	m_MeshPass = new Framebuffer(framebufferSpecs);
-
 	ShaderStageInfo meshShaderStages =
 	{
 		Application::AssetDir + "Shaders/Deferred/Mesh.vert",
@@ -45,21 +63,19 @@ DeferredRenderPipeline::DeferredRenderPipeline()
 		meshShaderStages.TessellationEvaluate = Application::AssetDir + "Shaders/Tessellation/Evaluate.tess";
 	}
 	
-	m_MeshShader = ResourceManager::LoadNamed<Shader>("Shaders/Deferred/Mesh", meshShaderStages);
-
-	RenderPipelinePass pass = { "Deferred -> Mesh", m_MeshShader, m_MeshPass};
+	pass.Shader = m_MeshShader = ResourceManager::LoadNamed<Shader>("Shaders/Deferred/Mesh", meshShaderStages);
 	pass.DrawCallback = std::bind(&DeferredRenderPipeline::MeshPass, this, ::placeholders::_1);
 	AddPass(pass);
 
 	// Lighting Pass //
-	framebufferSpecs.Attachments =
+	// Light volumes are depth tested against the mesh pass' depth, attached without copying
+	pass.Name = "Deferred -> Lighting";
+	pass.Reads = { NormalTexture, AlbedoMetalnessTexture, RoughnessFlagsTexture, DepthTexture };
+	pass.Writes =
 	{
-		{ TextureFormat::RGBA16F, TexturePixelType::Float },
-		TextureFormat::Depth
+		{ SceneColourTexture, TextureFormat::RGBA16F, TexturePixelType::Float },
+		{ DepthTexture, TextureFormat::Depth24, TexturePixelType::Float }
 	};
-	m_LightingPass = new Framebuffer(framebufferSpecs);
-	pass.Name = "Deferred -> Lighting";
-	pass.Pass = m_LightingPass;
 	pass.DrawCallback = bind(&DeferredRenderPipeline::LightingPass, this, ::placeholders::_1);
 
 	pass.Shader = m_LightingShader = ResourceManager::LoadNamed<Shader>("Shaders/Deferred/Lighting",
@@ -70,14 +86,16 @@ DeferredRenderPipeline::DeferredRenderPipeline()
 		});
 	AddPass(pass);
 
+	m_LightVolumeShader = ResourceManager::LoadNamed<Shader>("Shaders/Deferred/LightVolume",
+		ShaderStageInfo
+		{
+			Application::AssetDir + "Shaders/Deferred/LightVolume.vert",
+			Application::AssetDir + "Shaders/Deferred/LightVolume.frag",
+		});
+
 	// Forward/Transparent Pass //
-	framebufferSpecs.Attachments =
-	{
-		{ TextureFormat::RGBA16F, TexturePixelType::Float },
-		TextureFormat::Depth
-	};
-	m_ForwardPass = new Framebuffer(framebufferSpecs);
-	pass.Pass = m_ForwardPass;
+	// Draws over the lit scene
+	pass.Reads = { SceneColourTexture, DepthTexture };
 	pass.DrawCallback = bind(&DeferredRenderPipeline::ForwardPass, this, ::placeholders::_1);
 
 	m_ForwardShader = ResourceManager::LoadNamed<Shader>("Shaders/Forward",
@@ -91,15 +109,16 @@ DeferredRenderPipeline::DeferredRenderPipeline()
 	AddPass(pass);
 }
 
-DeferredRenderPipeline::~DeferredRenderPipeline()
+DeferredRenderPipeline::~DeferredRenderPipeline() { }
+
+Framebuffer* DeferredRenderPipeline::GetMainMeshPass()
 {
-	delete m_MeshPass;
-	delete m_ForwardPass;
-	delete m_LightingPass;
+	for (RenderPipelinePass& pass : m_RenderPasses)
+		if (pass.Name == MeshPassName)
+			return pass.Pass;
+	return nullptr;
 }
 
-Framebuffer* DeferredRenderPipeline::GetMainMeshPass() { return m_MeshPass; }
-
 void DeferredRenderPipeline::MeshPass(Framebuffer* previous)
 {
 	glDisable(GL_BLEND);
@@ -110,57 +129,61 @@ void DeferredRenderPipeline::MeshPass(Framebuffer* previous)
 	DrawArgs args;
 	args.ClearQueue = false;
 	args.RenderTransparent = false;
+	args.OcclusionCull = true;
 	Renderer::Draw(args);
+
+	// Opaque depth is tested against by the next frame's mesh pass
+	GetOcclusionCulling()->Build(m_Graph.GetTexture(DepthTexture), *m_CurrentCamera);
 }
 
-void DeferredRenderPipeline::LightingPass(Framebuffer* previous)
+void DeferredRenderPipeline::FillGBufferSamplers(Shader* shader)
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	// FILL G-BUFFER MAPS //
-	// Position
-	m_MeshPass->GetColourAttachment()->Bind();
-	m_CurrentShader->Set("inputPositionRoughness", 0);
-	m_CurrentShader->Set("inputPositionRoughnessMS", 0);
-
 	// Normals
-	m_MeshPass->GetColourAttachment(1)->Bind(1);
-	m_CurrentShader->Set("inputNormalMetalness", 1);
-	m_CurrentShader->Set("inputNormalMetalnessMS", 1);
-
-	// Albedo
-	m_MeshPass->GetColourAttachment(2)->Bind(2);
-	m_CurrentShader->Set("inputAlbedo", 2);
-	m_CurrentShader->Set("inputAlbedoMS", 2);
+	m_Graph.GetTexture(NormalTexture)->Bind();
+	shader->Set(InputNormalUniform, 0);
 
-	// Depth
-	m_MeshPass->GetDepthAttachment()->Bind(3);
-	m_CurrentShader->Set("inputDepth", 3);
-	m_CurrentShader->Set("inputDepthMS", 3);
+	// Albedo & metalness
+	m_Graph.GetTexture(AlbedoMetalnessTexture)->Bind(1);
+	shader->Set(InputAlbedoMetalnessUniform, 1);
 
-	// Environment Map
-	Skybox* skybox = Renderer::GetPipeline()->GetSkybox();
-	if (skybox)
-		skybox->FillShaderData(m_CurrentShader);
+	// Roughness & flags
+	m_Graph.GetTexture(RoughnessFlagsTexture)->Bind(2);
+	shader->Set(InputRoughnessFlagsUniform, 2);
 
-	// FILL LIGHT DATA //
-	Scene* scene = Application::GetService<Services::SceneService>()->CurrentScene();
-	auto lights = scene->Root().GetComponentsInChildren<Light>();
-	int lightCount = std::min((int32_t)lights.size(), MAX_LIGHTS);
-	m_CurrentShader->Set("lightCount", lightCount);
-	for (int i = 0; i < lightCount; i++)
-		lights[i]->FillShader(i, m_CurrentShader);
+	// Depth, also attached to the lighting pass but never written while sampled
+	m_Graph.GetTexture(DepthTexture)->Bind(3);
+	shader->Set(InputDepthUniform, 3);
+	shader->Set(InputDepthMSUniform, 3);
 
 	ShadowMapPass* shadowMap = Renderer::GetPipeline()->GetShadowMapPass();
 	if (shadowMap && shadowMap->GetPipelinePass().Pass)
 	{
 		shadowMap->GetTexture()->Bind(5);
-		m_CurrentShader->Set("shadowMap", 5);
+		shader->Set(ShadowMapUniform, 5);
 	}
+}
+
+void DeferredRenderPipeline::LightingPass(Framebuffer* previous)
+{
+	// Depth is shared with the mesh pass & kept
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// FILL G-BUFFER MAPS //
+	FillGBufferSamplers(m_CurrentShader);
+
+	// Environment Map
+	Skybox* skybox = Renderer::GetPipeline()->GetSkybox();
+	if (skybox)
+		skybox->FillShaderData(m_CurrentShader);
 
 	// DRAW FULLSCREEN QUAD //
+	// Ambient & directional lights
+	glDisable(GL_DEPTH_TEST);
 	ResourceManager::Get<Mesh>(Mesh::Quad())->Draw();
 
+	// DRAW LIGHT VOLUMES //
+	DrawLightVolumes();
+
 	// Unbind textures
 	for (int i = 0; i < 4; i++)
 	{
@@ -170,19 +193,63 @@ void DeferredRenderPipeline::LightingPass(Framebuffer* previous)
 	}
 
 	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
 	glActiveTexture(GL_TEXTURE0);
 }
 
-void DeferredRenderPipeline::ForwardPass(Framebuffer* previous)
+void DeferredRenderPipeline::DrawLightVolumes()
 {
+	LightClusters* lights = GetLightClusters();
+	unsigned int pointCount = lights->GetPointLightCount();
+	unsigned int spotCount = lights->GetSpotLightCount();
+	Shader* volumeShader = ResourceManager::Get<Shader>(m_LightVolumeShader);
+	if ((pointCount + spotCount) == 0 || !volumeShader)
+		return;
+
+	Shader* lightingShader = m_CurrentShader;
+	m_CurrentShader = volumeShader;
+	volumeShader->Bind();
+
+	FillGBufferSamplers(volumeShader);
+	LightClusters::FillSamplers(volumeShader);
+
+	// Only back faces behind or touching geometry light it, this works with the camera inside a volume
+	// and does not need a stencil pass, so every light of a type is a single instanced draw
 	glEnable(GL_DEPTH_TEST);
-	glClearColor(0, 0, 0, 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_GEQUAL);
+	glEnable(GL_DEPTH_CLAMP); // Keep back faces past the far plane
 
-	m_MeshPass->BlitTo(m_ForwardPass, GL_DEPTH_BUFFER_BIT);
-	m_LightingPass->BlitTo(m_ForwardPass, GL_COLOR_BUFFER_BIT);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	unsigned int offset = lights->GetDirectionalLightCount();
+	volumeShader->Set(LightOffsetUniform, (int)offset);
+	ResourceManager::Get<Mesh>(Mesh::LightSphere())->Draw(pointCount);
+
+	volumeShader->Set(LightOffsetUniform, (int)(offset + pointCount));
+	ResourceManager::Get<Mesh>(Mesh::LightCone())->Draw(spotCount);
+
+	// Restore state
+	glDisable(GL_BLEND);
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_DEPTH_CLAMP);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+
+	m_CurrentShader = lightingShader;
+	lightingShader->Bind();
+}
+
+void DeferredRenderPipeline::ForwardPass(Framebuffer* previous)
+{
+	// Scene colour & depth are kept from the lighting pass
+	glEnable(GL_DEPTH_TEST);
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -197,17 +264,9 @@ void DeferredRenderPipeline::ForwardPass(Framebuffer* previous)
 	if (shadowMap && shadowMap->GetPipelinePass().Pass)
 	{
 		shadowMap->GetTexture()->Bind(5);
-		m_CurrentShader->Set("shadowMap", 5);
+		m_CurrentShader->Set(ShadowMapUniform, 5);
 	}
 
-	// FILL LIGHT DATA //
-	Scene* scene = Application::GetService<Services::SceneService>()->CurrentScene();
-	auto lights = scene->Root().GetComponentsInChildren<Light>();
-	int lightCount = std::min((int32_t)lights.size(), MAX_LIGHTS);
-	m_CurrentShader->Set("lightCount", lightCount);
-	for (int i = 0; i < lightCount; i++)
-		lights[i]->FillShader(i, m_CurrentShader);
-
 	DrawArgs args;
 	args.RenderOpaque = false;
 	args.DrawSorting = DrawSortType::BackToFront;
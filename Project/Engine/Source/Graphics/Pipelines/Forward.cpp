@@ -15,45 +15,61 @@ using namespace Engine::Graphics;
 using namespace Engine::Components;
 using namespace Engine::Graphics::Pipelines;
 
+constexpr UniformHandle ShadowMapUniform("shadowMap");
+
 #define USE_TESSELLATION 0
 
+const string ForwardPassName = "Forward Renderer";
+
 ForwardRenderPipeline::ForwardRenderPipeline() 
 {
-	FramebufferSpec framebufferSpecs = { Renderer::GetResolution() };
-	framebufferSpecs.Attachments =
-	{
-		{ TextureFormat::RGBA16F, TexturePixelType::Float },
-		TextureFormat::Depth
-	};
-
 	ShaderStageInfo shaderStages =
 	{
 		Application::AssetDir + "Shaders/Forward/Mesh.vert",
 		Application::AssetDir + "Shaders/Forward/Mesh.frag"
 	};
 
+	// Depth pre-pass only needs positions, unless tessellated where
+	// the same stages must run for depth to exactly match the forward pass
+	ShaderStageInfo prepassStages =
+	{
+		Application::AssetDir + "Shaders/Forward/DepthPrepass.vert",
+		Application::AssetDir + "Shaders/Forward/DepthPrepass.frag"
+	};
+
 	if (Renderer::SupportsTessellation())
 	{
 		shaderStages.TessellationControl = Application::AssetDir + "Shaders/Tessellation/Control.tess";
 		shaderStages.TessellationEvaluate = Application::AssetDir + "Shaders/Tessellation/Evaluate.tess";
+
+		prepassStages.VertexPath = shaderStages.VertexPath;
+		prepassStages.TessellationControl = shaderStages.TessellationControl;
+		prepassStages.TessellationEvaluate = shaderStages.TessellationEvaluate;
 	}
 	m_ForwardShader = ResourceManager::LoadNamed<Shader>("Shaders/Forward", shaderStages);
+	m_DepthPrepassShader = ResourceManager::LoadNamed<Shader>("Shaders/Forward/DepthPrepass", prepassStages);
 
-	m_ForwardPass = new Framebuffer(framebufferSpecs);
-	RenderPipelinePass pass = { "Forward Renderer", m_ForwardShader, m_ForwardPass};
+	RenderPipelinePass pass = { ForwardPassName, m_ForwardShader };
 	pass.DrawCallback = bind(&ForwardRenderPipeline::ForwardPass, this, ::placeholders::_1);
+	pass.Writes =
+	{
+		{ "SceneColour", TextureFormat::RGBA16F, TexturePixelType::Float },
+		{ "Depth", TextureFormat::Depth24, TexturePixelType::Float }
+	};
 
 	AddPass(pass);
 }
 
-ForwardRenderPipeline::~ForwardRenderPipeline()
+ForwardRenderPipeline::~ForwardRenderPipeline() { RemovePass(ForwardPassName); }
+
+Framebuffer* ForwardRenderPipeline::GetMainMeshPass()
 {
-	RemovePass(m_ForwardPass);
-	delete m_ForwardPass;
+	for (RenderPipelinePass& pass : m_RenderPasses)
+		if (pass.Name == ForwardPassName)
+			return pass.Pass;
+	return nullptr;
 }
 
-Framebuffer* ForwardRenderPipeline::GetMainMeshPass() { return m_ForwardPass; }
-
 void ForwardRenderPipeline::ForwardPass(Framebuffer* previous)
 {
 	glEnable(GL_DEPTH_TEST);
@@ -65,19 +81,12 @@ void ForwardRenderPipeline::ForwardPass(Framebuffer* previous)
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	Scene* scene = Application::GetService<Services::SceneService>()->CurrentScene();
-	auto lights = scene->Root().GetComponentsInChildren<Light>();
-	int lightCount = std::min((int32_t)lights.size(), MAX_LIGHTS);
-	m_CurrentShader->Set("lightCount", lightCount);
-	for (int i = 0; i < lightCount; i++)
-		lights[i]->FillShader(i, m_CurrentShader);
-
 	/*
 	ShadowMapPass* shadowMap = Renderer::GetPipeline()->GetShadowMapPass();
 	if (shadowMap && shadowMap->GetPipelinePass().Pass)
 	{
 		shadowMap->GetTexture()->Bind(5);
-		m_CurrentShader->Set("shadowMap", 5);
+		m_CurrentShader->Set(ShadowMapUniform, 5);
 	}
 	*/
 
@@ -86,7 +95,29 @@ void ForwardRenderPipeline::ForwardPass(Framebuffer* previous)
 	if (skybox)
 		skybox->FillShaderData(m_CurrentShader);
 
+	// Only the nearest opaque surface of each pixel passes the depth test after a pre-pass
+	bool prepassDrawn = EnableDepthPrepass && DrawDepthPrepass();
+	if (prepassDrawn)
+	{
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	// Opaque meshes in any order, allowing indirect draws
 	DrawArgs args;
+	args.ClearQueue = false;
+	args.RenderTransparent = false;
+	Renderer::Draw(args);
+
+	if (prepassDrawn)
+	{
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+
+	args.ClearQueue = true;
+	args.RenderOpaque = false;
+	args.RenderTransparent = true;
 	args.DrawSorting = DrawSortType::BackToFront;
 	Renderer::Draw(args);
 
@@ -95,4 +126,31 @@ void ForwardRenderPipeline::ForwardPass(Framebuffer* previous)
 	glBlendFunc(GL_ONE, GL_ZERO);
 
 	Renderer::GetPipeline()->GetSkybox()->Draw();
+}
+
+bool ForwardRenderPipeline::DrawDepthPrepass()
+{
+	Shader* prepassShader = ResourceManager::Get<Shader>(m_DepthPrepassShader);
+	if (!prepassShader)
+		return false;
+
+	Shader* forwardShader = m_CurrentShader;
+	m_CurrentShader = prepassShader;
+	prepassShader->Bind();
+
+	glDisable(GL_BLEND);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	// Any order allowing indirect draws, fragments are cheap. Queue is kept for the colour pass.
+	DrawArgs args;
+	args.ClearQueue = false;
+	args.RenderTransparent = false;
+	Renderer::Draw(args);
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glEnable(GL_BLEND);
+
+	m_CurrentShader = forwardShader;
+	forwardShader->Bind();
+	return true;
 }
\ No newline at end of file
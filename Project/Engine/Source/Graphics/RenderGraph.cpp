@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <unordered_set>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/Framebuffer.hpp>
+#include <Engine/Graphics/RenderGraph.hpp>
+#include <Engine/Graphics/RenderPipeline.hpp>
+
+using namespace glm;
+using namespace std;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+bool IsDepthFormat(TextureFormat format)
+{
+	return format == TextureFormat::Depth16 ||
+		   format == TextureFormat::Depth24 ||
+		   format == TextureFormat::RenderBuffer;
+}
+
+RenderGraph::~RenderGraph() { Release(); }
+
+void RenderGraph::Release()
+{
+	for (Framebuffer* framebuffer : m_Framebuffers)
+		delete framebuffer;
+	for (AllocatedTexture& allocated : m_Allocated)
+		delete allocated.Texture;
+
+	m_Framebuffers.clear();
+	m_Allocated.clear();
+	m_Textures.clear();
+}
+
+void RenderGraph::Compile(vector<RenderPipelinePass>& passes, ivec2 resolution)
+{
+	Release();
+	m_Dirty = false;
+
+	unsigned int passCount = (unsigned int)passes.size();
+	if (passCount == 0)
+		return;
+
+	// Passes without declared reads sample the output of the pass before them
+	vector<vector<string>> reads(passCount);
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		if (!passes[i].Reads.empty())
+			reads[i] = passes[i].Reads;
+		else if (i > 0)
+			for (RenderGraphTexture& write : passes[i - 1].Writes)
+				reads[i].emplace_back(write.Name);
+	}
+
+	// Walk back from the final output, a pass is only drawn if a later drawn pass reads something it writes
+	vector<bool> culled(passCount, false);
+	unordered_set<string> needed;
+	for (RenderGraphTexture& write : passes[passCount - 1].Writes)
+		needed.emplace(write.Name);
+
+	for (int i = (int)passCount - 1; i >= 0; i--)
+	{
+		vector<RenderGraphTexture>& writes = passes[i].Writes;
+		culled[i] = !writes.empty() && none_of(writes.begin(), writes.end(),
+			[&](RenderGraphTexture& write) { return needed.count(write.Name) > 0; });
+		if (culled[i])
+		{
+			passes[i].Pass = nullptr;
+			Log::Debug("Render graph culled pass '" + passes[i].Name + "'");
+			continue;
+		}
+
+		needed.insert(reads[i].begin(), reads[i].end());
+	}
+
+	// Lifetimes of textures, as indices of the first & last drawn pass to use them.
+	// The final output is used past the last pass, when copied to the screen or camera target.
+	unordered_map<string, uvec2> lifetimes;
+	unordered_map<string, RenderGraphTexture> descriptions;
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		if (culled[i])
+			continue;
+
+		for (RenderGraphTexture& write : passes[i].Writes)
+		{
+			auto it = lifetimes.find(write.Name);
+			if (it == lifetimes.end())
+			{
+				lifetimes.emplace(write.Name, uvec2(i, i));
+				descriptions.emplace(write.Name, write); // First pass to write a texture decides the format
+			}
+			else
+				it->second.y = i;
+		}
+
+		for (string& name : reads[i])
+		{
+			auto it = lifetimes.find(name);
+			if (it != lifetimes.end())
+				it->second.y = i;
+			else if (!passes[i].Reads.empty())
+				Log::Warning("Render pass '" + passes[i].Name + "' reads '" + name + "' before it is written");
+		}
+	}
+
+	for (RenderGraphTexture& write : passes[passCount - 1].Writes)
+		lifetimes[write.Name].y = passCount;
+
+	// Textures are allocated in the order they are first written, reusing any allocation of a
+	// matching format that is no longer in use
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		if (culled[i])
+			continue;
+
+		for (RenderGraphTexture& write : passes[i].Writes)
+		{
+			uvec2 lifetime = lifetimes[write.Name];
+			if (lifetime.x != i || m_Textures.find(write.Name) != m_Textures.end())
+				continue; // Allocated by an earlier pass
+
+			RenderGraphTexture& description = descriptions[write.Name];
+			auto it = find_if(m_Allocated.begin(), m_Allocated.end(), [&](AllocatedTexture& allocated)
+				{
+					return allocated.LastUse < i &&
+						allocated.Texture->GetFormat() == description.Format &&
+						allocated.Texture->GetArgs().PixelType == description.PixelType;
+				});
+
+			if (it == m_Allocated.end())
+			{
+				RenderTextureArgs args;
+				args.Resolution = resolution;
+				args.Format = description.Format;
+				args.PixelType = description.PixelType;
+				m_Allocated.emplace_back(AllocatedTexture { new RenderTexture(args), lifetime.y });
+				it = m_Allocated.end() - 1;
+			}
+			else
+				it->LastUse = lifetime.y;
+
+			m_Textures.emplace(write.Name, it->Texture);
+		}
+	}
+
+	// Framebuffers draw to the written textures, colour attachments in order of declaration
+	for (unsigned int i = 0; i < passCount; i++)
+	{
+		if (culled[i] || passes[i].Writes.empty())
+			continue;
+
+		vector<RenderTexture*> colourAttachments;
+		RenderTexture* depthAttachment = nullptr;
+		for (RenderGraphTexture& write : passes[i].Writes)
+		{
+			RenderTexture* texture = m_Textures[write.Name];
+			if (IsDepthFormat(texture->GetFormat()))
+				depthAttachment = texture;
+			else
+				colourAttachments.emplace_back(texture);
+		}
+
+		passes[i].Pass = new Framebuffer(colourAttachments, depthAttachment);
+		m_Framebuffers.emplace_back(passes[i].Pass);
+	}
+
+	Log::Debug("Compiled render graph [" + to_string(m_Textures.size()) + " textures][" + to_string(m_Allocated.size()) + " allocated]");
+}
+
+RenderTexture* RenderGraph::GetTexture(const string& name)
+{
+	auto it = m_Textures.find(name);
+	return it != m_Textures.end() ? it->second : nullptr;
+}
+
+void RenderGraph::SetDirty() { m_Dirty = true; }
+bool RenderGraph::IsDirty() { return m_Dirty; }
+unsigned int RenderGraph::GetAllocatedTextureCount() { return (unsigned int)m_Allocated.size(); }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <algorithm>
 #include <Engine/Application.hpp>
 #include <Engine/Graphics/Mesh.hpp>
@@ -8,7 +9,10 @@
 #include <Engine/Graphics/Framebuffer.hpp>
 #include <Engine/Services/SceneService.hpp>
 #include <Engine/Graphics/Passes/Skybox.hpp>
+#include <Engine/Graphics/UniformBuffer.hpp>
+#include <Engine/Graphics/LightClusters.hpp>
 #include <Engine/Graphics/RenderPipeline.hpp>
+#include <Engine/Graphics/OcclusionCulling.hpp>
 #include <Engine/Graphics/Passes/ShadowMap.hpp>
 
 using namespace glm;
@@ -18,12 +22,20 @@ using namespace Engine::Services;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
+constexpr UniformHandle SamplesUniform("samples");
+
 const ivec2 ShadowMapResolution = { 1024, 1024 };
 
 RenderPipeline::RenderPipeline()
 {
 	m_Skybox = new Skybox();
 	m_ShadowPass = new ShadowMapPass(ShadowMapResolution);
+	m_LightClusters = new LightClusters();
+	m_OcclusionCulling = new OcclusionCulling();
+
+	m_FrameBuffer = new UniformBuffer(UniformBlockBinding::Frame, sizeof(FrameUniformBlock));
+	m_CameraBuffer = new UniformBuffer(UniformBlockBinding::Camera, sizeof(CameraUniformBlock));
+	m_LightBuffer = new UniformBuffer(UniformBlockBinding::Lights, sizeof(LightUniformBlock));
 
 	AddPass(m_ShadowPass->GetPipelinePass());
 }
@@ -31,18 +43,80 @@ RenderPipeline::RenderPipeline()
 RenderPipeline::~RenderPipeline()
 {
 	delete m_ShadowPass;
+	delete m_LightClusters;
+	delete m_OcclusionCulling;
+
+	delete m_FrameBuffer;
+	delete m_CameraBuffer;
+	delete m_LightBuffer;
 }
 
-void RenderPipeline::Draw(Camera& camera)
+void RenderPipeline::BeginFrame()
 {
+	FrameUniformBlock frame;
+	frame.Time = Renderer::GetTime();
+	frame.DeltaTime = Renderer::GetDeltaTime();
+	frame.Resolution = { Renderer::GetResolution().x, Renderer::GetResolution().y };
+	m_FrameBuffer->SetData(&frame, sizeof(FrameUniformBlock));
+
+	// Light space matrices & shadow map indices are read when filling light data
+	m_ShadowPass->UpdateShadowData();
+
 	Scene* scene = Application::GetService<SceneService>()->CurrentScene();
+	vector<Light*> lights = scene ? scene->Root().GetComponentsInChildren<Light>() : vector<Light*>();
+
+	m_LightClusters->SetLights(lights);
+
+	LightUniformBlock lightBlock;
+	lightBlock.LightCount = (int)m_LightClusters->GetLightCount();
+	lightBlock.DirectionalLightCount = (int)m_LightClusters->GetDirectionalLightCount();
+	lightBlock.ShadowMapCount = 0;
+	for (auto& pair : m_ShadowPass->m_ShadowCasters)
+	{
+		int index = pair.second.ShadowMapArrayIndex;
+		if (index < 0)
+			continue;
 
+		// Directional lights have a layer per cascade
+		for (unsigned int i = 0; i < pair.second.LayerCount; i++)
+		{
+			lightBlock.ShadowTiles[index + i] = vec4(pair.second.Tiles[i]) / (float)m_ShadowPass->GetAtlasSize();
+			lightBlock.ShadowMatrices[index + i] = pair.second.LightSpaceMatrices[i];
+		}
+		lightBlock.ShadowMapCount = std::max(lightBlock.ShadowMapCount, index + (int)pair.second.LayerCount);
+	}
+
+	// Only upload the shadow matrices in use
+	m_LightBuffer->SetData(&lightBlock, (unsigned int)(offsetof(LightUniformBlock, ShadowMatrices) + sizeof(mat4) * lightBlock.ShadowMapCount));
+}
+
+void RenderPipeline::Draw(Camera& camera)
+{
+	CameraUniformBlock cameraBlock = {};
+	camera.FillUniformBlock(cameraBlock);
+	m_CameraBuffer->SetData(&cameraBlock, sizeof(CameraUniformBlock));
+
+	m_FrameBuffer->Bind();
+	m_CameraBuffer->Bind();
+	m_LightBuffer->Bind();
+
+	// Camera data is read when culling on the GPU
+	m_LightClusters->Cull(camera);
+	m_LightClusters->Bind();
+
+	if (m_Graph.IsDirty())
+		m_Graph.Compile(m_RenderPasses, Renderer::GetResolution());
+
+	m_CurrentCamera = &camera;
 	m_PreviousPass = nullptr;
 	for(unsigned int i = 0; i < (unsigned int)m_RenderPasses.size(); i++)
 	{
 		RenderPipelinePass& info = m_RenderPasses[i];
+		if (!info.Pass)
+			continue; // Culled by render graph
 
 		// Setup
+		m_CurrentPass = info.Pass;
 		info.Pass->Bind();
 
 		m_CurrentShader = ResourceManager::Get<Shader>(info.Shader);
@@ -50,12 +124,8 @@ void RenderPipeline::Draw(Camera& camera)
 		{
 			m_CurrentShader->Bind();
 
-			m_CurrentShader->Set("time", Renderer::GetTime());
-			m_CurrentShader->Set("deltaTime", Renderer::GetDeltaTime());
-			m_CurrentShader->Set("samples", (int)info.Pass->GetSamples());
-			m_CurrentShader->Set("resolution", vec2{ Renderer::GetResolution().x, Renderer::GetResolution().y });
-
-			camera.FillShader(m_CurrentShader);
+			m_CurrentShader->Set(SamplesUniform, (int)info.Pass->GetSamples());
+			LightClusters::FillSamplers(m_CurrentShader);
 		}
 
 		// Draw calls
@@ -67,15 +137,19 @@ void RenderPipeline::Draw(Camera& camera)
 			m_CurrentShader->Unbind();
 
 		m_CurrentShader = nullptr;
+		m_CurrentPass = nullptr;
 		info.Pass->Unbind();
 		m_PreviousPass = info.Pass;
 	}
+	m_CurrentCamera = nullptr;
 
-	if (camera.RenderTarget && !m_RenderPasses.empty())
-		m_RenderPasses[m_RenderPasses.size() - 1].Pass->CopyAttachmentTo(camera.RenderTarget);
+	if (camera.RenderTarget && m_PreviousPass)
+		m_PreviousPass->CopyAttachmentTo(camera.RenderTarget);
 	else if(m_PreviousPass)
 		m_PreviousPass->BlitTo(nullptr, GL_COLOR_BUFFER_BIT);
 	m_PreviousPass = nullptr;
+
+	m_LightClusters->Unbind();
 }
 
 void RenderPipeline::RemovePass(Framebuffer* pass)
@@ -85,6 +159,20 @@ void RenderPipeline::RemovePass(Framebuffer* pass)
 		if (m_RenderPasses[i].Pass == pass)
 		{
 			m_RenderPasses.erase(m_RenderPasses.begin() + i);
+			m_Graph.SetDirty();
+			break;
+		}
+	}
+}
+
+void RenderPipeline::RemovePass(const string& name)
+{
+	for (int i = (int)m_RenderPasses.size() - 1; i >= 0; i--)
+	{
+		if (m_RenderPasses[i].Name == name)
+		{
+			m_RenderPasses.erase(m_RenderPasses.begin() + i);
+			m_Graph.SetDirty();
 			break;
 		}
 	}
@@ -92,9 +180,10 @@ void RenderPipeline::RemovePass(Framebuffer* pass)
 
 void RenderPipeline::AddPass(RenderPipelinePass& passInfo)
 {
-	if (!passInfo.Pass)
+	if (!passInfo.Pass && passInfo.Writes.empty())
 		return;
 	m_RenderPasses.emplace_back(passInfo);
+	m_Graph.SetDirty();
 }
 
 Framebuffer* RenderPipeline::GetPassAt(unsigned int index)
@@ -116,18 +205,27 @@ RenderTexture* RenderPipeline::GetOutputAttachment(unsigned int index)
 		return nullptr;
 
 	Framebuffer* pass = m_RenderPasses[m_RenderPasses.size() - 1].Pass;
+	if (!pass)
+		return nullptr; // Render graph not yet compiled
 	index = std::clamp(index, 0u, pass->ColourAttachmentCount());
 	return pass->GetColourAttachment(index);
 }
 
 void RenderPipeline::OnResized(ivec2 resolution)
 {
+	// Render graph textures are recreated at the new resolution
 	for (RenderPipelinePass& pass : m_RenderPasses)
-		if (pass.ResizeWithScreen)
+		if (pass.ResizeWithScreen && pass.Writes.empty())
 			pass.Pass->SetResolution(resolution);
+	m_Graph.SetDirty();
 }
 
 Shader* RenderPipeline::CurrentShader() { return m_CurrentShader; }
+Camera* RenderPipeline::CurrentCamera() { return m_CurrentCamera; }
+Framebuffer* RenderPipeline::GetCurrentPass() { return m_CurrentPass; }
 Framebuffer* RenderPipeline::GetPreviousPass() { return m_PreviousPass; }
 ShadowMapPass* RenderPipeline::GetShadowMapPass() { return m_ShadowPass; }
+LightClusters* RenderPipeline::GetLightClusters() { return m_LightClusters; }
+OcclusionCulling* RenderPipeline::GetOcclusionCulling() { return m_OcclusionCulling; }
 Skybox* RenderPipeline::GetSkybox() { return m_Skybox; }
+RenderGraph& RenderPipeline::GetRenderGraph() { return m_Graph; }
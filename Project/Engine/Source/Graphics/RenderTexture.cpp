@@ -31,6 +31,10 @@ unsigned int GetChannelCount(TextureFormat format)
 	case TextureFormat::Depth24:
 	case TextureFormat::RedInteger:
 		return 1;
+	case TextureFormat::RG8:
+	case TextureFormat::RG16:
+	case TextureFormat::RG16F:
+		return 2;
 	case TextureFormat::RGB8:
 	case TextureFormat::Cubemap:
 		return 3;
@@ -51,6 +55,8 @@ GLenum Engine::Graphics::GetTextureTarget(TextureFormat target, bool multisample
 	case TextureFormat::RedInteger:
 		return GL_TEXTURE_1D;
 	case TextureFormat::RGB8:
+	case TextureFormat::RG8:
+	case TextureFormat::RG16:
 	case TextureFormat::RG16F:
 	case TextureFormat::RGBA8:
 	case TextureFormat::RGBA16:
@@ -75,6 +81,8 @@ GLenum Engine::Graphics::TextureFormatToInternalGLFormat(TextureFormat format)
 	default: return GL_INVALID_ENUM;
 	case TextureFormat::RGB8:		return GL_RGB8;
 	case TextureFormat::RedInteger:	return GL_R32I;
+	case TextureFormat::RG8:		return GL_RG8;
+	case TextureFormat::RG16:		return GL_RG16;
 	case TextureFormat::RG16F:		return GL_RG16F;
 	case TextureFormat::RGBA8:		return GL_RGBA8;
 	case TextureFormat::RGBA16:		return GL_RGBA16;
@@ -90,13 +98,15 @@ GLenum Engine::Graphics::TextureFormatToGLFormat(TextureFormat format)
 	switch (format)
 	{
 	default: return GL_INVALID_ENUM;
+	case TextureFormat::RG8:
+	case TextureFormat::RG16:
 	case TextureFormat::RG16F:			return GL_RG;
 	case TextureFormat::RGB8:			return GL_RGB;
 	case TextureFormat::RGBA8:
 	case TextureFormat::RGBA16F:		return GL_RGBA;
 	case TextureFormat::RedInteger:		return GL_RED_INTEGER;
-	case TextureFormat::Depth16:		return GL_DEPTH_COMPONENT;
-	case TextureFormat::Depth24:		return GL_DEPTH_COMPONENT24;
+	case TextureFormat::Depth16:
+	case TextureFormat::Depth24:		return GL_DEPTH_COMPONENT;
 	case TextureFormat::RenderBuffer:	return GL_DEPTH24_STENCIL8;
 	case TextureFormat::Cubemap:		return GL_RGB;
 	}
@@ -190,6 +200,8 @@ void RenderTexture::CreateColourTexture(void* data)
 	switch (m_Args.Format)
 	{
 	case TextureFormat::RGB8:
+	case TextureFormat::RG8:
+	case TextureFormat::RG16:
 	case TextureFormat::RG16F:
 	case TextureFormat::RGBA8:
 	case TextureFormat::RGBA16:
@@ -6,6 +6,7 @@
 #include <Engine/Components/Camera.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <Engine/Components/Transform.hpp>
+#include <Engine/Graphics/OcclusionCulling.hpp>
 
 using namespace std;
 using namespace glm;
@@ -13,6 +14,9 @@ using namespace Engine;
 using namespace Engine::Graphics;
 using namespace Engine::Components;
 
+constexpr UniformHandle ModelMatrixUniform("modelMatrix");
+constexpr UniformHandle InstancedUniform("instanced");
+
 Renderer* Renderer::s_Instance = nullptr;
 
 Renderer::Renderer() :
@@ -26,7 +30,11 @@ Renderer::Renderer() :
 	m_Wireframe(false),
 	m_Pipeline(nullptr),
 	m_MainCamera(nullptr),
-	m_SupportsTessellation(false)
+	m_Indirect(),
+	m_MeshBuffer(nullptr),
+	m_SupportsCompute(false),
+	m_SupportsTessellation(false),
+	m_SupportsMultiDrawIndirect(false)
 {
 	if (!s_Instance)
 		s_Instance = this;
@@ -48,6 +56,13 @@ Renderer::Renderer() :
 		}
 	}
 
+	// Compute shaders are core in OpenGL 4.3+
+	m_SupportsCompute = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3);
+
+	// Multi draw indirect is core in OpenGL 4.3+, base instance in 4.2+
+	m_SupportsMultiDrawIndirect = m_SupportsCompute;
+	m_MeshBuffer = new MeshBuffer();
+
 	// Get maximum sample count for multisampling
 	glGetIntegerv(GL_MAX_SAMPLES, &m_MaxSamples);
 
@@ -65,6 +80,8 @@ Renderer::Renderer() :
 
 Renderer::~Renderer()
 {
+	delete m_MeshBuffer;
+
 	if (s_Instance == this)
 		s_Instance = nullptr;
 }
@@ -85,6 +102,9 @@ Camera* Renderer::GetMainCamera() { return s_Instance->m_MainCamera; }
 RenderPipeline* Renderer::GetPipeline() { return s_Instance->m_Pipeline; }
 void Renderer::SetMainCamera(Camera* camera) { s_Instance->m_MainCamera = camera; }
 bool Renderer::SupportsTessellation() { return s_Instance->m_SupportsTessellation; }
+bool Renderer::SupportsCompute() { return s_Instance->m_SupportsCompute; }
+MeshBuffer* Renderer::GetMeshBuffer() { return s_Instance->m_MeshBuffer; }
+bool Renderer::SupportsMultiDrawIndirect() { return s_Instance->m_SupportsMultiDrawIndirect; }
 
 void Renderer::Shutdown()
 {
@@ -107,6 +127,226 @@ void Renderer::SortDrawQueue(DrawSortType sortType)
 		});
 }
 
+mat4 GetModelMatrix(DrawCall& drawCall)
+{
+	mat4 translationMatrix = translate(mat4(1.0f), drawCall.Position);
+	mat4 scaleMatrix = scale(mat4(1.0f), drawCall.Scale);
+	return translationMatrix * drawCall.Rotation * scaleMatrix;
+}
+
+/// <summary>
+/// World space axis aligned bounds of a mesh's local bounds transformed by modelMatrix
+/// </summary>
+void GetWorldBounds(mat4& modelMatrix, Mesh* mesh, vec3& outMin, vec3& outMax)
+{
+	vec3 centre = vec3(modelMatrix * vec4((mesh->GetBoundsMin() + mesh->GetBoundsMax()) * 0.5f, 1.0f));
+	vec3 extents = (mesh->GetBoundsMax() - mesh->GetBoundsMin()) * 0.5f;
+	vec3 worldExtents = abs(vec3(modelMatrix[0])) * extents.x +
+						abs(vec3(modelMatrix[1])) * extents.y +
+						abs(vec3(modelMatrix[2])) * extents.z;
+	outMin = centre - worldExtents;
+	outMax = centre + worldExtents;
+}
+
+/// <summary>
+/// Shared meshes drawn with a regular material can be drawn indirectly
+/// </summary>
+bool IsIndirectDraw(DrawCall& drawCall, Mesh* mesh, MaterialInstance* material)
+{
+	return mesh && material &&
+		mesh->IsShared() &&
+		!drawCall.DeleteMeshAfterRender &&
+		!material->IsWireframe();
+}
+
+void Renderer::RebuildIndirectCommands(vector<IndirectDrawKey>& keys)
+{
+	IndirectState& state = s_Instance->m_Indirect;
+	state.Keys = keys;
+	state.Groups.clear();
+	state.Commands.clear();
+	state.CommandMaterials.clear();
+	state.KeyCommands.resize(keys.size());
+
+	// Group keys with equivalent materials, preserving queue order inside each group
+	vector<vector<unsigned int>> groupKeys;
+	vector<MaterialInstance*> groupMaterials;
+	for (unsigned int i = 0; i < (unsigned int)keys.size(); i++)
+	{
+		MaterialInstance* material = ResourceManager::Get<MaterialInstance>(keys[i].Material);
+
+		unsigned int group = 0;
+		for (; group < (unsigned int)groupMaterials.size(); group++)
+			if (groupMaterials[group]->IsEquivalent(*material))
+				break;
+
+		if (group == (unsigned int)groupMaterials.size())
+		{
+			groupMaterials.emplace_back(material);
+			groupKeys.emplace_back();
+		}
+		groupKeys[group].emplace_back(i);
+	}
+
+	for (unsigned int group = 0; group < (unsigned int)groupKeys.size(); group++)
+	{
+		state.Groups.emplace_back(IndirectGroup
+		{
+			keys[groupKeys[group][0]].Material,
+			(unsigned int)state.Commands.size(),
+			(unsigned int)groupKeys[group].size()
+		});
+
+		for (unsigned int key : groupKeys[group])
+		{
+			Mesh::SharedAllocation& allocation = ResourceManager::Get<Mesh>(keys[key].Mesh)->GetSharedAllocation();
+			unsigned int command = (unsigned int)state.Commands.size();
+			state.KeyCommands[key] = command;
+			state.CommandMaterials.emplace_back(keys[key].Material);
+
+			// Base instance selects this command's model matrix
+			state.Commands.emplace_back(DrawElementsIndirectCommand
+			{
+				allocation.IndexCount,
+				1,
+				allocation.FirstIndex,
+				allocation.BaseVertex,
+				command
+			});
+		}
+	}
+
+	// Force matrices to be uploaded
+	state.Matrices.clear();
+}
+
+void Renderer::DrawIndirect(DrawArgs& args, Shader* shader)
+{
+	IndirectState& state = s_Instance->m_Indirect;
+
+	vector<IndirectDrawKey> keys;
+	vector<mat4> matrices;
+	vector<vec4> localSpheres;
+	vector<Mesh*> meshes;
+	for (DrawCall& drawCall : s_Instance->m_DrawQueue)
+	{
+		if (drawCall.Mesh == InvalidResourceID || drawCall.Material == InvalidResourceID)
+			continue;
+		Mesh* mesh = ResourceManager::Get<Mesh>(drawCall.Mesh);
+		MaterialInstance* material = ResourceManager::Get<MaterialInstance>(drawCall.Material);
+		if (!IsIndirectDraw(drawCall, mesh, material))
+			continue;
+
+		keys.emplace_back(IndirectDrawKey { drawCall.Mesh, drawCall.Material });
+		matrices.emplace_back(GetModelMatrix(drawCall));
+
+		vec3 centre = (mesh->GetBoundsMin() + mesh->GetBoundsMax()) * 0.5f;
+		localSpheres.emplace_back(vec4(centre, length(mesh->GetBoundsMax() - centre)));
+		meshes.emplace_back(mesh);
+	}
+
+	if (keys.empty())
+		return;
+
+	bool rebuild = keys != state.Keys;
+
+	// Materials may have been edited since grouping
+	for (unsigned int i = 0; i < (unsigned int)state.Groups.size() && !rebuild; i++)
+	{
+		IndirectGroup& group = state.Groups[i];
+		MaterialInstance* groupMaterial = ResourceManager::Get<MaterialInstance>(group.Material);
+		for (unsigned int j = 0; j < group.CommandCount && !rebuild; j++)
+			rebuild = !groupMaterial->IsEquivalent(*ResourceManager::Get<MaterialInstance>(state.CommandMaterials[group.FirstCommand + j]));
+	}
+
+	if (rebuild)
+		RebuildIndirectCommands(keys);
+
+	// Place model matrices at their command's base instance
+	vector<mat4> commandMatrices(matrices.size());
+	state.BoundingSpheres.resize(matrices.size());
+	state.BoundingBoxes.resize(matrices.size() * 2);
+	for (unsigned int i = 0; i < (unsigned int)keys.size(); i++)
+	{
+		unsigned int command = state.KeyCommands[i];
+		mat4& modelMatrix = commandMatrices[command] = matrices[i];
+
+		float maxScale = glm::max(length(vec3(modelMatrix[0])), glm::max(length(vec3(modelMatrix[1])), length(vec3(modelMatrix[2]))));
+		state.BoundingSpheres[command] = vec4(vec3(modelMatrix * vec4(vec3(localSpheres[i]), 1.0f)), localSpheres[i].w * maxScale);
+
+		vec3 boundsMin, boundsMax;
+		GetWorldBounds(modelMatrix, meshes[i], boundsMin, boundsMax);
+		state.BoundingBoxes[command * 2] = vec4(boundsMin, 1.0f);
+		state.BoundingBoxes[command * 2 + 1] = vec4(boundsMax, 1.0f);
+	}
+
+	if (commandMatrices != state.Matrices)
+	{
+		state.Matrices = commandMatrices;
+		s_Instance->m_MeshBuffer->SetInstances(state.Matrices);
+	}
+
+	// Frustum culling only changes instance counts, (left, right, bottom, top, near, far) planes
+	Camera* camera = s_Instance->m_Pipeline->CurrentCamera();
+	if (camera)
+	{
+		mat4 m = transpose(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+		vec4 planes[6] =
+		{
+			m[3] + m[0], m[3] - m[0],
+			m[3] + m[1], m[3] - m[1],
+			m[3] + m[2], m[3] - m[2]
+		};
+		for (vec4& plane : planes)
+			plane /= length(vec3(plane));
+
+		for (unsigned int i = 0; i < (unsigned int)state.Commands.size(); i++)
+		{
+			vec4& sphere = state.BoundingSpheres[i];
+			bool visible = true;
+			for (unsigned int p = 0; p < 6 && visible; p++)
+				visible = dot(vec3(planes[p]), vec3(sphere)) + planes[p].w >= -sphere.w;
+			state.Commands[i].InstanceCount = visible ? 1 : 0;
+		}
+	}
+	else
+		for (DrawElementsIndirectCommand& command : state.Commands)
+			command.InstanceCount = 1;
+
+	// Occlusion culling tests what is left against the previous frame's depth,
+	// on the CPU before commands are uploaded or on the GPU directly in the command buffer
+	OcclusionCulling* occlusion = s_Instance->m_Pipeline->GetOcclusionCulling();
+	bool occlusionCull = args.OcclusionCull && occlusion->IsReady(camera);
+	if (occlusionCull && !occlusion->GetComputeCulling())
+		for (unsigned int i = 0; i < (unsigned int)state.Commands.size(); i++)
+			if (state.Commands[i].InstanceCount > 0 &&
+				!occlusion->IsVisible(vec3(state.BoundingBoxes[i * 2]), vec3(state.BoundingBoxes[i * 2 + 1])))
+				state.Commands[i].InstanceCount = 0;
+
+	s_Instance->m_MeshBuffer->SetCommands(state.Commands);
+
+	if (occlusionCull && occlusion->GetComputeCulling())
+		occlusion->Cull(state.BoundingBoxes, s_Instance->m_MeshBuffer->GetCommandBuffer(), (unsigned int)state.Commands.size());
+
+	GLenum drawMode = shader->GetStages().TessellationEvaluate.empty() ? GL_TRIANGLES : GL_PATCHES;
+
+	shader->Set(InstancedUniform, true);
+	s_Instance->m_MeshBuffer->Bind();
+	for (IndirectGroup& group : state.Groups)
+	{
+		MaterialInstance* material = ResourceManager::Get<MaterialInstance>(group.Material);
+		if (!args.RenderOpaque && !material->IsTransparent())
+			continue;
+		if (!args.RenderTransparent && material->IsTransparent())
+			continue;
+
+		material->Bind();
+		s_Instance->m_MeshBuffer->DrawIndirect(drawMode, group.FirstCommand, group.CommandCount);
+	}
+	s_Instance->m_MeshBuffer->Unbind();
+	shader->Set(InstancedUniform, false);
+}
+
 void Renderer::Draw(DrawArgs args)
 {
 	SortDrawQueue(args.DrawSorting);
@@ -114,48 +354,81 @@ void Renderer::Draw(DrawArgs args)
 
 	glPolygonMode(GL_FRONT_AND_BACK, s_Instance->m_Wireframe ? GL_LINE : GL_FILL);
 
+	MaterialInstance::FillSamplers(shader);
+
+	// Indirect draws ignore queue order, so are only used when no sorting is requested.
+	// Shader must read model matrices from instance attributes when 'instanced' is set.
+	bool indirect = s_Instance->m_SupportsMultiDrawIndirect &&
+		args.DrawSorting == DrawSortType::None &&
+		shader && shader->GetUniformInfo(InstancedUniform);
+	if (indirect)
+		DrawIndirect(args, shader);
+
+	// Draw calls not drawn indirectly can only be occlusion culled on the CPU
+	OcclusionCulling* occlusion = s_Instance->m_Pipeline->GetOcclusionCulling();
+	bool occlusionCull = args.OcclusionCull &&
+		occlusion->IsReady(s_Instance->m_Pipeline->CurrentCamera()) &&
+		!occlusion->GetComputeCulling();
+
+	// Material uniforms & textures are only bound when changed between draw calls
+	MaterialInstance* boundMaterial = nullptr;
+
 	for (DrawCall& drawCall : s_Instance->m_DrawQueue)
 	{
-		if (drawCall.Mesh == InvalidResourceID)
+		if (drawCall.Mesh == InvalidResourceID || drawCall.Material == InvalidResourceID)
 			continue;
 		Mesh* mesh = ResourceManager::Get<Mesh>(drawCall.Mesh);
-		if (!mesh) continue;
+		MaterialInstance* materialInstance = ResourceManager::Get<MaterialInstance>(drawCall.Material);
+		if (!mesh || !materialInstance) continue;
+
+		if (indirect && IsIndirectDraw(drawCall, mesh, materialInstance))
+			continue;
 
-		if (!args.RenderOpaque && drawCall.Material.Albedo.a >= 1.0f)
+		if (!args.RenderOpaque && !materialInstance->IsTransparent())
 			continue;
-		if (!args.RenderTransparent && drawCall.Material.Albedo.a < 1.0f)
+		if (!args.RenderTransparent && materialInstance->IsTransparent())
 			continue;
 
-		// Generate model matrix
-		mat4 translationMatrix = translate(mat4(1.0f), drawCall.Position);
-		mat4 scaleMatrix = scale(mat4(1.0f), drawCall.Scale);
+		mat4 modelMatrix = GetModelMatrix(drawCall);
+		if (occlusionCull && !drawCall.DeleteMeshAfterRender)
+		{
+			vec3 boundsMin, boundsMax;
+			GetWorldBounds(modelMatrix, mesh, boundsMin, boundsMax);
+			if (!occlusion->IsVisible(boundsMin, boundsMax))
+				continue;
+		}
 
-		shader->Set("modelMatrix", translationMatrix * drawCall.Rotation * scaleMatrix);
+		shader->Set(ModelMatrixUniform, modelMatrix);
 
-		// Fill material values
-		drawCall.Material.FillShader(shader);
+		// Bind material values
+		if (materialInstance != boundMaterial || materialInstance->IsDirty())
+		{
+			materialInstance->Bind();
+			boundMaterial = materialInstance;
+		}
 
 		glLineWidth(drawCall.LineWidth);		
 
-		if(drawCall.Material.Wireframe && !s_Instance->m_Wireframe)
+		if(materialInstance->IsWireframe() && !s_Instance->m_Wireframe)
 			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 		mesh->Draw();
 
-		for (int i = 0; i < 5; i++)
-		{
-			// Unbind material textures
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
-
-		if(drawCall.Material.Wireframe && !s_Instance->m_Wireframe)
+		if(materialInstance->IsWireframe() && !s_Instance->m_Wireframe)
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 		if (drawCall.DeleteMeshAfterRender)
 			ResourceManager::Unload(drawCall.Mesh);
 	}
 
+	// Unbind material textures
+	for (int i = 0; i < 5; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 	if (args.ClearQueue)
@@ -184,15 +457,15 @@ void Renderer::Submit(ResourceID& mesh, Material& material, vec3 position, vec3
 	Submit(DrawCall
 		{
 			mesh,
-			material,
+			material.GetInstance(),
 			position,
 			scale,
 			rotation
 		});
 }
 
-
-void Renderer::Submit(ResourceID& mesh, Material& material, Components::Transform* transform)
+void Renderer::Submit(ResourceID& mesh, Material& material, Components::Transform* transform) { Submit(mesh, material.GetInstance(), transform); }
+void Renderer::Submit(ResourceID& mesh, ResourceID material, Components::Transform* transform)
 {
 	Submit(DrawCall
 		{
@@ -18,6 +18,16 @@ using namespace Engine::Graphics;
 
 const unsigned int MaxIncludeRecursion = 5;
 
+// Uniform block names, as declared in shader source, and the binding point they are attached to
+const vector<pair<string, UniformBlockBinding>> UniformBlocks =
+{
+	{ "MaterialData",	UniformBlockBinding::Material },
+	{ "FrameData",		UniformBlockBinding::Frame },
+	{ "CameraData",		UniformBlockBinding::Camera },
+	{ "LightData",		UniformBlockBinding::Lights },
+	{ "EnvironmentData", UniformBlockBinding::Environment }
+};
+
 void ReplaceAll(string& text, string search, string replacement)
 {
 	// regex expression for pattern to be searched
@@ -217,7 +227,10 @@ void Shader::CreateShaders()
 	WatchShader(m_ShaderStages.TessellationControl);
 	WatchShader(m_ShaderStages.TessellationEvaluate);
 
-	const bool invalidShaders = shaders.size() == 0 || shaders[0] == GL_INVALID_VALUE || shaders[1] == GL_INVALID_VALUE;
+	// Compute programs only need a compute stage, otherwise vertex & fragment stages are required
+	const bool invalidShaders = m_ShaderStages.ComputePath.empty() ?
+		(shaders[0] == GL_INVALID_VALUE || shaders[1] == GL_INVALID_VALUE) :
+		shaders[2] == GL_INVALID_VALUE;
 	programID = invalidShaders ? GL_INVALID_VALUE : glCreateProgram();
 
 	for (GLuint shader : shaders)
@@ -268,6 +281,7 @@ void Shader::CreateShaders()
 	m_Program = programID;
 
 	CacheUniformLocations();
+	BindUniformBlocks();
 
 	Log::Debug("Created shader program successfully [" + to_string(m_Program) + "]");
 }
@@ -282,6 +296,7 @@ void Shader::CacheUniformLocations()
 
 	m_NamedUniforms.clear();
 	m_NamedUniforms.reserve(uniformCount);
+	m_HandleLocations.fill({});
 
 	for (GLuint i = 0; i < (GLuint)uniformCount; i++)
 	{
@@ -293,11 +308,9 @@ void Shader::CacheUniformLocations()
 		GLint size;
 		glGetActiveUniform(m_Program, i, nameLength, &nameLength, &size, &m_Uniforms[i].Type, m_Uniforms[i].Name.data());
 
-#if USE_STRING_ID
-		m_NamedUniforms.emplace(make_pair(StringId(m_Uniforms[i].Name.c_str()).GetValue(), &m_Uniforms[i]));
-#else
-		m_NamedUniforms.emplace(make_pair(m_Uniforms[i].Name, &m_Uniforms[i]));
-#endif
+		uint64_t hash = HashUniformName(m_Uniforms[i].Name.c_str());
+		if (!m_NamedUniforms.emplace(make_pair(hash, &m_Uniforms[i])).second)
+			Log::Warning("Shader uniform '" + m_Uniforms[i].Name + "' has the same name hash as '" + m_NamedUniforms[hash]->Name + "'");
 
 		m_Uniforms[i].Location = glGetUniformLocation(m_Program, m_Uniforms[i].Name.c_str());
 
@@ -307,6 +320,16 @@ void Shader::CacheUniformLocations()
 	Log::Debug("Cached " + to_string(uniformCount) + " shader uniforms");
 }
 
+void Shader::BindUniformBlocks()
+{
+	for (auto& block : UniformBlocks)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(m_Program, block.first.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(m_Program, blockIndex, (GLuint)block.second);
+	}
+}
+
 void Shader::Bind()
 {
 	if (m_IsDirty)
@@ -337,15 +360,25 @@ void Shader::Set(int& location, vec4 value)   const { if (m_Program != GL_INVALI
 void Shader::Set(int& location, mat3 value)   const { if (m_Program != GL_INVALID_VALUE) glProgramUniformMatrix3fv(m_Program, location, 1, GL_FALSE, value_ptr(value)); }
 void Shader::Set(int& location, mat4 value)   const { if (m_Program != GL_INVALID_VALUE) glProgramUniformMatrix4fv(m_Program, location, 1, GL_FALSE, value_ptr(value)); }
 
-void Shader::Set(string locationName, int value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, bool value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, float value)  { ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, double value) { ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, vec2 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, vec3 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, vec4 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, mat3 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
-void Shader::Set(string locationName, mat4 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, int value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, bool value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, float value)  { ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, double value) { ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, vec2 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, vec3 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, vec4 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, mat3 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+void Shader::Set(const string& locationName, mat4 value)	{ ShaderUniform* uniform = GetUniformInfo(locationName); if(uniform) Set(uniform->Location, value); }
+
+void Shader::Set(const UniformHandle& handle, int value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, bool value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, float value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, double value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, vec2 value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, vec3 value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, vec4 value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, mat3 value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
+void Shader::Set(const UniformHandle& handle, mat4 value)	{ int& location = GetLocation(handle); if(location >= 0) Set(location, value); }
 
 ShaderUniform* Shader::GetUniformInfo(int location)
 {
@@ -353,14 +386,27 @@ ShaderUniform* Shader::GetUniformInfo(int location)
 	return (location >= 0 && location < m_Uniforms.size() - 1 ? &m_Uniforms[location] : nullptr);
 }
 
-ShaderUniform* Shader::GetUniformInfo(std::string& locationName)
+ShaderUniform* Shader::GetUniformInfo(const std::string& locationName)
 {
-	auto& it = m_NamedUniforms.find(
-#if USE_STRING_ID
-		StringId(locationName.c_str()).GetValue()
-#else
-		locationName
-#endif
-	);
+	auto it = m_NamedUniforms.find(HashUniformName(locationName.c_str()));
+	return it != m_NamedUniforms.end() ? it->second : nullptr;
+}
+
+int& Shader::GetLocation(const UniformHandle& handle)
+{
+	// Colliding handles replace each other, falling back to the map lookup
+	CachedLocation& cached = m_HandleLocations[handle.Hash % m_HandleLocations.size()];
+	if (cached.Hash != handle.Hash)
+	{
+		ShaderUniform* uniform = GetUniformInfo(handle);
+		cached.Hash = handle.Hash;
+		cached.Location = uniform ? uniform->Location : -1;
+	}
+	return cached.Location;
+}
+
+ShaderUniform* Shader::GetUniformInfo(const UniformHandle& handle)
+{
+	auto it = m_NamedUniforms.find(handle.Hash);
 	return it != m_NamedUniforms.end() ? it->second : nullptr;
 }
@@ -0,0 +1,105 @@
+#include <Engine/Graphics/ShadowAtlas.hpp>
+
+using namespace glm;
+using namespace std;
+using namespace Engine::Graphics;
+
+ShadowAtlas::ShadowAtlas(unsigned int size, unsigned int minTileSize) : m_Size(size), m_MinTileSize(minTileSize), m_Nodes()
+{
+	Reset(size);
+}
+
+unsigned int ShadowAtlas::GetSize() { return m_Size; }
+unsigned int ShadowAtlas::GetMinTileSize() { return m_MinTileSize; }
+
+void ShadowAtlas::Reset(unsigned int size)
+{
+	// Largest power of two fitting in size
+	m_Size = 1;
+	while (m_Size * 2 <= size)
+		m_Size *= 2;
+	Clear();
+}
+
+void ShadowAtlas::Clear()
+{
+	m_Nodes.clear();
+	m_Nodes.emplace_back(Node { ivec2(0), m_Size });
+}
+
+unsigned int ShadowAtlas::GetTileSize(unsigned int size)
+{
+	unsigned int tileSize = glm::min(m_MinTileSize, m_Size);
+	while (tileSize < size && tileSize < m_Size)
+		tileSize *= 2;
+	return tileSize;
+}
+
+bool ShadowAtlas::Allocate(unsigned int size, ivec4& outTile)
+{
+	if (size > m_Size)
+		return false;
+	return Allocate(0, GetTileSize(size), outTile);
+}
+
+bool ShadowAtlas::Allocate(unsigned int nodeIndex, unsigned int size, ivec4& outTile)
+{
+	// Copy, m_Nodes may be resized below
+	Node node = m_Nodes[nodeIndex];
+	if (node.Used || node.Size < size)
+		return false;
+
+	if (node.Children < 0)
+	{
+		if (node.Size == size)
+		{
+			m_Nodes[nodeIndex].Used = true;
+			outTile = ivec4(node.Offset, size, size);
+			return true;
+		}
+
+		// Split into quadrants
+		int children = (int)m_Nodes.size();
+		unsigned int half = node.Size / 2;
+		for (unsigned int i = 0; i < 4; i++)
+			m_Nodes.emplace_back(Node { node.Offset + ivec2(i % 2, i / 2) * (int)half, half });
+		m_Nodes[nodeIndex].Children = node.Children = children;
+	}
+
+	for (int i = 0; i < 4; i++)
+		if (Allocate(node.Children + i, size, outTile))
+			return true;
+	return false;
+}
+
+void ShadowAtlas::Free(const ivec4& tile) { Free(0, tile); }
+
+bool ShadowAtlas::Free(unsigned int nodeIndex, const ivec4& tile)
+{
+	Node& node = m_Nodes[nodeIndex];
+	ivec2 offset = ivec2(tile.x, tile.y) - node.Offset;
+	if (offset.x < 0 || offset.y < 0 || offset.x >= (int)node.Size || offset.y >= (int)node.Size)
+		return false;
+
+	if (node.Children < 0)
+	{
+		if (!node.Used || node.Offset != ivec2(tile.x, tile.y) || node.Size != (unsigned int)tile.z)
+			return false;
+		node.Used = false;
+		return true;
+	}
+
+	int children = node.Children;
+	bool freed = false;
+	for (int i = 0; i < 4 && !freed; i++)
+		freed = Free(children + i, tile);
+	if (!freed)
+		return false;
+
+	// Merge back into a single free node, unused child nodes are discarded on the next Clear
+	for (int i = 0; i < 4; i++)
+		if (m_Nodes[children + i].Used || m_Nodes[children + i].Children >= 0)
+			return true;
+	m_Nodes[nodeIndex].Children = -1;
+	return true;
+}
\ No newline at end of file
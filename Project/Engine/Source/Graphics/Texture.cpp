@@ -1,104 +1,492 @@
 #define STB_IMAGE_IMPLEMENTATION
 
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <glad/glad.h>
 #include <stb_image.h>
 #include <Engine/Log.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
 #include <Engine/Graphics/Texture.hpp>
+#include <Engine/Graphics/TextureCache.hpp>
+#include <Engine/Graphics/Renderer.hpp>
 
 using namespace std;
 using namespace Engine;
+using namespace Engine::Jobs;
 using namespace Engine::Graphics;
 
-Texture::Texture() : m_Path(""), m_ID(GL_INVALID_VALUE), m_Args() { }
-Texture::Texture(string path, TextureArgs args) : m_Path(path), m_ID(GL_INVALID_VALUE), m_Args(args) { }
+// Cooked block compressed textures are stored beside their source
+const string TextureCacheExtension = ".tex.cache";
 
-Texture::~Texture()
-{
-	if (m_ID != GL_INVALID_VALUE)
-		glDeleteTextures(1, &m_ID);
-}
+unsigned int Texture::s_Frame = 0;
+vector<Texture*> Texture::s_Textures = {};
+vector<Texture*> Texture::s_Streaming = {};
 
-void Texture::GenerateImage()
+struct Texture::DecodeState
 {
-	if (m_Path.empty())
-	{
-		Log::Warning("Cannot generate texture with empty path");
-		return;
-	}
+	JobHandle Job;
 
-	// Read image data
-	int width, height, channelCount;
-	void* data = nullptr;
-	
-	stbi_set_flip_vertically_on_load(m_Args.FlipVertically);
-	// Load image data from file
-	if(!m_Args.HDR)
-		data = stbi_load(m_Path.c_str(), &width, &height, &channelCount, 0);
-	else
-		data = stbi_loadf(m_Path.c_str(), &width, &height, &channelCount, 0);
+	void* Pixels = nullptr;
+	int Width = 0, Height = 0, ChannelCount = 0;
+	string Error = "";
 
-	// Check for validity
-	if (!data)
-	{
-		// Release resources, these are now stored inside OpenGL's texture buffer
-		stbi_image_free(data);
+	/// <summary>
+	/// Block compressed mip chain, uploaded instead of Pixels when open
+	/// </summary>
+	TextureCache Cache;
 
-		Log::Warning("Failed to load '" + m_Path + "' - " + stbi_failure_reason());
-		return;
+	void FreePixels()
+	{
+		if (Pixels)
+			stbi_image_free(Pixels);
+		Pixels = nullptr;
 	}
 
-	// Generate texture ID
-	glGenTextures(1, &m_ID);
-	// Set as 2D Texture
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	~DecodeState() { FreePixels(); }
+};
 
-	// Set texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_Args.Wrap);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_Args.Wrap);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_Args.MinFilter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_Args.MagFilter);
+/// <summary>
+/// Swaps rows in place, stbi_set_flip_vertically_on_load is global state shared by all threads
+/// </summary>
+void FlipRows(unsigned char* pixels, size_t rowSize, int height)
+{
+	vector<unsigned char> temp(rowSize);
+	for (int top = 0, bottom = height - 1; top < bottom; top++, bottom--)
+	{
+		unsigned char* topRow = pixels + top * rowSize;
+		unsigned char* bottomRow = pixels + bottom * rowSize;
+		memcpy(temp.data(), topRow, rowSize);
+		memcpy(topRow, bottomRow, rowSize);
+		memcpy(bottomRow, temp.data(), rowSize);
+	}
+}
 
-	// Get texture format based on channels
-	GLenum internalFormat = GL_INVALID_ENUM, textureFormat = GL_INVALID_ENUM;
+void GetTextureFormat(int channelCount, bool hdr, GLenum& internalFormat, GLenum& textureFormat)
+{
+	internalFormat = textureFormat = GL_INVALID_ENUM;
 	switch (channelCount)
 	{
 	case 1:
 		textureFormat = GL_RED;
-		internalFormat = m_Args.HDR ? GL_R16F : GL_RED;
+		internalFormat = hdr ? GL_R16F : GL_RED;
+		break;
+	case 2:
+		textureFormat = GL_RG;
+		internalFormat = hdr ? GL_RG16F : GL_RG;
 		break;
 	case 3:
 		textureFormat = GL_RGB;
-		internalFormat = m_Args.HDR ? GL_RGB16F : GL_RGB;
+		internalFormat = hdr ? GL_RGB16F : GL_RGB;
 		break;
 	case 4:
 		textureFormat = GL_RGBA;
-		internalFormat = m_Args.HDR ? GL_RGBA16F : GL_RGBA;
+		internalFormat = hdr ? GL_RGBA16F : GL_RGBA;
 		break;
 	}
+}
+
+Texture::Texture() :
+	m_Path(""),
+	m_ID(GL_INVALID_VALUE),
+	m_Args(),
+	m_Failed(false),
+	m_Streaming(false),
+	m_UploadID(GL_INVALID_VALUE),
+	m_PixelBuffer(GL_INVALID_VALUE),
+	m_UploadProgress(0),
+	m_UploadFence(nullptr),
+	m_ResidentLevel(0),
+	m_TargetLevel(0),
+	m_ResidentSize(0),
+	m_LastUsedFrame(0),
+	m_RequestCount(0),
+	m_RequestedFrame(0),
+	m_RequestedLevel(0) { }
+
+Texture::Texture(string path, TextureArgs args) : Texture()
+{
+	m_Path = path;
+	m_Args = args;
+
+	if (m_Path.empty())
+	{
+		Log::Warning("Cannot generate texture with empty path");
+		m_Failed = true;
+		return;
+	}
+
+	s_Textures.emplace_back(this);
+	BeginDecode();
+}
+
+Texture::~Texture()
+{
+	if (!m_Path.empty())
+		s_Textures.erase(find(s_Textures.begin(), s_Textures.end(), this));
+
+	// Decoding job keeps its own reference to the decode state
+	if (m_Streaming)
+		s_Streaming.erase(find(s_Streaming.begin(), s_Streaming.end(), this));
+
+	if (m_UploadFence)
+		glDeleteSync(m_UploadFence);
+	if (m_PixelBuffer != GL_INVALID_VALUE)
+		glDeleteBuffers(1, &m_PixelBuffer);
+	if (m_UploadID != GL_INVALID_VALUE)
+		glDeleteTextures(1, &m_UploadID);
+	if (m_ID != GL_INVALID_VALUE)
+		glDeleteTextures(1, &m_ID);
+}
+
+void Texture::BeginDecode()
+{
+	m_Decode = make_shared<DecodeState>();
+	m_Streaming = true;
+	m_TargetLevel = 0;
+	s_Streaming.emplace_back(this);
+
+	shared_ptr<DecodeState> decode = m_Decode;
+	string path = m_Path;
+	TextureArgs args = m_Args;
+	m_Decode->Job = JobSystem::Submit([decode, path, args]()
+	{
+		// Prefer the cooked texture, skipping decoding & mipmap generation
+		bool compress = args.Compress && !args.HDR;
+		string cachePath = path + TextureCacheExtension;
+		if (compress && decode->Cache.Open(cachePath, path, args.FlipVertically, args.NormalMap))
+			return;
+
+		// Load image data from file
+		if (!args.HDR)
+			decode->Pixels = stbi_load(path.c_str(), &decode->Width, &decode->Height, &decode->ChannelCount, 0);
+		else
+			decode->Pixels = stbi_loadf(path.c_str(), &decode->Width, &decode->Height, &decode->ChannelCount, 0);
+
+		if (!decode->Pixels)
+		{
+			decode->Error = stbi_failure_reason();
+			return;
+		}
+
+		if (args.FlipVertically)
+			FlipRows(
+				(unsigned char*)decode->Pixels,
+				(size_t)decode->Width * decode->ChannelCount * (args.HDR ? sizeof(float) : sizeof(unsigned char)),
+				decode->Height
+			);
+
+		if (compress && decode->Cache.Cook(
+				(const unsigned char*)decode->Pixels,
+				(unsigned int)decode->Width,
+				(unsigned int)decode->Height,
+				(unsigned int)decode->ChannelCount,
+				path,
+				args.FlipVertically,
+				args.NormalMap))
+		{
+			decode->FreePixels();
+			decode->Cache.Save(cachePath);
+		}
+	});
+}
+
+void Texture::BeginUpload(unsigned int level)
+{
+	m_TargetLevel = level;
+	if (m_Streaming)
+		return; // Level is read when the upload starts
+
+	m_Streaming = true;
+	s_Streaming.emplace_back(this);
+}
+
+bool Texture::ContinueUpload(size_t& byteBudget)
+{
+	DecodeState& decode = *m_Decode;
+	if (!decode.Pixels && !decode.Cache.IsOpen())
+	{
+		Log::Warning("Failed to load '" + m_Path + "' - " + decode.Error);
+		m_Decode.reset();
+		m_Failed = true;
+		return true;
+	}
 
-	// Fill OpenGL texture data with binary data
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, textureFormat, m_Args.HDR ? GL_FLOAT : GL_UNSIGNED_BYTE, data);
+	// All data transferred, finished once the pixel buffer has been read
+	if (m_UploadFence)
+	{
+		if (glClientWaitSync(m_UploadFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return false;
+		FinishUpload();
+		return true;
+	}
 
-	// Release resources, these are now stored inside OpenGL's texture buffer
-	stbi_image_free(data);
+	if (m_UploadID == GL_INVALID_VALUE)
+	{
+		glGenTextures(1, &m_UploadID);
+		glBindTexture(GL_TEXTURE_2D, m_UploadID);
 
-	// Generate mipmaps
-	glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_Args.Wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_Args.Wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_Args.MinFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_Args.MagFilter);
+
+		size_t pixelBufferSize = 0;
+		if (decode.Cache.IsOpen())
+		{
+			m_TargetLevel = std::min(m_TargetLevel, decode.Cache.GetMipCount() - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, decode.Cache.GetMipCount() - m_TargetLevel - 1);
+
+			m_UploadProgress = m_TargetLevel;
+			pixelBufferSize = decode.Cache.GetSize() - (size_t)decode.Cache.GetLevel(m_TargetLevel).Offset;
+		}
+		else
+		{
+			// Allocate storage, filled from the pixel buffer
+			GLenum internalFormat, textureFormat;
+			GetTextureFormat(decode.ChannelCount, m_Args.HDR, internalFormat, textureFormat);
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, decode.Width, decode.Height, 0, textureFormat, m_Args.HDR ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+
+			m_TargetLevel = m_UploadProgress = 0;
+			pixelBufferSize = (size_t)decode.Width * decode.Height * decode.ChannelCount * (m_Args.HDR ? sizeof(float) : sizeof(unsigned char));
+		}
+
+		glGenBuffers(1, &m_PixelBuffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, pixelBufferSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_UploadID);
+	bool uploaded = decode.Cache.IsOpen() ? UploadLevels(byteBudget) : UploadRows(byteBudget);
 	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (uploaded)
+		m_UploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	return false;
+}
+
+const void* Texture::StagePixels(const unsigned char* data, size_t offset, size_t size)
+{
+	// Ranges are only written once so the driver need not wait on previous transfers
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!mapped)
+	{
+		// Fall back to a synchronous upload from client memory
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return data;
+	}
+
+	memcpy(mapped, data, size);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	return (const void*)offset;
+}
+
+bool Texture::UploadRows(size_t& byteBudget)
+{
+	DecodeState& decode = *m_Decode;
+
+	GLenum internalFormat, textureFormat;
+	GetTextureFormat(decode.ChannelCount, m_Args.HDR, internalFormat, textureFormat);
+	size_t rowSize = (size_t)decode.Width * decode.ChannelCount * (m_Args.HDR ? sizeof(float) : sizeof(unsigned char));
+
+	// Always upload at least one row so large textures still progress
+	size_t remainingRows = (size_t)decode.Height - m_UploadProgress;
+	unsigned int rowCount = (unsigned int)std::min(std::max<size_t>(byteBudget / rowSize, 1), remainingRows);
+	size_t offset = m_UploadProgress * rowSize;
+	size_t size = rowCount * rowSize;
+
+	// Reads from the bound pixel buffer at offset, returning before the transfer completes.
+	// Rows of 1 & 3 channel images are not always 4 byte aligned.
+	const void* source = StagePixels((const unsigned char*)decode.Pixels + offset, offset, size);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_UploadProgress, decode.Width, rowCount, textureFormat, m_Args.HDR ? GL_FLOAT : GL_UNSIGNED_BYTE, source);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	m_UploadProgress += rowCount;
+	byteBudget -= std::min(byteBudget, size);
+	return m_UploadProgress >= (unsigned int)decode.Height;
+}
+
+bool Texture::UploadLevels(size_t& byteBudget)
+{
+	TextureCache& cache = m_Decode->Cache;
+	GLenum internalFormat = TextureCache::GetInternalFormat(cache.GetFormat());
+	uint64_t firstOffset = cache.GetLevel(m_TargetLevel).Offset;
+
+	// Smallest levels are last, at least one level is uploaded per call
+	do
+	{
+		const TextureCache::MipLevel& level = cache.GetLevel(m_UploadProgress);
+		const void* source = StagePixels(cache.GetData() + level.Offset, (size_t)(level.Offset - firstOffset), (size_t)level.Size);
+		glCompressedTexImage2D(
+			GL_TEXTURE_2D,
+			m_UploadProgress - m_TargetLevel,
+			internalFormat,
+			level.Width,
+			level.Height,
+			0,
+			(GLsizei)level.Size,
+			source
+		);
+
+		m_UploadProgress++;
+		byteBudget -= std::min(byteBudget, (size_t)level.Size);
+	} while (byteBudget > 0 && m_UploadProgress < cache.GetMipCount());
+
+	return m_UploadProgress >= cache.GetMipCount();
+}
+
+void Texture::FinishUpload()
+{
+	glDeleteSync(m_UploadFence);
+	m_UploadFence = nullptr;
+
+	glDeleteBuffers(1, &m_PixelBuffer);
+	m_PixelBuffer = GL_INVALID_VALUE;
+
+	// Cooked textures include their mip chain
+	if (!IsCooked())
+	{
+		glBindTexture(GL_TEXTURE_2D, m_UploadID);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// Replace the previously resident levels
+	if (m_ID != GL_INVALID_VALUE)
+		glDeleteTextures(1, &m_ID);
+	m_ID = m_UploadID;
+	m_UploadID = GL_INVALID_VALUE;
+	m_UploadProgress = 0;
+
+	m_ResidentLevel = m_TargetLevel;
+	m_ResidentSize = GetSize(m_ResidentLevel);
+	m_Streaming = false;
+
+	// Release decoded pixels, these are now stored inside OpenGL's texture.
+	// Cooked textures keep their mapped cache to upload other levels from later.
+	if (!IsCooked())
+		m_Decode.reset();
+}
+
+void Texture::Evict()
+{
+	if (m_Streaming)
+		return; // Only resident textures are evicted
+
+	if (m_ID != GL_INVALID_VALUE)
+		glDeleteTextures(1, &m_ID);
+	m_ID = GL_INVALID_VALUE;
+	m_ResidentSize = 0;
+	m_ResidentLevel = 0;
+	m_Decode.reset();
+}
+
+bool Texture::IsCooked() { return m_Decode && m_Decode->Job.IsComplete() && m_Decode->Cache.IsOpen(); }
+unsigned int Texture::GetMipCount() { return IsCooked() ? m_Decode->Cache.GetMipCount() : 1; }
+
+unsigned int Texture::GetLevelResolution(unsigned int level)
+{
+	if (!IsCooked())
+		return 0;
+	const TextureCache::MipLevel& mip = m_Decode->Cache.GetLevel(std::min(level, GetMipCount() - 1));
+	return std::max(mip.Width, mip.Height);
+}
+
+size_t Texture::GetSize(unsigned int level)
+{
+	if (IsCooked())
+	{
+		TextureCache& cache = m_Decode->Cache;
+		size_t size = 0;
+		for (unsigned int i = level; i < cache.GetMipCount(); i++)
+			size += (size_t)cache.GetLevel(i).Size;
+		return size;
+	}
+
+	if (!m_Decode || !m_Decode->Pixels)
+		return m_ResidentSize;
+
+	// Drivers pad 3 channels to 4, mips add a third
+	size_t channelSize = m_Args.HDR ? 2 : 1; // 16-bit float or 8-bit unsigned formats
+	size_t pixelSize = (m_Decode->ChannelCount == 3 ? 4 : m_Decode->ChannelCount) * channelSize;
+	return (size_t)m_Decode->Width * m_Decode->Height * pixelSize * 4 / 3;
+}
+
+void Texture::UpdateStreaming(size_t byteBudget)
+{
+	s_Frame++;
+
+	vector<Texture*> queue;
+	for (Texture* texture : s_Streaming)
+		if (texture->m_Decode->Job.IsComplete())
+			queue.emplace_back(texture);
+
+	// Finish partial uploads first, then textures that are not resident,
+	// then those bound most recently & most often
+	sort(queue.begin(), queue.end(), [](Texture* a, Texture* b)
+	{
+		bool aStarted = a->m_UploadID != GL_INVALID_VALUE, bStarted = b->m_UploadID != GL_INVALID_VALUE;
+		if (aStarted != bStarted)
+			return aStarted;
+		bool aMissing = a->m_ID == GL_INVALID_VALUE, bMissing = b->m_ID == GL_INVALID_VALUE;
+		if (aMissing != bMissing)
+			return aMissing;
+		if (a->m_LastUsedFrame != b->m_LastUsedFrame)
+			return a->m_LastUsedFrame > b->m_LastUsedFrame;
+		return a->m_RequestCount > b->m_RequestCount;
+	});
+
+	for (Texture* texture : queue)
+	{
+		if (texture->ContinueUpload(byteBudget))
+		{
+			texture->m_Streaming = false;
+			s_Streaming.erase(find(s_Streaming.begin(), s_Streaming.end(), texture));
+		}
+		if (byteBudget == 0)
+			break;
+	}
+}
+
+void Texture::Wait()
+{
+	if (!m_Streaming)
+		return; // Already uploaded or failed
+
+	m_Decode->Job.Wait();
+
+	size_t byteBudget = SIZE_MAX;
+	while (!ContinueUpload(byteBudget))
+	{
+		if (m_UploadFence)
+			glClientWaitSync(m_UploadFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		byteBudget = SIZE_MAX;
+	}
+	m_Streaming = false;
+	s_Streaming.erase(find(s_Streaming.begin(), s_Streaming.end(), this));
 }
 
 string Texture::GetPath() { return m_Path; }
 unsigned int Texture::GetID() { return m_ID; }
+bool Texture::IsReady() { return m_ID != GL_INVALID_VALUE; }
 
 void Texture::Bind(unsigned int index)
 {
+	m_LastUsedFrame = s_Frame;
 	if (m_ID == GL_INVALID_VALUE)
 	{
-		if (!m_Path.empty())
-			GenerateImage();
-		if(m_ID == GL_INVALID_VALUE)
-			return; // Double check
+		m_RequestCount++;
+
+		// Evicted, stream back in
+		if (!m_Streaming && !m_Failed && !m_Path.empty())
+			BeginDecode();
+
+		Renderer::GetEmptyTexture()->Bind(index);
+		return;
 	}
 	glActiveTexture(GL_TEXTURE0 + index);
 	glBindTexture(GL_TEXTURE_2D, m_ID);
-}
+}
\ No newline at end of file
@@ -0,0 +1,413 @@
+#define STB_DXT_IMPLEMENTATION
+
+#include <cmath>
+#include <mutex>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <stb_dxt.h>
+#include <Engine/Log.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+#include <Engine/Graphics/TextureCache.hpp>
+
+using namespace std;
+using namespace Engine;
+using namespace Engine::Jobs;
+using namespace Engine::Graphics;
+
+namespace fs = std::filesystem;
+
+// Part of EXT_texture_compression_s3tc, supported by all desktop drivers but not core
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// "TEXC" when read as bytes
+const uint32_t TextureCacheMagic = 0x43584554;
+
+// Mip level alignment within the file
+const uint64_t LevelAlignment = 16;
+
+// Maximum 4x4 block rows compressed by a single job
+const unsigned int BlockRowsPerJob = 4;
+
+uint64_t AlignLevel(uint64_t offset) { return (offset + LevelAlignment - 1) & ~(LevelAlignment - 1); }
+
+/// <summary>
+/// Averages each 2x2 square of pixels, odd edges repeat the last row or column
+/// </summary>
+vector<unsigned char> Downsample(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channelCount)
+{
+	unsigned int newWidth = std::max(width / 2, 1u);
+	unsigned int newHeight = std::max(height / 2, 1u);
+	vector<unsigned char> output((size_t)newWidth * newHeight * channelCount);
+
+	for (unsigned int y = 0; y < newHeight; y++)
+	{
+		unsigned int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (unsigned int x = 0; x < newWidth; x++)
+		{
+			unsigned int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (unsigned int c = 0; c < channelCount; c++)
+			{
+				unsigned int sum =
+					pixels[((size_t)y0 * width + x0) * channelCount + c] +
+					pixels[((size_t)y0 * width + x1) * channelCount + c] +
+					pixels[((size_t)y1 * width + x0) * channelCount + c] +
+					pixels[((size_t)y1 * width + x1) * channelCount + c];
+				output[((size_t)y * newWidth + x) * channelCount + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+	return output;
+}
+
+/// <summary>
+/// Rescales the first three channels of each pixel to a unit length normal, averaging shortens normals in lower mips
+/// </summary>
+void RenormaliseNormals(vector<unsigned char>& pixels, unsigned int channelCount)
+{
+	for (size_t i = 0; i + 2 < pixels.size(); i += channelCount)
+	{
+		float normal[3];
+		for (unsigned int c = 0; c < 3; c++)
+			normal[c] = pixels[i + c] / 127.5f - 1.0f;
+
+		float length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length <= 0.0f)
+			continue;
+
+		for (unsigned int c = 0; c < 3; c++)
+			pixels[i + c] = (unsigned char)std::clamp(std::round((normal[c] / length * 0.5f + 0.5f) * 255.0f), 0.0f, 255.0f);
+	}
+}
+
+/// <summary>
+/// Gathers a 4x4 block in the layout expected by stb_dxt, edge pixels are repeated past the image bounds
+/// </summary>
+void FetchBlock(
+	const unsigned char* pixels,
+	unsigned int width,
+	unsigned int height,
+	unsigned int channelCount,
+	unsigned int blockX,
+	unsigned int blockY,
+	unsigned int outputChannels,
+	unsigned char* output)
+{
+	for (unsigned int y = 0; y < 4; y++)
+	{
+		unsigned int sourceY = std::min(blockY * 4 + y, height - 1);
+		for (unsigned int x = 0; x < 4; x++)
+		{
+			unsigned int sourceX = std::min(blockX * 4 + x, width - 1);
+			const unsigned char* pixel = pixels + ((size_t)sourceY * width + sourceX) * channelCount;
+			unsigned char* out = output + (y * 4 + x) * outputChannels;
+			for (unsigned int c = 0; c < outputChannels; c++)
+				out[c] = c < channelCount ? pixel[c] : 255;
+
+			// Expand greyscale to RGB
+			if (channelCount == 1 && outputChannels >= 3)
+				out[1] = out[2] = pixel[0];
+		}
+	}
+}
+
+TextureCache::TextureCache() :
+	m_File(),
+	m_Memory(),
+	m_Data(nullptr),
+	m_Size(0),
+	m_Header(nullptr),
+	m_Levels(nullptr) { }
+
+bool TextureCache::Open(string cachePath, string sourcePath, bool flipped, bool normalMap)
+{
+	Close();
+	if (!m_File.Open(cachePath))
+		return false;
+
+	m_Data = m_File.GetData();
+	m_Size = m_File.GetSize();
+	if (!Validate(sourcePath, flipped, normalMap))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::Validate(string& sourcePath, bool flipped, bool normalMap)
+{
+	if (m_Size < sizeof(Header))
+		return false;
+
+	m_Header = (const Header*)m_Data;
+	if (m_Header->Magic != TextureCacheMagic ||
+		m_Header->Version != Version ||
+		m_Header->Format > (uint32_t)Format::BC5 ||
+		m_Header->Flipped != (uint32_t)flipped ||
+		m_Header->NormalMap != (uint32_t)normalMap)
+		return false;
+
+	uint64_t sourceSize = 0;
+	int64_t sourceWriteTime = 0;
+	if (MappedFile::GetFileInfo(sourcePath, sourceSize, sourceWriteTime) &&
+		(sourceSize != m_Header->SourceSize || sourceWriteTime != m_Header->SourceWriteTime))
+	{
+		// Source was touched, only outdated if the contents changed
+		if (sourceSize != m_Header->SourceSize || MappedFile::HashFile(sourcePath) != m_Header->SourceHash)
+			return false;
+	}
+
+	// Bounds checks, guards against truncated files
+	uint64_t tableEnd = sizeof(Header) + (uint64_t)m_Header->MipCount * sizeof(MipLevel);
+	if (m_Header->MipCount == 0 || tableEnd > m_Size)
+		return false;
+	m_Levels = (const MipLevel*)(m_Data + sizeof(Header));
+
+	for (uint32_t i = 0; i < m_Header->MipCount; i++)
+		if (m_Levels[i].Offset + m_Levels[i].Size > m_Size)
+			return false;
+	return true;
+}
+
+bool TextureCache::Cook(
+	const unsigned char* pixels,
+	unsigned int width,
+	unsigned int height,
+	unsigned int channelCount,
+	string sourcePath,
+	bool flipped,
+	bool normalMap)
+{
+	Close();
+	if (!pixels || width == 0 || height == 0 || channelCount == 0 || channelCount > 4)
+		return false;
+
+	// Normal maps keep X & Y, Z is rebuilt when sampled
+	bool encodeNormals = normalMap && channelCount >= 3;
+
+	Format format = Format::BC1;
+	switch (encodeNormals ? 2 : channelCount)
+	{
+	case 1: format = Format::BC4; break;
+	case 2: format = Format::BC5; break;
+	case 4:
+	{
+		// Fully opaque images lose nothing by dropping alpha
+		size_t pixelCount = (size_t)width * height;
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			if (pixels[i * 4 + 3] != 255)
+			{
+				format = Format::BC3;
+				break;
+			}
+		}
+		break;
+	}
+	}
+
+	// Full mip chain down to 1x1
+	vector<vector<unsigned char>> mips;
+	vector<MipLevel> levels;
+	const unsigned char* levelPixels = pixels;
+	unsigned int levelWidth = width, levelHeight = height;
+	while (true)
+	{
+		MipLevel level = {};
+		level.Width = levelWidth;
+		level.Height = levelHeight;
+		level.Size = (uint64_t)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * GetBlockSize(format);
+		levels.emplace_back(level);
+
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		mips.emplace_back(Downsample(levelPixels, levelWidth, levelHeight, channelCount));
+		if (encodeNormals)
+			RenormaliseNormals(mips.back(), channelCount);
+		levelPixels = mips.back().data();
+		levelWidth = std::max(levelWidth / 2, 1u);
+		levelHeight = std::max(levelHeight / 2, 1u);
+	}
+
+	uint64_t offset = sizeof(Header) + levels.size() * sizeof(MipLevel);
+	for (MipLevel& level : levels)
+	{
+		level.Offset = offset = AlignLevel(offset);
+		offset += level.Size;
+	}
+
+	Header header = {};
+	header.Magic = TextureCacheMagic;
+	header.Version = Version;
+	header.SourceHash = MappedFile::HashFile(sourcePath);
+	header.Format = (uint32_t)format;
+	header.Width = width;
+	header.Height = height;
+	header.MipCount = (uint32_t)levels.size();
+	header.Flipped = flipped ? 1 : 0;
+	header.NormalMap = normalMap ? 1 : 0;
+	MappedFile::GetFileInfo(sourcePath, header.SourceSize, header.SourceWriteTime);
+
+	m_Memory.resize(offset, 0);
+	memcpy(m_Memory.data(), &header, sizeof(Header));
+	memcpy(m_Memory.data() + sizeof(Header), levels.data(), levels.size() * sizeof(MipLevel));
+
+	// stb_dxt builds lookup tables on first use in older versions, avoid racing on them
+	static once_flag dxtInitialised;
+	call_once(dxtInitialised, []()
+	{
+		unsigned char block[64] = {}, output[16];
+		stb_compress_dxt_block(output, block, 0, STB_DXT_NORMAL);
+	});
+
+	// Split every level into jobs of a few block rows
+	struct BlockRows
+	{
+		unsigned int Level;
+		unsigned int FirstRow;
+	};
+	vector<BlockRows> jobs;
+	for (unsigned int i = 0; i < (unsigned int)levels.size(); i++)
+	{
+		unsigned int blockRows = (levels[i].Height + 3) / 4;
+		for (unsigned int row = 0; row < blockRows; row += BlockRowsPerJob)
+			jobs.push_back({ i, row });
+	}
+
+	unsigned int blockSize = GetBlockSize(format);
+	JobSystem::ParallelFor((unsigned int)jobs.size(), [&](unsigned int index)
+	{
+		BlockRows& job = jobs[index];
+		const MipLevel& level = levels[job.Level];
+		const unsigned char* source = job.Level == 0 ? pixels : mips[job.Level - 1].data();
+
+		unsigned int blocksX = (level.Width + 3) / 4;
+		unsigned int blocksY = (level.Height + 3) / 4;
+		unsigned int lastRow = std::min(job.FirstRow + BlockRowsPerJob, blocksY);
+
+		unsigned char block[64];
+		for (unsigned int blockY = job.FirstRow; blockY < lastRow; blockY++)
+		{
+			for (unsigned int blockX = 0; blockX < blocksX; blockX++)
+			{
+				unsigned char* output = m_Memory.data() + level.Offset + ((size_t)blockY * blocksX + blockX) * blockSize;
+				switch (format)
+				{
+				case Format::BC1:
+				case Format::BC3:
+					FetchBlock(source, level.Width, level.Height, channelCount, blockX, blockY, 4, block);
+					stb_compress_dxt_block(output, block, format == Format::BC3 ? 1 : 0, STB_DXT_HIGHQUAL);
+					break;
+				case Format::BC4:
+					FetchBlock(source, level.Width, level.Height, channelCount, blockX, blockY, 1, block);
+					stb_compress_bc4_block(output, block);
+					break;
+				case Format::BC5:
+					FetchBlock(source, level.Width, level.Height, channelCount, blockX, blockY, 2, block);
+					stb_compress_bc5_block(output, block);
+					break;
+				}
+			}
+		}
+	});
+
+	m_Data = m_Memory.data();
+	m_Size = m_Memory.size();
+	m_Header = (const Header*)m_Data;
+	m_Levels = (const MipLevel*)(m_Data + sizeof(Header));
+	return true;
+}
+
+bool TextureCache::Save(string cachePath)
+{
+	if (m_Memory.empty())
+		return false; // Not cooked
+
+	// Written beside the cache & renamed, so a partially written cache is never read
+	string tempPath = cachePath + ".tmp";
+	bool written;
+	{
+		ofstream file(tempPath, ios::out | ios::binary | ios::trunc);
+		file.write((const char*)m_Memory.data(), m_Memory.size());
+		file.close();
+		written = !file.fail();
+	}
+
+	error_code error;
+	if (!written)
+	{
+		Log::Warning("Failed to write texture cache '" + cachePath + "'");
+		fs::remove(tempPath, error);
+		return false;
+	}
+
+	fs::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		Log::Warning("Failed to write texture cache '" + cachePath + "' - " + error.message());
+		fs::remove(tempPath, error);
+		return false;
+	}
+
+	// Read the written file through a mapping, so the cooked copy is not also kept in memory
+	if (!m_File.Open(cachePath))
+		return true;
+	if (m_File.GetSize() != m_Memory.size())
+	{
+		m_File.Close();
+		return true;
+	}
+
+	m_Data = m_File.GetData();
+	m_Size = m_File.GetSize();
+	m_Header = (const Header*)m_Data;
+	m_Levels = (const MipLevel*)(m_Data + sizeof(Header));
+
+	m_Memory.clear();
+	m_Memory.shrink_to_fit();
+	return true;
+}
+
+void TextureCache::Close()
+{
+	m_File.Close();
+	m_Memory.clear();
+	m_Memory.shrink_to_fit();
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Header = nullptr;
+	m_Levels = nullptr;
+}
+
+bool TextureCache::IsOpen() const { return m_Header != nullptr; }
+TextureCache::Format TextureCache::GetFormat() const { return (Format)m_Header->Format; }
+unsigned int TextureCache::GetMipCount() const { return m_Header ? m_Header->MipCount : 0; }
+const TextureCache::MipLevel& TextureCache::GetLevel(unsigned int index) const { return m_Levels[index]; }
+const unsigned char* TextureCache::GetData() const { return m_Data; }
+size_t TextureCache::GetSize() const { return m_Size; }
+
+GLenum TextureCache::GetInternalFormat(Format format)
+{
+	switch (format)
+	{
+	default:
+	case Format::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+	}
+}
+
+unsigned int TextureCache::GetBlockSize(Format format)
+{
+	return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <algorithm>
+#include <Engine/ResourceManager.hpp>
+#include <Engine/Graphics/TextureResidency.hpp>
+
+using namespace std;
+using namespace glm;
+using namespace Engine;
+using namespace Engine::Graphics;
+
+size_t TextureResidency::s_Budget = TextureResidency::DefaultBudget;
+size_t TextureResidency::s_ResidentSize = 0;
+
+void TextureResidency::SetBudget(size_t bytes) { s_Budget = bytes; }
+size_t TextureResidency::GetBudget() { return s_Budget; }
+size_t TextureResidency::GetResidentSize() { return s_ResidentSize; }
+
+void TextureResidency::Request(ResourceID textureID, float screenPixels)
+{
+	Texture* texture = textureID != InvalidResourceID ? ResourceManager::Get<Texture>(textureID) : nullptr;
+	if (!texture || !texture->IsCooked())
+		return;
+
+	// Each level halves resolution
+	float ratio = (float)texture->GetLevelResolution(0) / std::max(screenPixels, 1.0f);
+	unsigned int level = ratio > 1.0f ? (unsigned int)std::floor(std::log2(ratio)) : 0;
+	level = std::min(level, texture->GetMipCount() - 1);
+
+	// Finest level requested this frame
+	if (texture->m_RequestedFrame != Texture::s_Frame || level < texture->m_RequestedLevel)
+		texture->m_RequestedLevel = level;
+	texture->m_RequestedFrame = Texture::s_Frame;
+}
+
+void TextureResidency::Request(Material& material, float screenPixels)
+{
+	// Tiled textures repeat across the surface, each repetition covers fewer pixels
+	screenPixels /= std::max(std::max(material.TextureCoordinateScale.x, material.TextureCoordinateScale.y), 1.0f);
+
+	Request(material.AlbedoMap, screenPixels);
+	Request(material.NormalMap, screenPixels);
+	Request(material.RoughnessMap, screenPixels);
+	Request(material.MetalnessMap, screenPixels);
+	Request(material.AmbientOcclusionMap, screenPixels);
+}
+
+void TextureResidency::Update()
+{
+	struct Candidate
+	{
+		Texture* Target;
+		unsigned int Level;
+		unsigned int MinLevel;
+		size_t Size;
+		bool Unused;
+		bool Evict;
+	};
+
+	unsigned int frame = Texture::s_Frame;
+	vector<Candidate> candidates;
+	size_t totalSize = 0;
+	for (Texture* texture : Texture::s_Textures)
+	{
+		// Textures being streamed keep their current levels until finished
+		if (texture->m_ID == GL_INVALID_VALUE || texture->m_Streaming)
+		{
+			totalSize += texture->m_ResidentSize;
+			continue;
+		}
+
+		Candidate candidate = {};
+		candidate.Target = texture;
+		candidate.Level = candidate.MinLevel = texture->m_ResidentLevel;
+		candidate.Unused = frame - texture->m_LastUsedFrame > UnusedFrames;
+
+		if (texture->IsCooked())
+		{
+			// Finer levels are only streamed in when requested recently,
+			// textures bound without requesting a level want full resolution
+			if (texture->m_RequestedFrame + UnusedFrames >= frame)
+				candidate.Level = std::min(candidate.Level, texture->m_RequestedLevel);
+			else if (!candidate.Unused)
+				candidate.Level = 0;
+
+			unsigned int mipCount = texture->GetMipCount();
+			candidate.MinLevel = 0;
+			while (candidate.MinLevel + 1 < mipCount && texture->GetLevelResolution(candidate.MinLevel) > MinResolution)
+				candidate.MinLevel++;
+			candidate.MinLevel = std::max(candidate.MinLevel, candidate.Level);
+		}
+
+		candidate.Size = texture->GetSize(candidate.Level);
+		totalSize += candidate.Size;
+		candidates.emplace_back(candidate);
+	}
+
+	if (totalSize > s_Budget)
+	{
+		// Reduce least recently used textures first
+		sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+		{
+			return a.Target->m_LastUsedFrame < b.Target->m_LastUsedFrame;
+		});
+
+		for (Candidate& candidate : candidates)
+		{
+			while (totalSize > s_Budget && candidate.Level < candidate.MinLevel)
+			{
+				size_t size = candidate.Target->GetSize(++candidate.Level);
+				totalSize -= candidate.Size - size;
+				candidate.Size = size;
+			}
+
+			if (totalSize > s_Budget && candidate.Unused)
+			{
+				totalSize -= candidate.Size;
+				candidate.Size = 0;
+				candidate.Evict = true;
+			}
+
+			if (totalSize <= s_Budget)
+				break;
+		}
+	}
+
+	for (Candidate& candidate : candidates)
+	{
+		if (candidate.Evict)
+			candidate.Target->Evict();
+		else if (candidate.Level != candidate.Target->m_ResidentLevel)
+			candidate.Target->BeginUpload(candidate.Level);
+	}
+
+	s_ResidentSize = totalSize;
+}
\ No newline at end of file
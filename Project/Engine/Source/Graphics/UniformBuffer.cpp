@@ -0,0 +1,50 @@
+#include <glad/glad.h>
+#include <string>
+#include <Engine/Log.hpp>
+#include <Engine/Graphics/UniformBuffer.hpp>
+
+using namespace Engine;
+using namespace Engine::Graphics;
+
+UniformBuffer::UniformBuffer(UniformBlockBinding binding, unsigned int size) : m_ID(GL_INVALID_VALUE), m_Size(size), m_Binding(binding) { }
+
+UniformBuffer::~UniformBuffer()
+{
+	if (m_ID != GL_INVALID_VALUE)
+		glDeleteBuffers(1, &m_ID);
+}
+
+unsigned int UniformBuffer::GetID() { return m_ID; }
+unsigned int UniformBuffer::GetSize() { return m_Size; }
+UniformBlockBinding UniformBuffer::GetBinding() { return m_Binding; }
+
+void UniformBuffer::Create()
+{
+	glGenBuffers(1, &m_ID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	glBufferData(GL_UNIFORM_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+	if (offset + size > m_Size)
+	{
+		Log::Warning("Tried to write " + std::to_string(size) + " bytes past the end of uniform buffer");
+		return;
+	}
+
+	if (m_ID == GL_INVALID_VALUE)
+		Create();
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::Bind()
+{
+	if (m_ID == GL_INVALID_VALUE)
+		Create();
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, (GLuint)m_Binding, m_ID);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include <Engine/Jobs/JobHandle.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+
+using namespace std;
+using namespace Engine::Jobs;
+
+JobHandle::JobHandle() : m_Remaining(nullptr) { }
+
+bool JobHandle::IsComplete() const { return !m_Remaining || m_Remaining->load() <= 0; }
+
+void JobHandle::Wait() const
+{
+	if (IsComplete())
+		return;
+
+	if (JobSystem::s_Instance)
+		JobSystem::s_Instance->Wait(m_Remaining);
+	else
+		while (!IsComplete())
+			this_thread::yield();
+}
\ No newline at end of file
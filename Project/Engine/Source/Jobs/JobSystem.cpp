@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <Engine/Log.hpp>
+#include <Engine/Jobs/JobSystem.hpp>
+
+using namespace std;
+using namespace Engine;
+using namespace Engine::Jobs;
+
+JobSystem* JobSystem::s_Instance = nullptr;
+
+JobSystem::JobSystem(unsigned int workerCount) : m_Running(true)
+{
+	if (workerCount == 0)
+		workerCount = std::max(thread::hardware_concurrency(), 2u) - 1;
+
+	m_Workers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(thread(&JobSystem::WorkerLoop, this));
+
+	Log::Debug("Created job system with " + to_string(workerCount) + " worker threads");
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		unique_lock lock(m_QueueMutex);
+		m_Running = false;
+	}
+	m_QueueCondition.notify_all();
+
+	for (thread& worker : m_Workers)
+		if (worker.joinable())
+			worker.join();
+	m_Workers.clear();
+
+	if (s_Instance == this)
+		s_Instance = nullptr;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			unique_lock lock(m_QueueMutex);
+			m_QueueCondition.wait(lock, [&]() { return !m_Running || !m_Queue.empty(); });
+
+			// Finish remaining jobs before exiting
+			if (m_Queue.empty())
+				return;
+
+			job = std::move(m_Queue.front());
+			m_Queue.pop_front();
+		}
+
+		Execute(job);
+	}
+}
+
+void JobSystem::Execute(Job& job)
+{
+	job.Function();
+	if (job.Remaining->fetch_sub(1) != 1)
+		return;
+
+	// Lock ensures a waiting thread is either not yet checking the count, or already waiting to be notified
+	{
+		unique_lock lock(m_QueueMutex);
+	}
+	m_CompleteCondition.notify_all();
+}
+
+bool JobSystem::ExecuteNext(const shared_ptr<atomic_int>& remaining)
+{
+	Job job;
+	{
+		unique_lock lock(m_QueueMutex);
+		auto it = find_if(m_Queue.begin(), m_Queue.end(), [&](Job& queued) { return queued.Remaining == remaining; });
+		if (it == m_Queue.end())
+			return false;
+
+		job = std::move(*it);
+		m_Queue.erase(it);
+	}
+
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Wait(const shared_ptr<atomic_int>& remaining)
+{
+	// Only this handle's jobs are run inline, so the caller never stalls behind unrelated work
+	while (remaining->load() > 0 && ExecuteNext(remaining));
+
+	unique_lock lock(m_QueueMutex);
+	m_CompleteCondition.wait(lock, [&]() { return remaining->load() <= 0; });
+}
+
+JobHandle JobSystem::Submit(JobFunction job)
+{
+	JobHandle handle;
+	if (!s_Instance || s_Instance->m_Workers.empty())
+	{
+		// No workers available, execute immediately
+		job();
+		return handle;
+	}
+
+	handle.m_Remaining = make_shared<atomic_int>(1);
+	{
+		unique_lock lock(s_Instance->m_QueueMutex);
+		s_Instance->m_Queue.emplace_back(Job { job, handle.m_Remaining });
+	}
+	s_Instance->m_QueueCondition.notify_one();
+	return handle;
+}
+
+void JobSystem::ParallelFor(unsigned int count, function<void(unsigned int index)> job, unsigned int batchSize)
+{
+	if (count == 0)
+		return;
+	batchSize = std::max(batchSize, 1u);
+
+	unsigned int batchCount = (count + batchSize - 1) / batchSize;
+	if (!s_Instance || s_Instance->m_Workers.empty() || batchCount == 1)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	JobHandle handle;
+	handle.m_Remaining = make_shared<atomic_int>(batchCount);
+	{
+		unique_lock lock(s_Instance->m_QueueMutex);
+		for (unsigned int batch = 0; batch < batchCount; batch++)
+		{
+			unsigned int start = batch * batchSize;
+			unsigned int end = std::min(start + batchSize, count);
+			s_Instance->m_Queue.emplace_back(Job
+			{
+				[=, &job]()
+				{
+					for (unsigned int i = start; i < end; i++)
+						job(i);
+				},
+				handle.m_Remaining
+			});
+		}
+	}
+	s_Instance->m_QueueCondition.notify_all();
+
+	handle.Wait();
+}
+
+unsigned int JobSystem::GetWorkerCount() { return s_Instance ? (unsigned int)s_Instance->m_Workers.size() : 0; }
\ No newline at end of file
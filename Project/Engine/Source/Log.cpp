@@ -13,44 +13,64 @@ int Log::s_LogLevel = (int)Log::LogLevel::Info |
 						(int)Log::LogLevel::Error |
 						(int)Log::LogLevel::Exception;
 
+mutex Log::s_OutputMutex;
+
 void Log::Debug(const char* msg)
 {
 	if (s_LogLevel & (int)Log::LogLevel::Debug)
+	{
+		lock_guard lock(s_OutputMutex);
 		cout << termcolor::green << "[DEBUG] " << msg << endl;
+	}
 }
 void Log::Debug(string msg) { Log::Debug(msg.c_str()); }
 
 void Log::Info(const char* msg)
 {
 	if (s_LogLevel & (int)Log::LogLevel::Info)
+	{
+		lock_guard lock(s_OutputMutex);
 		cout << termcolor::white << "[INFO] " << msg << endl;
+	}
 }
 void Log::Info(string msg) { Log::Info(msg.c_str()); }
 
 void Log::Warning(const char* msg)
 {
 	if (s_LogLevel & (int)Log::LogLevel::Warning)
+	{
+		lock_guard lock(s_OutputMutex);
 		cout << termcolor::yellow << "[WARN] " << msg << endl;
+	}
 }
 void Log::Warning(string msg) { Log::Warning(msg.c_str()); }
 
 void Log::Error(const char* msg)
 {
 	if (s_LogLevel & (int)Log::LogLevel::Error)
+	{
+		lock_guard lock(s_OutputMutex);
 		cout << termcolor::red << "[ERROR] " << msg << endl;
+	}
 }
 void Log::Error(string msg) { Log::Error(msg.c_str()); }
 
 void Log::Exception(const char* msg, exception& ex)
 {
 	if (s_LogLevel & (int)Log::LogLevel::Exception)
+	{
+		lock_guard lock(s_OutputMutex);
 		cout << termcolor::bright_red << "[EXCEPTION] " << msg << endl << endl << "\t" << ex.what() << endl << endl;
+	}
 }
 void Log::Exception(string msg, exception& ex) { Log::Exception(msg.c_str(), ex); }
 
 void Log::Pause(const char* msg)
 {
-	cout << termcolor::grey << msg << endl;
+	{
+		lock_guard lock(s_OutputMutex);
+		cout << termcolor::grey << msg << endl;
+	}
 	(void)getchar(); // cast to void for discarding return value
 }
 void Log::Pause(string msg) { Log::Pause(msg.c_str()); }
@@ -59,8 +79,11 @@ void Log::Assert(bool value, const char* msg)
 {
 	if (value)
 		return;
-	cout << termcolor::red << msg << endl;
-	cout << endl << endl << "Press any key to exit..." << endl;
+	{
+		lock_guard lock(s_OutputMutex);
+		cout << termcolor::red << msg << endl;
+		cout << endl << endl << "Press any key to exit..." << endl;
+	}
 	(void)getchar();
 
 	// Exit application
@@ -0,0 +1,124 @@
+#include <filesystem>
+#include <Engine/Log.hpp>
+#include <Engine/MappedFile.hpp>
+
+#ifdef _WIN32
+// CreateFile, CreateFileMapping, MapViewOfFile
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+// open, mmap, munmap
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace Engine;
+
+namespace fs = std::filesystem;
+
+const uint64_t FNVOffsetBasis = 0xCBF29CE484222325ull;
+const uint64_t FNVPrime = 0x100000001B3ull;
+
+#if _WIN32
+MappedFile::MappedFile() : m_Data(nullptr), m_Size(0), m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr) { }
+#else
+MappedFile::MappedFile() : m_Data(nullptr), m_Size(0), m_File(-1) { }
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(string path)
+{
+	Close();
+
+#if _WIN32
+	m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size = {};
+	GetFileSizeEx(m_File, &size);
+	m_Size = (size_t)size.QuadPart;
+
+	// Empty files cannot be mapped
+	if (m_Size > 0)
+		m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_Mapping)
+		m_Data = (const unsigned char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File < 0)
+		return false;
+
+	struct stat info = {};
+	fstat(m_File, &info);
+	m_Size = (size_t)info.st_size;
+
+	// Empty files cannot be mapped
+	if (m_Size > 0)
+	{
+		void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+		m_Data = data == MAP_FAILED ? nullptr : (const unsigned char*)data;
+	}
+#endif
+
+	if (!m_Data)
+	{
+		Log::Warning("Failed to map '" + path + "' into memory");
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#if _WIN32
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+
+	m_Mapping = nullptr;
+	m_File = INVALID_HANDLE_VALUE;
+#else
+	if (m_Data)
+		munmap((void*)m_Data, m_Size);
+	if (m_File >= 0)
+		close(m_File);
+
+	m_File = -1;
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+bool MappedFile::GetFileInfo(string path, uint64_t& size, int64_t& writeTime)
+{
+	error_code error;
+	size = (uint64_t)fs::file_size(path, error);
+	if (error)
+		return false;
+
+	writeTime = (int64_t)fs::last_write_time(path, error).time_since_epoch().count();
+	return !error;
+}
+
+uint64_t MappedFile::HashFile(string path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return 0;
+
+	uint64_t hash = FNVOffsetBasis;
+	const unsigned char* data = file.GetData();
+	for (size_t i = 0; i < file.GetSize(); i++)
+		hash = (hash ^ data[i]) * FNVPrime;
+	return hash;
+}
\ No newline at end of file
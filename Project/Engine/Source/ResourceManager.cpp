@@ -33,7 +33,7 @@ void ResourceManager::_Unload(ResourceID id)
 		return;
 	}
 
-	delete it->second.Data;
+	it->second.Deleter(it->second.Data);
 	m_Instances.erase(it);
 }
 
@@ -53,7 +53,7 @@ void ResourceManager::_Unload(string& name)
 void ResourceManager::_UnloadAll()
 {
 	for (auto& pair : m_Instances)
-		delete pair.second.Data;
+		pair.second.Deleter(pair.second.Data);
 	m_Instances.clear();
 }
 
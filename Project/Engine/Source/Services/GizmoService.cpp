@@ -1,5 +1,6 @@
 #include <Engine/Application.hpp>
 #include <Engine/ResourceManager.hpp>
+#include <Engine/Graphics/Gizmos.hpp>
 #include <Engine/Graphics/Renderer.hpp>
 #include <Engine/Graphics/Framebuffer.hpp>
 #include <Engine/Services/GizmoService.hpp>
@@ -14,7 +15,8 @@ void GizmoService::OnStart()
 		return; // Already initialized
 
 	FramebufferSpec spec;
-	spec.Attachments = { { TextureFormat::RGBA16F, TexturePixelType::Float }, TextureFormat::Depth };
+	// Depth format must match the pipeline's main mesh pass to be blitted
+	spec.Attachments = { { TextureFormat::RGBA16F, TexturePixelType::Float }, { TextureFormat::Depth24, TexturePixelType::Float } };
 	spec.Resolution = Renderer::GetResolution();
 	m_Pass.Name = "Gizmos";
 	m_Pass.Pass = new Framebuffer(spec);
@@ -68,12 +70,14 @@ void GizmoService::DrawCallback(Framebuffer* previous)
 	glEnable(GL_DEPTH_TEST);
 
 	Renderer::ClearDrawQueue(); // Incase any leftover draw calls
+	Gizmos::ResetMaterials();
 
 	auto& services = Application::GetAllServices();
 	for (Service* service : services)
 		service->OnDrawGizmos();
 
 	Renderer::Draw();
+	Gizmos::DrawLines();
 
 	glDisable(GL_BLEND);
 	glDisable(GL_DEPTH_TEST);
@@ -41,6 +41,7 @@ workspace "Graphics Engine"
 
 	group "Applications"
 		include "../Applications/Base"
+		include "../Applications/EnvironmentBaker"
 	group "Applications/Services"
 		include "../Applications/Demo"
 		include "../Applications/BasicGame"